@@ -0,0 +1,103 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "common.h"
+#include "dict.h"
+
+/// @brief Declaration of a bounded cache. Holds up to a fixed number of entries and optionally of bytes, and evicts
+/// to make room when full. Get, put and evict are O(1). Keys are any dict key type.
+/// Values are client pointers like dict's. When they leave the cache by eviction, replacement or clear they go to
+/// the evict callback if there is one, else they are freed. cache_Remove() hands them back.
+/// Not thread safe.
+
+
+//---------------- Public API ----------------------//
+
+/// Opaque cache object.
+typedef struct cache cache_t;
+
+/// Which entry goes when room is needed.
+typedef enum
+{
+    CACHE_LRU,      ///> The least recently used. Every hit moves the entry to the front of the recency order.
+    CACHE_CLOCK,    ///> Close to LRU. A hit just sets a flag on the entry, eviction sweeps past flagged entries
+                    ///> clearing the flags and takes the first one without. Cheaper hits, no list to update.
+} cachePolicy_t;
+
+/// Called for each value that leaves the cache other than by cache_Remove().
+/// @param k The key. Only valid during the call.
+/// @param v The value. Now the client's.
+/// @param ctx From cache_SetEvict().
+typedef void (*cache_EvictFunc_t)(key_t k, void* v, void* ctx);
+
+/// What cache_GetStats() gives.
+typedef struct
+{
+    int count;                      ///> Number of entries.
+    size_t bytes;                   ///> Sum of the sizes given to cache_Put().
+    unsigned long long hits;        ///> cache_Get() that found it.
+    unsigned long long misses;      ///> cache_Get() that didn't.
+    unsigned long long evictions;   ///> Entries pushed out to make room.
+} cache_stats_t;
+
+/// Create an empty cache.
+/// @param kt Key type.
+/// @param max_entries Most entries it holds. Room for them is allocated now.
+/// @param max_bytes Most bytes it holds, see cache_Put() | 0 for no limit.
+/// @param policy Which to evict.
+/// @return The opaque pointer used in all functions | BAD_PTR.
+cache_t* cache_Create(keyType_t kt, int max_entries, size_t max_bytes, cachePolicy_t policy);
+
+/// Frees all values (see cache_SetEvict()), frees the cache struct.
+/// @param c The cache opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int cache_Destroy(cache_t* c);
+
+/// Frees all values (see cache_SetEvict()). Stats are kept.
+/// @param c The cache opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int cache_Clear(cache_t* c);
+
+/// Number of entries.
+/// @param c The cache opaque pointer.
+/// @return The count | RS_ERR.
+int cache_Count(cache_t* c);
+
+/// Give values that leave the cache to the client instead of freeing them.
+/// @param c The cache opaque pointer.
+/// @param func Called for each | NULL to free them.
+/// @param ctx Passed to func.
+/// @return RS_PASS | RS_ERR.
+int cache_SetEvict(cache_t* c, cache_EvictFunc_t func, void* ctx);
+
+/// Look up an entry and count it as used.
+/// @param c The cache opaque pointer.
+/// @param k The key.
+/// @param v Where to put the value. The cache still owns it and it may be gone after the next cache_Put().
+/// @return RS_PASS | RS_FAIL if not there | RS_ERR.
+int cache_Get(cache_t* c, key_t k, void** v);
+
+/// Add or replace an entry, evicting others if that is needed to stay in the limits.
+/// @param c The cache opaque pointer.
+/// @param k The key. Copied.
+/// @param v The value. The cache takes ownership.
+/// @param size What it counts for against max_bytes, in whatever unit the client likes.
+/// @return RS_PASS | RS_FAIL if size is over max_bytes, the client keeps v | RS_ERR.
+int cache_Put(cache_t* c, key_t k, void* v, size_t size);
+
+/// Remove an entry.
+/// @param c The cache opaque pointer.
+/// @param k The key.
+/// @param v Where to put the value. Client takes ownership of it now!
+/// @return RS_PASS | RS_FAIL if not there | RS_ERR.
+int cache_Remove(cache_t* c, key_t k, void** v);
+
+/// Get the counters.
+/// @param c The cache opaque pointer.
+/// @param stats Where to put them.
+/// @return RS_PASS | RS_ERR.
+int cache_GetStats(cache_t* c, cache_stats_t* stats);
+
+#endif // CACHE_H
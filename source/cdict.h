@@ -0,0 +1,58 @@
+#ifndef CDICT_H
+#define CDICT_H
+
+#include <stddef.h>
+#include "dict.h"
+
+/// @brief Declaration of a dictionary that many threads can use at once.
+/// Keys are split over stripes, each with its own table and lock. Writers lock only their stripe.
+/// Readers never lock. They use the stripe sequence number to detect a concurrent write and try again.
+/// Values are fixed size and copied in and out so no pointers into the table ever reach the client.
+/// Memory from old tables and removed string keys is kept until destroy, because a reader could still
+/// be looking at it, so this suits dicts that mostly grow and get updated in place.
+
+
+//---------------- Public API ----------------------//
+
+/// Opaque concurrent dict object.
+typedef struct cdict cdict_t;
+
+/// Create a concurrent dict.
+/// @param kt Key type, KEY_INT or KEY_STRING.
+/// @param value_size Bytes per value.
+/// @param num_stripes Number of independently locked parts, rounded up to a power of 2. 0 for the default.
+///                    More than the number of writing threads keeps them from waiting on each other.
+/// @return The opaque pointer used in all functions | BAD_PTR.
+cdict_t* cdict_Create(keyType_t kt, size_t value_size, int num_stripes);
+
+/// Frees everything. No other thread may be using it.
+/// @param cd The cdict opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int cdict_Destroy(cdict_t* cd);
+
+/// Number of entries. Only a snapshot if other threads are writing.
+/// @param cd The cdict opaque pointer.
+/// @return The count | RS_ERR.
+int cdict_Count(cdict_t* cd);
+
+/// Add or replace a value. Locks the key's stripe.
+/// @param cd The cdict opaque pointer.
+/// @param k The key.
+/// @param v The value, value_size bytes copied in.
+/// @return RS_PASS | RS_ERR.
+int cdict_Set(cdict_t* cd, key_t k, const void* v);
+
+/// Get a copy of a value. Never locks.
+/// @param cd The cdict opaque pointer.
+/// @param k The key.
+/// @param v Where to copy the value, value_size bytes. Contents undefined if not found.
+/// @return RS_PASS | RS_FAIL | RS_ERR.
+int cdict_Get(cdict_t* cd, key_t k, void* v);
+
+/// Remove an entry. Locks the key's stripe.
+/// @param cd The cdict opaque pointer.
+/// @param k The key.
+/// @return RS_PASS | RS_FAIL | RS_ERR.
+int cdict_Remove(cdict_t* cd, key_t k);
+
+#endif // CDICT_H
@@ -69,6 +69,14 @@ void common_MemFail(int line, const char* file);
     char* var = (char*)calloc(len + 1, sizeof(char));  \
     _CREATE(var);
 
+/// Make a zeroed array of typed things. Client is responsible for FREE().
+/// @param var Variable name.
+/// @param type Element type.
+/// @param num Number of elements.
+#define CREATE_ARR(var, type, num) \
+    type* var = (type*)calloc(num, sizeof(type)); \
+    _CREATE(var);
+
 /// Free the item.
 /// @param var Variable name.
 #define FREE(var) \
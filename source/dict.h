@@ -2,6 +2,8 @@
 #ifndef DICT_H
 #define DICT_H
 
+#include <stddef.h>
+#include <stdbool.h>
 #include "list.h"
 
 /// @brief Declaration of a rudimentary dictionary thing.
@@ -16,16 +18,125 @@
 typedef struct dict dict_t;
 
 /// Key type per dictionary.
-typedef enum { KEY_INT, KEY_STRING } keyType_t;
+/// KEY_U64 is for ids and such that don't fit an int. KEY_BYTES is for binary keys like UUIDs or packed tuples,
+/// compared with memcmp() so they may contain zeros. Only dict takes them, not the other containers.
+typedef enum { KEY_INT, KEY_STRING, KEY_U64, KEY_BYTES } keyType_t;
 
-/// Key for each keyType_t.
-typedef union { int ki; const char* ks; } key_t;
+/// KEY_BYTES key.
+typedef struct
+{
+    const void* data;   ///> The bytes.
+    size_t len;         ///> How many. Up to UINT_MAX, longer keys are RS_ERR.
+} kbytes_t;
 
-/// Create a dict.
+/// Key for each keyType_t. KEY_BYTES keys are passed by pointer so the union stays 8 bytes for the containers
+/// that keep arrays of them. dict only reads it during the call.
+typedef union { int ki; const char* ks; unsigned long long ku; const kbytes_t* kb; } key_t;
+
+/// Makes a hash from the bytes of a key. String keys are hashed without the terminator. KEY_U64 keys don't
+/// use it with dict_HashFast(), they get a cheaper integer mix.
+/// @param data Key bytes.
+/// @param len Number of bytes.
+/// @param seed Per dict seed. See dict_SetHash().
+/// @return Full 64 bit hash.
+typedef unsigned long long (*dict_HashFunc_t)(const void* data, size_t len, unsigned long long seed);
+
+/// Storage options for dict_CreateEx(). Combine with |.
+typedef enum
+{
+    DICT_CHAINED = 0,       ///> Default. Each bin is a chain of separately allocated entries.
+    DICT_OPEN    = 1 << 0,  ///> Open addressing. Entries and their hashes live in flat arrays, linear probing.
+    DICT_GROUP   = 1 << 1,  ///> DICT_OPEN plus a byte of hash tag per slot. Lookups compare 16 tags at a time
+                            ///> (SSE2/NEON, plain C elsewhere) and only look at keys whose tag matches.
+    DICT_INCREMENTAL = 1 << 2,  ///> DICT_CHAINED only. Resizing moves a few bins per dict_Set(), dict_GetOrInsert()
+                                ///> and dict_Remove() instead of all at once, so no single call stalls. Lookups check
+                                ///> both tables meanwhile.
+    DICT_ARENA   = 1 << 3,  ///> KEY_STRING and KEY_BYTES only. Long keys are copied into large shared blocks instead
+                            ///> of one malloc each and all released together by dict_Clear() or dict_Destroy(). Space
+                            ///> of removed keys is not reused until then, so best for dicts that mostly grow.
+    DICT_FILTER  = 1 << 4,  ///> Bloom filter in front of the table. Most lookups of keys that aren't there stop after one
+                            ///> cache line of filter, without touching the table or comparing keys. About 10 bits per
+                            ///> entry. Worth it when most lookups miss.
+} dictOpt_t;
+
+/// Number of probe lengths dict_GetStats() counts separately. Longer ones go in the last.
+#define DICT_STATS_HIST 16
+
+/// Most threads dict_SetMany() and dict_LoadFile() use. Asking for more gets this many.
+#define DICT_MAX_THREADS 256
+
+/// What dict_GetStats() reports. A probe is one entry looked at while finding a key: its position in the chain,
+/// or for open addressing one more than its distance from the home slot.
+typedef struct
+{
+    int count;              ///> Number of entries.
+    unsigned int num_bins;  ///> Bins or slots.
+    double load;            ///> count / num_bins.
+    unsigned int max_probe; ///> Most probes to find any entry. The longest chain for DICT_CHAINED.
+    double mean_probe;      ///> Average probes to find an entry that is there.
+    unsigned int probe_hist[DICT_STATS_HIST]; ///> Number of entries found in 1, 2, ... probes.
+    size_t bytes;           ///> Memory used by the table, entries and keys, not counting values that are client
+                            ///> pointers or allocator overhead.
+    unsigned int resizes;   ///> Times the table has grown or shrunk.
+    size_t filter_bytes;    ///> DICT_FILTER: memory used by the filter. 0 without one.
+    double filter_fp_rate;  ///> DICT_FILTER: chance that a key that isn't there gets past the filter, estimated from
+                            ///> how full it is. Removed keys stay in it until it is rebuilt by a resize or by enough removes.
+} dict_stats_t;
+
+/// Create a dict with the default starting size. It grows as needed.
 /// @param kt Key type.
 /// @return The dictionary opaque pointer used in all functions | BAD_PTR. 
 dict_t* dict_Create(keyType_t kt);
 
+/// Create a dict sized for an expected number of entries. It still grows past that as needed
+/// and dict_Clear() shrinks it back to this size.
+/// @param kt Key type.
+/// @param capacity Expected number of entries.
+/// @return The dictionary opaque pointer used in all functions | BAD_PTR. 
+dict_t* dict_CreateWithCapacity(keyType_t kt, int capacity);
+
+/// Create a dict with a specific storage layout. Behavior is the same for all, only speed and space differ.
+/// @param kt Key type.
+/// @param capacity Expected number of entries.
+/// @param opts dictOpt_t flags.
+/// @return The dictionary opaque pointer used in all functions | BAD_PTR. 
+dict_t* dict_CreateEx(keyType_t kt, int capacity, unsigned int opts);
+
+/// Create a dict that stores fixed size values itself instead of client pointers. dict_Set() copies value_size
+/// bytes in and the client keeps its own copy. dict_Get(), dict_IterNext() and dict_GetOrInsert() give a pointer
+/// to the stored value, which is 8 byte aligned and only valid until the next change to the dict. dict_Remove()
+/// and dict_IterRemove() discard the value and return NULL. Uses DICT_OPEN.
+/// @param kt Key type.
+/// @param value_size Bytes per value.
+/// @return The dictionary opaque pointer used in all functions | BAD_PTR. 
+dict_t* dict_CreateInline(keyType_t kt, size_t value_size);
+
+/// Like dict_CreateInline() with a choice of size and layout.
+/// @param kt Key type.
+/// @param capacity Expected number of entries.
+/// @param opts dictOpt_t flags.
+/// @param value_size Bytes per value.
+/// @return The dictionary opaque pointer used in all functions | BAD_PTR. 
+dict_t* dict_CreateInlineEx(keyType_t kt, int capacity, unsigned int opts, size_t value_size);
+
+/// Bytes of memory dict_InitStatic() needs.
+/// @param max_entries Most entries it will hold.
+/// @param key_bytes Space for string keys of DICT_INLINE_KEY (16) chars or more, each plus a terminator.
+/// @return Size | 0 if max_entries is not positive.
+size_t dict_StaticSize(int max_entries, size_t key_bytes);
+
+/// Make a dict in client memory. It never allocates, frees or resizes, so it suits targets without a heap.
+/// Open addressing at no more than 50% load, so lookups take a predictable few probes. dict_Set() and
+/// dict_GetOrInsert() return RS_FAIL when max_entries are in or the key space is used up. Removed keys don't
+/// give their key space back until dict_Clear(). Values are client pointers that are never freed by the dict.
+/// dict_Destroy() just clears. dict_GetKeys() allocates so shouldn't be used.
+/// @param buf Client memory, 8 byte aligned. Must stay put for the life of the dict.
+/// @param bytes Size of buf, see dict_StaticSize(). What is left after the table holds long keys.
+/// @param kt Key type.
+/// @param max_entries Most entries it will hold.
+/// @return The dictionary opaque pointer, which is buf | BAD_PTR if buf is too small.
+dict_t* dict_InitStatic(void* buf, size_t bytes, keyType_t kt, int max_entries);
+
 /// Deletes all nodes and associated data pointers.
 /// @param d The dictionary opaque pointer.
 /// @return RS_PASS | RS_ERR.
@@ -36,16 +147,49 @@ int dict_Clear(dict_t* d);
 /// @return RS_PASS | RS_ERR.
 int dict_Destroy(dict_t* d);
 
+/// Make a dict read-only, shrunk to fit what is in it. From then on dict_Set(), dict_GetOrInsert(), dict_Remove(),
+/// dict_IterRemove(), dict_Clear() and dict_SetHash() return RS_ERR. dict_Get(), dict_GetMany() and dict_Count()
+/// change nothing so any number of threads can use them at once. The iterator has one cursor per dict so
+/// is for one thread at a time. dict_Destroy() still works.
+/// @param d The dictionary opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int dict_Freeze(dict_t* d);
+
 /// Size of the dict.
 /// @param l The dict opaque pointer.
 /// @return The size | RS_ERR.
 int dict_Count(dict_t* l);
 
-/// Set a value using a key. Also used to remove.
+/// Get information about the dict for tuning and monitoring, like how well the hash spreads the keys and
+/// how much memory it takes. Takes time in proportion to the size. Changes nothing so is fine for frozen dicts.
+/// @param d The dict opaque pointer.
+/// @param stats Where to put it.
+/// @return RS_PASS | RS_ERR.
+int dict_GetStats(dict_t* d, dict_stats_t* stats);
+
+/// Change the hash function. Only allowed while the dict is empty.
+/// Use dict_HashSip with a random seed if the keys come from somewhere you don't trust.
+/// @param d The dictionary opaque pointer.
+/// @param hash_func Built in or your own.
+/// @param seed Passed to hash_func on every call.
+/// @return RS_PASS | RS_ERR.
+int dict_SetHash(dict_t* d, dict_HashFunc_t hash_func, unsigned long long seed);
+
+/// Default hash function. Fast with good distribution (xxHash64 style) but not keyed, so someone who
+/// knows it can pick keys that collide.
+/// @see dict_HashFunc_t.
+unsigned long long dict_HashFast(const void* data, size_t len, unsigned long long seed);
+
+/// SipHash-2-4 keyed by the seed. Slower than dict_HashFast but keys can't be chosen to collide
+/// without knowing the seed (hash flooding).
+/// @see dict_HashFunc_t.
+unsigned long long dict_HashSip(const void* data, size_t len, unsigned long long seed);
+
+/// Set a value using a key.
 /// @param d The dictionary opaque pointer.
 /// @param k The key.
 /// @param v The value. NOTE value can't contain pointers.
-/// @return RS_PASS | RS_ERR.
+/// @return RS_PASS | RS_ERR | RS_FAIL (static dict full).
 int dict_Set(dict_t* d, key_t k, void* v);
 
 /// Get a value using a key.
@@ -55,15 +199,113 @@ int dict_Set(dict_t* d, key_t k, void* v);
 /// @return RS_PASS | RS_FAIL | RS_ERR.
 int dict_Get(dict_t* d, key_t k, void** v);
 
-/// Get a list of all key_t. NOTE - client must destroy the returned list.
+/// Get the values of many keys at once. Faster than dict_Get() one by one on big tables because the memory
+/// for a batch of keys is fetched in parallel rather than waiting for each in turn.
+/// @param d The dictionary opaque pointer.
+/// @param keys The keys.
+/// @param n Number of keys.
+/// @param values Where to put the associated data, n of them. NULL for keys not found.
+/// @param status Where to put RS_PASS | RS_FAIL for each key, n of them.
+/// @return RS_PASS | RS_ERR.
+int dict_GetMany(dict_t* d, const key_t* keys, int n, void** values, int* status);
+
+/// Look up a key and add it if it isn't there, with one probe. For in place updates like counting.
+/// @param d The dictionary opaque pointer.
+/// @param k The key.
+/// @param slot Where to put a pointer to the stored value pointer. For a new entry it points to NULL and the
+///             client must store a value there, which the dict then owns. Only valid until the next change to the dict.
+///             For inline dicts it points to the value itself instead, zeroed if new. Cast it to the value type.
+/// @param inserted Set to true if the entry is new.
+/// @return RS_PASS | RS_ERR | RS_FAIL (static dict full).
+int dict_GetOrInsert(dict_t* d, key_t k, void*** slot, bool* inserted);
+
+/// Set many entries at once, for building big dicts. Same result as dict_Set() on each in order, but the keys are
+/// hashed by several threads, the table is sized once for all of them, and each thread then fills its own range of
+/// bins so nothing is rehashed or locked. With DICT_ARENA each thread copies keys into chunks of its own.
+/// Best with DICT_OPEN or DICT_GROUP and inline values, where entries need no allocation of their own.
+/// This and dict_LoadFile() are in dict_bulk.c, which needs pthreads.
+/// @param d The dictionary opaque pointer. Not static.
+/// @param keys The keys.
+/// @param n Number of keys.
+/// @param values The values, n of them, as for dict_Set(). None may be NULL.
+/// @param num_threads How many threads to use, including the caller's. At most DICT_MAX_THREADS and n.
+/// @return RS_PASS | RS_ERR, and then nothing was added.
+int dict_SetMany(dict_t* d, const key_t* keys, int n, void* const* values, int num_threads);
+
+/// Parses one line for dict_LoadFile(). Called from several threads at once.
+/// @param line The line, without the end of line. Can be changed, and the key can point into it.
+/// @param k Where to put the key. For KEY_BYTES k->kb already points to a kbytes_t to fill in.
+/// @param v Where to put the value. For inline dicts the value_size bytes of the value, else a void* for the
+///          value pointer, which the dict then owns.
+/// @param ctx From dict_LoadFile().
+/// @return RS_PASS | RS_FAIL to skip the line, like a header | RS_ERR to give up.
+typedef int (*dict_ParseFunc_t)(char* line, key_t* k, void* v, void* ctx);
+
+/// Load a text file of one entry per line, like a CSV. The file is split into a piece per thread at line ends.
+/// Each thread reads its piece 1M at a time, then parses and hashes the lines. The entries are then added as in
+/// dict_SetMany(). Later lines win. Until then the parsed keys and inline values are copied aside, plus about
+/// 32 bytes per line, so peak memory is that on top of the dict, not the size of the file.
+/// @param d The dictionary opaque pointer. Not static.
+/// @param path File name.
+/// @param parse Makes an entry from a line.
+/// @param ctx Passed to parse.
+/// @param num_threads How many threads to use, including the caller's. At most DICT_MAX_THREADS.
+/// @return RS_PASS | RS_ERR if the file can't be read or parse gave up, and then nothing was added.
+int dict_LoadFile(dict_t* d, const char* path, dict_ParseFunc_t parse, void* ctx, int num_threads);
+
+/// Remove an entry. The key copy is freed and the table may shrink.
+/// @param d The dictionary opaque pointer.
+/// @param k The key.
+/// @param v Where to put the associated data. Client takes ownership of it now!
+/// @return RS_PASS | RS_FAIL (not there) | RS_ERR.
+int dict_Remove(dict_t* d, key_t k, void** v);
+
+/// Get a list of copies of all keys, char*, int*, unsigned long long* or kbytes_t* with the bytes after it in the same
+/// allocation. NOTE - client must destroy the returned list.
+/// The iterator is cheaper if you just want to look at them.
 /// @param d The dictionary opaque pointer.
 /// @return The list | BAD_PTR.
 list_t* dict_GetKeys(dict_t* d);
 
-/// Dump contents of the dict to file.
+/// Initialize iterator. Nothing is allocated. Don't dict_Set() while iterating.
+/// @param d The dictionary opaque pointer.
+/// @return RS_PASS | RS_ERR | RS_FAIL (if empty).
+int dict_IterStart(dict_t* d);
+
+/// Next iteration in dict. Order is arbitrary.
+/// @param d The dictionary opaque pointer.
+/// @param k Where to put the key. String and bytes keys point into the dict and are only valid until the next change to
+/// it, the kbytes_t of a bytes key only until the next dict_IterNext().
+/// @param v Where to put the associated data. The dict still owns it.
+/// @return RS_PASS | RS_ERR | RS_FAIL (if empty or at end).
+int dict_IterNext(dict_t* d, key_t* k, void** v);
+
+/// Remove the entry last returned by dict_IterNext(). Iteration carries on with the next one.
+/// @param d The dictionary opaque pointer.
+/// @param v Where to put the associated data. Client takes ownership of it now!
+/// @return RS_PASS | RS_ERR (no current entry).
+int dict_IterRemove(dict_t* d, void** v);
+
+/// Dump contents of the dict to file, for debugging. The first three keys of each bin follow dict_GetStats().
 /// @param d Pertinent dictionary.
 /// @param fp Output stream.
 /// @return RS_PASS | RS_ERR.
 int dict_Dump(dict_t* d, FILE* fp);
 
+/// Write a dict to a file as a flat image that dict_OpenMapped() can use in place. It holds the hash index,
+/// the values and the string keys, with offsets instead of pointers. Only for inline dicts (dict_CreateInline())
+/// with KEY_INT or KEY_STRING keys using dict_HashFast() or dict_HashSip(), since client pointers and hash
+/// functions can't be saved. The image is in the byte order of this machine.
+/// @param d The dictionary opaque pointer.
+/// @param path File name. Replaced if it exists.
+/// @return RS_PASS | RS_ERR.
+int dict_Save(dict_t* d, const char* path);
+
+/// Map a file written by dict_Save() read-only and use it as a frozen dict (see dict_Freeze()). Nothing is
+/// parsed or copied, so this is quick for any size and pages are only read in as lookups touch them. Values
+/// from dict_Get() etc point into the mapping. dict_Destroy() unmaps it.
+/// @param path File name.
+/// @return The dictionary opaque pointer used in all functions | BAD_PTR if missing or not a valid image.
+dict_t* dict_OpenMapped(const char* path);
+
 #endif // DICT_H
@@ -0,0 +1,77 @@
+#ifndef OMAP_H
+#define OMAP_H
+
+#include <stdbool.h>
+#include "common.h"
+#include "dict.h"
+
+/// @brief Declaration of an ordered map, for when you need the keys in order or everything between two keys,
+/// like samples between t0 and t1. It is a B+ tree with wide nodes, so a lookup touches a few cache friendly
+/// nodes and a range walk follows the leaves without searching again.
+/// Keys and values follow the dict conventions: int or string keys, string keys are copied, values are client
+/// pointers that the map frees when replaced and in omap_Clear() and omap_Destroy(). omap_Remove() hands them back.
+/// Int keys are ordered by value, string keys by strcmp().
+
+
+//---------------- Public API ----------------------//
+
+/// Opaque ordered map object.
+typedef struct omap omap_t;
+
+/// Create an empty map.
+/// @param kt Key type, KEY_INT or KEY_STRING.
+/// @return The opaque pointer used in all functions | BAD_PTR.
+omap_t* omap_Create(keyType_t kt);
+
+/// Deletes all entries and frees the values, frees the map struct.
+/// @param m The omap opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int omap_Destroy(omap_t* m);
+
+/// Deletes all entries and frees the values.
+/// @param m The omap opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int omap_Clear(omap_t* m);
+
+/// Number of entries.
+/// @param m The omap opaque pointer.
+/// @return The count | RS_ERR.
+int omap_Count(omap_t* m);
+
+/// Add or replace an entry. O(log n).
+/// @param m The omap opaque pointer.
+/// @param k The key.
+/// @param v The value. The map takes ownership. Replaces and frees any existing.
+/// @return RS_PASS | RS_ERR.
+int omap_Set(omap_t* m, key_t k, void* v);
+
+/// Get an entry. O(log n).
+/// @param m The omap opaque pointer.
+/// @param k The key.
+/// @param v Where to put the value.
+/// @return RS_PASS | RS_FAIL if not there | RS_ERR.
+int omap_Get(omap_t* m, key_t k, void** v);
+
+/// Remove an entry. O(log n).
+/// @param m The omap opaque pointer.
+/// @param k The key.
+/// @param v Where to put the value. Client takes ownership of it now!
+/// @return RS_PASS | RS_FAIL if not there | RS_ERR.
+int omap_Remove(omap_t* m, key_t k, void** v);
+
+/// Start walking the entries with lo <= key < hi in key order. Finding the start is O(log n), the walk is then
+/// one step per entry. Nothing is allocated. Don't change the map while iterating.
+/// @param m The omap opaque pointer.
+/// @param lo First key to include, the lower bound | NULL to start at the smallest.
+/// @param hi First key not to include | NULL to go to the end.
+/// @return RS_PASS | RS_FAIL if the range is empty | RS_ERR.
+int omap_IterStart(omap_t* m, const key_t* lo, const key_t* hi);
+
+/// Next entry of the walk.
+/// @param m The omap opaque pointer.
+/// @param k Where to put the key. A string key points into the map and is only valid until the next change to it.
+/// @param v Where to put the value. The map still owns it.
+/// @return RS_PASS | RS_FAIL at the end | RS_ERR.
+int omap_IterNext(omap_t* m, key_t* k, void** v);
+
+#endif // OMAP_H
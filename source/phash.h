@@ -0,0 +1,76 @@
+#ifndef PHASH_H
+#define PHASH_H
+
+#include <stdio.h>
+#include "common.h"
+#include "dict.h"
+
+/// @brief Declaration of a perfect hash table for a fixed set of keys known ahead of time, like command
+/// names or event names. Every key gets a slot of its own so a lookup is one hash, one slot and one key
+/// compare, with no chains or probing. Built with hash and displace: the keys are split into small buckets
+/// and each bucket gets a displacement that moves all its keys into free slots.
+/// phash_gen turns a key list into C source for a const phash_t at build time, so the table lives in
+/// read-only data and needs no init or heap. phash_Build() does the same at run time.
+/// Unlike the other components the struct is public so generated tables can be compile time constants.
+/// Clients should treat it as opaque.
+
+
+//---------------- Public API ----------------------//
+
+/// The table. Use the functions, not the members.
+typedef struct phash
+{
+    keyType_t kt;                   ///> The key type.
+    unsigned long long seed;        ///> For dict_HashFast(). Picked by the build.
+    unsigned int num_buckets;       ///> Bucket count.
+    unsigned int num_slots;         ///> Number of keys, one slot each.
+    const unsigned int* disp;       ///> Displacement pair of each bucket.
+    const char* const* skeys;       ///> KEY_STRING: the key in each slot.
+    const int* ikeys;               ///> KEY_INT: the key in each slot.
+    const unsigned int* index;      ///> Position in the original key list of the key in each slot.
+    void* const* values;            ///> Value of each slot | NULL if there are none.
+    bool owned;                     ///> From phash_Build() so the arrays are on the heap.
+} phash_t;
+
+/// Make a table at run time for keys only known at startup. Takes a while for big key sets, it is meant
+/// to be done once.
+/// @param kt Key type, KEY_INT or KEY_STRING.
+/// @param keys The keys. String keys are copied.
+/// @param values Optional value of each key, in the same order | NULL.
+/// @param n Number of keys.
+/// @return The table, destroy with phash_Destroy() | BAD_PTR if there are no keys or duplicates.
+phash_t* phash_Build(keyType_t kt, const key_t* keys, void* const* values, int n);
+
+/// Free a table from phash_Build().
+/// @param ph The table.
+/// @return RS_PASS | RS_ERR if not from phash_Build().
+int phash_Destroy(phash_t* ph);
+
+/// Number of keys.
+/// @param ph The table.
+/// @return Count | RS_ERR.
+int phash_Count(const phash_t* ph);
+
+/// Look up a key. Same as dict_Get().
+/// @param ph The table.
+/// @param k The key.
+/// @param v Where to put the value. NULL if the table has none.
+/// @return RS_PASS | RS_FAIL if not a key | RS_ERR.
+int phash_Get(const phash_t* ph, key_t k, void** v);
+
+/// Look up where a key was in the list the table was made from, for use with a parallel array of the client's.
+/// @param ph The table.
+/// @param k The key.
+/// @return Index | RS_FAIL if not a key | RS_ERR.
+int phash_Index(const phash_t* ph, key_t k);
+
+/// Write C source that defines the table as a const phash_t. It needs phash.h and nothing else.
+/// @param ph The table.
+/// @param name Variable name for the table. Other names in the file start with it.
+/// @param value_exprs Optional C constant expression for the value of each key, in original order | NULL.
+///                    Each is cast to void*. An entry may be NULL for no value.
+/// @param fp Output stream.
+/// @return RS_PASS | RS_ERR.
+int phash_Write(const phash_t* ph, const char* name, const char* const* value_exprs, FILE* fp);
+
+#endif // PHASH_H
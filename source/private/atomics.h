@@ -0,0 +1,112 @@
+#ifndef ATOMICS_H
+#define ATOMICS_H
+
+#include <stdbool.h>
+
+/// @brief Declaration of the few atomic operations the threaded components use, for any compiler.
+/// C11 <stdatomic.h> where the compiler has it, Interlocked functions on MSVC, else the GCC/Clang builtins.
+/// The objects are plain types, not _Atomic, so the structs that hold them stay C99.
+/// Interlocked functions are full barriers so the order argument is ignored there. It is never weaker.
+/// ATOM_LOAD_xxx(p, o) and ATOM_STORE_xxx(p, v, o) are for int, unsigned int, unsigned long long and pointers.
+/// ATOM_EXCHANGE_PTR() gives the old value, ATOM_ADD_U64() the new one. ATOM_CAS_INT() is a strong compare
+/// exchange with e pointing to the expected value.
+
+
+//---------------- Public API ----------------------//
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+
+#include <stdatomic.h>
+
+#define ATOM_RELAXED memory_order_relaxed
+#define ATOM_ACQUIRE memory_order_acquire
+#define ATOM_RELEASE memory_order_release
+#define ATOM_ACQ_REL memory_order_acq_rel
+#define ATOM_SEQ_CST memory_order_seq_cst
+
+#define ATOM_LOAD_INT(p, o) atomic_load_explicit((_Atomic int*)(p), (o))
+#define ATOM_LOAD_UINT(p, o) atomic_load_explicit((_Atomic unsigned int*)(p), (o))
+#define ATOM_LOAD_U64(p, o) atomic_load_explicit((_Atomic unsigned long long*)(p), (o))
+#define ATOM_LOAD_PTR(p, o) atomic_load_explicit((void* _Atomic*)(p), (o))
+
+#define ATOM_STORE_INT(p, v, o) atomic_store_explicit((_Atomic int*)(p), (v), (o))
+#define ATOM_STORE_UINT(p, v, o) atomic_store_explicit((_Atomic unsigned int*)(p), (v), (o))
+#define ATOM_STORE_U64(p, v, o) atomic_store_explicit((_Atomic unsigned long long*)(p), (v), (o))
+#define ATOM_STORE_PTR(p, v, o) atomic_store_explicit((void* _Atomic*)(p), (void*)(v), (o))
+
+#define ATOM_EXCHANGE_PTR(p, v, o) atomic_exchange_explicit((void* _Atomic*)(p), (void*)(v), (o))
+#define ATOM_ADD_U64(p, v, o) (atomic_fetch_add_explicit((_Atomic unsigned long long*)(p), (v), (o)) + (v))
+#define ATOM_CAS_INT(p, e, v, o) atomic_compare_exchange_strong_explicit((_Atomic int*)(p), (e), (v), (o), memory_order_relaxed)
+#define ATOM_FENCE(o) atomic_thread_fence(o)
+
+#elif defined(_MSC_VER)
+
+#include <windows.h>
+
+#define ATOM_RELAXED 0
+#define ATOM_ACQUIRE 0
+#define ATOM_RELEASE 0
+#define ATOM_ACQ_REL 0
+#define ATOM_SEQ_CST 0
+
+#define ATOM_LOAD_INT(p, o) ((int)InterlockedOr((volatile LONG*)(p), 0))
+#define ATOM_LOAD_UINT(p, o) ((unsigned int)InterlockedOr((volatile LONG*)(p), 0))
+#define ATOM_LOAD_U64(p, o) ((unsigned long long)InterlockedOr64((volatile LONG64*)(p), 0))
+#define ATOM_LOAD_PTR(p, o) InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+
+#define ATOM_STORE_INT(p, v, o) ((void)InterlockedExchange((volatile LONG*)(p), (LONG)(v)))
+#define ATOM_STORE_UINT(p, v, o) ((void)InterlockedExchange((volatile LONG*)(p), (LONG)(v)))
+#define ATOM_STORE_U64(p, v, o) ((void)InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v)))
+#define ATOM_STORE_PTR(p, v, o) ((void)InterlockedExchangePointer((PVOID volatile*)(p), (PVOID)(v)))
+
+#define ATOM_EXCHANGE_PTR(p, v, o) InterlockedExchangePointer((PVOID volatile*)(p), (PVOID)(v))
+#define ATOM_ADD_U64(p, v, o) ((unsigned long long)InterlockedAdd64((volatile LONG64*)(p), (LONG64)(v)))
+#define ATOM_CAS_INT(p, e, v, o) atom_CasInt((volatile LONG*)(p), (LONG*)(e), (LONG)(v))
+#define ATOM_FENCE(o) MemoryBarrier()
+
+/// ATOM_CAS_INT() with the C11 meaning: on failure the expected value is updated.
+static __inline bool atom_CasInt(volatile LONG* p, LONG* expected, LONG v)
+{
+    LONG old = InterlockedCompareExchange(p, v, *expected);
+    bool ok = old == *expected;
+    *expected = old;
+    return ok;
+}
+
+#elif defined(__GNUC__)
+
+#define ATOM_RELAXED __ATOMIC_RELAXED
+#define ATOM_ACQUIRE __ATOMIC_ACQUIRE
+#define ATOM_RELEASE __ATOMIC_RELEASE
+#define ATOM_ACQ_REL __ATOMIC_ACQ_REL
+#define ATOM_SEQ_CST __ATOMIC_SEQ_CST
+
+#define ATOM_LOAD_INT(p, o) __atomic_load_n((p), (o))
+#define ATOM_LOAD_UINT(p, o) __atomic_load_n((p), (o))
+#define ATOM_LOAD_U64(p, o) __atomic_load_n((p), (o))
+#define ATOM_LOAD_PTR(p, o) __atomic_load_n((p), (o))
+
+#define ATOM_STORE_INT(p, v, o) __atomic_store_n((p), (v), (o))
+#define ATOM_STORE_UINT(p, v, o) __atomic_store_n((p), (v), (o))
+#define ATOM_STORE_U64(p, v, o) __atomic_store_n((p), (v), (o))
+#define ATOM_STORE_PTR(p, v, o) __atomic_store_n((p), (v), (o))
+
+#define ATOM_EXCHANGE_PTR(p, v, o) __atomic_exchange_n((p), (v), (o))
+#define ATOM_ADD_U64(p, v, o) __atomic_add_fetch((p), (v), (o))
+#define ATOM_CAS_INT(p, e, v, o) __atomic_compare_exchange_n((p), (e), (v), false, (o), __ATOMIC_RELAXED)
+#define ATOM_FENCE(o) __atomic_thread_fence(o)
+
+#else
+#error "No atomic operations for this compiler."
+#endif
+
+/// Give up the rest of the time slice, while spinning on another thread.
+#ifdef _WIN32
+#include <windows.h>
+#define ATOM_YIELD() SwitchToThread()
+#else
+#include <sched.h>
+#define ATOM_YIELD() sched_yield()
+#endif
+
+#endif // ATOMICS_H
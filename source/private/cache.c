@@ -0,0 +1,433 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "dict.h"
+#include "cache.h"
+
+
+/// @brief Definition of cache.
+/// Entries live in a fixed array of slots allocated up front. An inline dict maps each key to its slot. Unused
+/// slots are chained on a free list. For CACHE_LRU the used slots are also on a doubly linked recency list by
+/// index, so a hit unlinks the slot and puts it at the front and eviction takes the back, no searching.
+/// For CACHE_CLOCK a hit only sets the slot's ref flag. The clock hand goes round the array, clearing flags, and
+/// evicts the first used slot it finds without one.
+
+
+//---------------- Private Declarations ------------------//
+
+/// No slot.
+#define CACHE_NONE -1
+
+/// One entry.
+typedef struct centry
+{
+    key_t key;          ///> Copy of the key, to take it out of the dict on eviction.
+    void* value;        ///> Client value.
+    size_t size;        ///> Client size.
+    int prev;           ///> CACHE_LRU: more recent slot | CACHE_NONE.
+    int next;           ///> CACHE_LRU: less recent slot | CACHE_NONE. Next free slot if unused.
+    bool used;          ///> Holds an entry.
+    bool ref;           ///> CACHE_CLOCK: used since the hand last went by.
+} centry_t;
+
+/// Definition of cache.
+struct cache
+{
+    keyType_t kt;                   ///> The key type.
+    cachePolicy_t policy;           ///> Eviction policy.
+    dict_t* index;                  ///> Key to slot number.
+    centry_t* slots;                ///> All the entries.
+    int max_entries;                ///> Number of slots.
+    size_t max_bytes;               ///> Size limit | 0.
+    size_t bytes;                   ///> Size in.
+    int count;                      ///> Used slots.
+    int head;                       ///> CACHE_LRU: most recent | CACHE_NONE.
+    int tail;                       ///> CACHE_LRU: least recent | CACHE_NONE.
+    int free_head;                  ///> First unused slot | CACHE_NONE.
+    int hand;                       ///> CACHE_CLOCK: next slot to look at.
+    cache_EvictFunc_t evict;        ///> Takes values leaving | NULL.
+    void* evict_ctx;                ///> For evict.
+    unsigned long long hits;        ///> Counter.
+    unsigned long long misses;      ///> Counter.
+    unsigned long long evictions;   ///> Counter.
+};
+
+/// Copy a key, allocating for strings and bytes.
+/// @param c The cache.
+/// @param k The key.
+/// @return The copy.
+static key_t p_CopyKey(cache_t* c, key_t k);
+
+/// Free a copied key.
+/// @param c The cache.
+/// @param k The key.
+static void p_FreeKey(cache_t* c, key_t k);
+
+/// CACHE_LRU: put a slot at the front.
+/// @param c The cache.
+/// @param i The slot.
+static void p_Link(cache_t* c, int i);
+
+/// CACHE_LRU: take a slot out of the recency list.
+/// @param c The cache.
+/// @param i The slot.
+static void p_Unlink(cache_t* c, int i);
+
+/// Empty a slot and put it on the free list.
+/// @param c The cache.
+/// @param i The slot.
+/// @param v Where to put the value | NULL to send it to the evict callback or free it.
+static void p_Drop(cache_t* c, int i, void** v);
+
+/// Pick the slot to evict.
+/// @param c The cache, not empty.
+/// @return The slot.
+static int p_Victim(cache_t* c);
+
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+cache_t* cache_Create(keyType_t kt, int max_entries, size_t max_bytes, cachePolicy_t policy)
+{
+    if(max_entries <= 0 || (policy != CACHE_LRU && policy != CACHE_CLOCK))
+    {
+        return BAD_PTR;
+    }
+
+    dict_t* index = dict_CreateInlineEx(kt, max_entries, DICT_OPEN, sizeof(int));
+    VAL_PTR(index, BAD_PTR);
+
+    CREATE_INST(c, cache_t);
+    CREATE_ARR(slots, centry_t, max_entries);
+
+    c->kt = kt;
+    c->policy = policy;
+    c->index = index;
+    c->slots = slots;
+    c->max_entries = max_entries;
+    c->max_bytes = max_bytes;
+    c->head = CACHE_NONE;
+    c->tail = CACHE_NONE;
+
+    for(int i = 0; i < max_entries; i++)
+    {
+        slots[i].next = i + 1 < max_entries ? i + 1 : CACHE_NONE;
+    }
+
+    return c;
+}
+
+//--------------------------------------------------------//
+int cache_Destroy(cache_t* c)
+{
+    VAL_PTR(c, RS_ERR);
+
+    cache_Clear(c);
+    dict_Destroy(c->index);
+    FREE(c->slots);
+    FREE(c);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int cache_Clear(cache_t* c)
+{
+    VAL_PTR(c, RS_ERR);
+
+    for(int i = 0; i < c->max_entries; i++)
+    {
+        if(c->slots[i].used)
+        {
+            p_Drop(c, i, NULL);
+        }
+    }
+
+    c->hand = 0;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int cache_Count(cache_t* c)
+{
+    VAL_PTR(c, RS_ERR);
+
+    return c->count;
+}
+
+//--------------------------------------------------------//
+int cache_SetEvict(cache_t* c, cache_EvictFunc_t func, void* ctx)
+{
+    VAL_PTR(c, RS_ERR);
+
+    c->evict = func;
+    c->evict_ctx = ctx;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int cache_Get(cache_t* c, key_t k, void** v)
+{
+    VAL_PTR(c, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    int* pi;
+    int ret = dict_Get(c->index, k, (void**)&pi);
+
+    if(ret == RS_PASS)
+    {
+        centry_t* e = &c->slots[*pi];
+
+        if(c->policy == CACHE_LRU)
+        {
+            if(c->head != *pi)
+            {
+                p_Unlink(c, *pi);
+                p_Link(c, *pi);
+            }
+        }
+        else
+        {
+            e->ref = true;
+        }
+
+        *v = e->value;
+        c->hits++;
+    }
+    else if(ret == RS_FAIL)
+    {
+        c->misses++;
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int cache_Put(cache_t* c, key_t k, void* v, size_t size)
+{
+    VAL_PTR(c, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    if(c->max_bytes > 0 && size > c->max_bytes)
+    {
+        return RS_FAIL;
+    }
+
+    // A replaced value goes the same way as an evicted one.
+    int* pi;
+    int ret = dict_Get(c->index, k, (void**)&pi);
+
+    if(ret == RS_ERR)
+    {
+        return RS_ERR;
+    }
+
+    if(ret == RS_PASS)
+    {
+        p_Drop(c, *pi, NULL);
+    }
+
+    while(c->count == c->max_entries || (c->max_bytes > 0 && c->bytes + size > c->max_bytes))
+    {
+        p_Drop(c, p_Victim(c), NULL);
+        c->evictions++;
+    }
+
+    int i = c->free_head;
+    centry_t* e = &c->slots[i];
+    c->free_head = e->next;
+
+    e->key = p_CopyKey(c, k);
+    e->value = v;
+    e->size = size;
+    e->used = true;
+    e->ref = false;
+    c->count++;
+    c->bytes += size;
+
+    if(c->policy == CACHE_LRU)
+    {
+        p_Link(c, i);
+    }
+
+    return dict_Set(c->index, k, &i);
+}
+
+//--------------------------------------------------------//
+int cache_Remove(cache_t* c, key_t k, void** v)
+{
+    VAL_PTR(c, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    int* pi;
+    int ret = dict_Get(c->index, k, (void**)&pi);
+
+    if(ret == RS_PASS)
+    {
+        p_Drop(c, *pi, v);
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int cache_GetStats(cache_t* c, cache_stats_t* stats)
+{
+    VAL_PTR(c, RS_ERR);
+    VAL_PTR(stats, RS_ERR);
+
+    stats->count = c->count;
+    stats->bytes = c->bytes;
+    stats->hits = c->hits;
+    stats->misses = c->misses;
+    stats->evictions = c->evictions;
+
+    return RS_PASS;
+}
+
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+key_t p_CopyKey(cache_t* c, key_t k)
+{
+    if(c->kt == KEY_STRING)
+    {
+        CREATE_STR(s, strlen(k.ks));
+        strcpy(s, k.ks);
+        k.ks = s;
+    }
+    else if(c->kt == KEY_BYTES)
+    {
+        // The bytes follow the header, like dict_GetKeys().
+        kbytes_t* pb = (kbytes_t*)calloc(1, sizeof(kbytes_t) + k.kb->len);
+        _CREATE(pb);
+        memcpy(pb + 1, k.kb->data, k.kb->len);
+        pb->data = pb + 1;
+        pb->len = k.kb->len;
+        k.kb = pb;
+    }
+
+    return k;
+}
+
+//--------------------------------------------------------//
+void p_FreeKey(cache_t* c, key_t k)
+{
+    if(c->kt == KEY_STRING)
+    {
+        FREE((char*)k.ks);
+    }
+    else if(c->kt == KEY_BYTES)
+    {
+        FREE((void*)k.kb);
+    }
+}
+
+//--------------------------------------------------------//
+void p_Link(cache_t* c, int i)
+{
+    centry_t* e = &c->slots[i];
+
+    e->prev = CACHE_NONE;
+    e->next = c->head;
+
+    if(c->head != CACHE_NONE)
+    {
+        c->slots[c->head].prev = i;
+    }
+    else
+    {
+        c->tail = i;
+    }
+
+    c->head = i;
+}
+
+//--------------------------------------------------------//
+void p_Unlink(cache_t* c, int i)
+{
+    centry_t* e = &c->slots[i];
+
+    if(e->prev != CACHE_NONE)
+    {
+        c->slots[e->prev].next = e->next;
+    }
+    else
+    {
+        c->head = e->next;
+    }
+
+    if(e->next != CACHE_NONE)
+    {
+        c->slots[e->next].prev = e->prev;
+    }
+    else
+    {
+        c->tail = e->prev;
+    }
+}
+
+//--------------------------------------------------------//
+void p_Drop(cache_t* c, int i, void** v)
+{
+    centry_t* e = &c->slots[i];
+    void* dummy;
+
+    dict_Remove(c->index, e->key, &dummy);
+
+    if(c->policy == CACHE_LRU)
+    {
+        p_Unlink(c, i);
+    }
+
+    if(v != NULL)
+    {
+        *v = e->value;
+    }
+    else if(c->evict != NULL)
+    {
+        c->evict(e->key, e->value, c->evict_ctx);
+    }
+    else
+    {
+        FREE(e->value);
+    }
+
+    p_FreeKey(c, e->key);
+    c->count--;
+    c->bytes -= e->size;
+
+    memset(e, 0, sizeof(centry_t));
+    e->next = c->free_head;
+    c->free_head = i;
+}
+
+//--------------------------------------------------------//
+int p_Victim(cache_t* c)
+{
+    if(c->policy == CACHE_LRU)
+    {
+        return c->tail;
+    }
+
+    // Every used slot gets its flag cleared on the first time round so this ends on the second at most.
+    for(;;)
+    {
+        centry_t* e = &c->slots[c->hand];
+        int i = c->hand;
+        c->hand = c->hand + 1 < c->max_entries ? c->hand + 1 : 0;
+
+        if(e->used && !e->ref)
+        {
+            return i;
+        }
+
+        e->ref = false;
+    }
+}
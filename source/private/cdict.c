@@ -0,0 +1,517 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "dict.h"
+#include "cdict.h"
+#include "dict_private.h"
+#include "atomics.h"
+
+
+/// @brief Definition of concurrent dictionary thing.
+/// Each stripe is an open addressing table like DICT_OPEN, guarded by a sequence lock:
+/// writers hold the stripe mutex and make the sequence odd while they change anything,
+/// readers copy what they need and start over if the sequence moved meanwhile.
+/// A reader can be looking at a table or key while a writer replaces it, so those are never freed
+/// before destroy. That way whatever a reader sees is at worst stale, never gone.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Stripes when the client doesn't say. Must be a power of 2.
+#define CDICT_DEFAULT_STRIPES 64
+
+/// Smallest table per stripe. Must be a power of 2.
+#define CDICT_MIN_BINS 16
+
+/// Grow a table when this percent of the slots are used.
+#define CDICT_MAX_LOAD 75
+
+/// One entry. The value follows, rounded up to keep the next entry aligned.
+typedef struct slot
+{
+    union
+    {
+        const char* skey;   ///> String key, in the key arena. Read atomically by readers.
+        int ikey;           ///> Int key.
+    } key;
+    unsigned char value[];  ///> value_size bytes.
+} slot_t;
+
+/// One table. Size and arrays don't change once published so a reader gets a consistent set with one load.
+typedef struct table
+{
+    struct table* retired;      ///> Tables this one replaced. Freed at destroy.
+    unsigned int num_bins;      ///> Number of slots. Always a power of 2.
+    unsigned int shift;         ///> Picks the bin from the top bits of the spread hash.
+    unsigned long long* hashes; ///> Full hash of each slot. 0 means empty.
+    unsigned char* slots;       ///> The entries, stride bytes apart.
+} table_t;
+
+/// One independently locked part.
+typedef struct stripe
+{
+    unsigned int seq;       ///> Odd while a writer is changing the table.
+    int count;              ///> Number of entries.
+    table_t* table;         ///> Current table.
+    chunk_t* keys;          ///> String key storage, newest chunk first. Never freed before destroy.
+    pthread_mutex_t lock;   ///> Held by writers.
+    char pad[64];           ///> Keeps the next stripe off this cache line.
+} stripe_t;
+
+/// One instance of a concurrent dictionary.
+struct cdict
+{
+    keyType_t kt;           ///> The key type.
+    size_t value_size;      ///> Bytes per value.
+    size_t stride;          ///> Bytes per slot.
+    unsigned int mask;      ///> Picks the stripe from the low bits of the hash.
+    stripe_t* stripes;      ///> The parts.
+};
+
+/// Make the hash for a key. Never 0 as that marks an empty slot.
+/// @param cd The cdict.
+/// @param k The key.
+/// @return The hash.
+static unsigned long long p_Hash(cdict_t* cd, key_t k);
+
+/// The entry in a slot.
+/// @param cd The cdict.
+/// @param t The table.
+/// @param i The slot.
+/// @return The entry.
+static slot_t* p_Slot(cdict_t* cd, table_t* t, unsigned int i);
+
+/// Compare keys. Safe while a writer is changing the slot, the result is just wrong.
+/// @param cd The cdict.
+/// @param sl The entry.
+/// @param k The key.
+/// @return True if they are the same.
+static bool p_Match(cdict_t* cd, slot_t* sl, key_t k);
+
+/// Look up without the lock and copy the value out. Caller checks the sequence afterwards.
+/// @param cd The cdict.
+/// @param t The table.
+/// @param k The key.
+/// @param hash Its hash.
+/// @param v Where to copy the value.
+/// @return True if found.
+static bool p_Read(cdict_t* cd, table_t* t, key_t k, unsigned long long hash, void* v);
+
+/// Find a key with the lock held.
+/// @param cd The cdict.
+/// @param t The table.
+/// @param k The key.
+/// @param hash Its hash.
+/// @param at Where to put the slot it is in, or the empty slot it would go in.
+/// @return True if found.
+static bool p_Probe(cdict_t* cd, table_t* t, key_t k, unsigned long long hash, unsigned int* at);
+
+/// Make an empty table.
+/// @param cd The cdict.
+/// @param num_bins Number of slots.
+/// @return The table.
+static table_t* p_CreateTable(cdict_t* cd, unsigned int num_bins);
+
+/// Replace the stripe table with one twice the size. The old one is retired, not freed.
+/// @param cd The cdict.
+/// @param s The stripe.
+static void p_Grow(cdict_t* cd, stripe_t* s);
+
+/// Empty a slot and shift following entries of the cluster back, like dict does. Not shared with it because
+/// readers may be probing the live table, so every move goes through p_MoveSlot() and atomic stores.
+/// @param cd The cdict.
+/// @param t The table.
+/// @param i The slot.
+static void p_RemoveSlot(cdict_t* cd, table_t* t, unsigned int i);
+
+/// Copy an entry to another slot of a live table, the key pointer in one piece.
+/// @param cd The cdict.
+/// @param t The table.
+/// @param to Destination slot.
+/// @param from Source slot.
+static void p_MoveSlot(cdict_t* cd, table_t* t, unsigned int to, unsigned int from);
+
+/// Writer side of the sequence lock. Call with the mutex held, before changing anything.
+/// @param s The stripe.
+static void p_WriteBegin(stripe_t* s);
+
+/// Writer side of the sequence lock. Call after changing things, before releasing the mutex.
+/// @param s The stripe.
+static void p_WriteEnd(stripe_t* s);
+
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+cdict_t* cdict_Create(keyType_t kt, size_t value_size, int num_stripes)
+{
+    if(value_size == 0 || num_stripes < 0 || (kt != KEY_INT && kt != KEY_STRING))
+    {
+        return BAD_PTR;
+    }
+
+    CREATE_INST(cd, cdict_t);
+
+    unsigned int n = 1;
+    while(n < (unsigned int)(num_stripes > 0 ? num_stripes : CDICT_DEFAULT_STRIPES))
+    {
+        n *= 2;
+    }
+
+    cd->kt = kt;
+    cd->value_size = value_size;
+    cd->stride = sizeof(slot_t) + (value_size + 7) / 8 * 8;
+    cd->mask = n - 1;
+
+    CREATE_ARR(stripes, stripe_t, n);
+    cd->stripes = stripes;
+
+    for(unsigned int i = 0; i < n; i++)
+    {
+        pthread_mutex_init(&stripes[i].lock, NULL);
+        stripes[i].table = p_CreateTable(cd, CDICT_MIN_BINS);
+    }
+
+    return cd;
+}
+
+//--------------------------------------------------------//
+int cdict_Destroy(cdict_t* cd)
+{
+    VAL_PTR(cd, RS_ERR);
+
+    for(unsigned int i = 0; i <= cd->mask; i++)
+    {
+        stripe_t* s = &cd->stripes[i];
+
+        while(s->table != NULL)
+        {
+            table_t* older = s->table->retired;
+            FREE(s->table->hashes);
+            FREE(s->table->slots);
+            FREE(s->table);
+            s->table = older;
+        }
+
+        p_ArenaRelease(&s->keys);
+
+        pthread_mutex_destroy(&s->lock);
+    }
+
+    FREE(cd->stripes);
+    FREE(cd);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int cdict_Count(cdict_t* cd)
+{
+    VAL_PTR(cd, RS_ERR);
+
+    int count = 0;
+
+    for(unsigned int i = 0; i <= cd->mask; i++)
+    {
+        count += ATOM_LOAD_INT(&cd->stripes[i].count, ATOM_RELAXED);
+    }
+
+    return count;
+}
+
+//--------------------------------------------------------//
+int cdict_Set(cdict_t* cd, key_t k, const void* v)
+{
+    VAL_PTR(cd, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    unsigned long long hash = p_Hash(cd, k);
+    stripe_t* s = &cd->stripes[hash & cd->mask];
+    unsigned int at;
+
+    pthread_mutex_lock(&s->lock);
+    p_WriteBegin(s);
+
+    if(!p_Probe(cd, s->table, k, hash, &at))
+    {
+        // Make room first so the new entry doesn't get moved.
+        if((unsigned long long)(s->count + 1) * 100 > (unsigned long long)s->table->num_bins * CDICT_MAX_LOAD)
+        {
+            p_Grow(cd, s);
+            p_Probe(cd, s->table, k, hash, &at);
+        }
+
+        slot_t* sl = p_Slot(cd, s->table, at);
+        if(cd->kt == KEY_STRING)
+        {
+            ATOM_STORE_PTR(&sl->key.skey, p_ArenaCopy(&s->keys, k.ks, strlen(k.ks) + 1), ATOM_RELAXED);
+        }
+        else
+        {
+            sl->key.ikey = k.ki;
+        }
+        ATOM_STORE_U64(&s->table->hashes[at], hash, ATOM_RELAXED);
+        ATOM_STORE_INT(&s->count, s->count + 1, ATOM_RELAXED);
+    }
+
+    memcpy(p_Slot(cd, s->table, at)->value, v, cd->value_size);
+
+    p_WriteEnd(s);
+    pthread_mutex_unlock(&s->lock);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int cdict_Get(cdict_t* cd, key_t k, void* v)
+{
+    VAL_PTR(cd, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    unsigned long long hash = p_Hash(cd, k);
+    stripe_t* s = &cd->stripes[hash & cd->mask];
+    bool found = false;
+    bool done = false;
+
+    while(!done)
+    {
+        unsigned int seq = ATOM_LOAD_UINT(&s->seq, ATOM_ACQUIRE);
+
+        if(seq & 1)
+        {
+            // Writer busy. Let it finish, it may be on this core.
+            ATOM_YIELD();
+        }
+        else
+        {
+            found = p_Read(cd, (table_t*)ATOM_LOAD_PTR(&s->table, ATOM_ACQUIRE), k, hash, v);
+
+            // Good if nothing changed while we were reading.
+            ATOM_FENCE(ATOM_ACQUIRE);
+            done = ATOM_LOAD_UINT(&s->seq, ATOM_RELAXED) == seq;
+        }
+    }
+
+    return found ? RS_PASS : RS_FAIL;
+}
+
+//--------------------------------------------------------//
+int cdict_Remove(cdict_t* cd, key_t k)
+{
+    VAL_PTR(cd, RS_ERR);
+
+    int ret = RS_FAIL;
+    unsigned long long hash = p_Hash(cd, k);
+    stripe_t* s = &cd->stripes[hash & cd->mask];
+    unsigned int at;
+
+    pthread_mutex_lock(&s->lock);
+
+    if(p_Probe(cd, s->table, k, hash, &at))
+    {
+        // The key bytes stay, a reader may be comparing them.
+        p_WriteBegin(s);
+        p_RemoveSlot(cd, s->table, at);
+        ATOM_STORE_INT(&s->count, s->count - 1, ATOM_RELAXED);
+        p_WriteEnd(s);
+        ret = RS_PASS;
+    }
+
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
+
+
+//---------------- Private Implementation --------------//
+
+//--------------------------------------------------------//
+unsigned long long p_Hash(cdict_t* cd, key_t k)
+{
+    unsigned long long hash = cd->kt == KEY_STRING ?
+        dict_HashFast(k.ks, strlen(k.ks), 0) :
+        dict_HashFast(&k.ki, sizeof(k.ki), 0);
+
+    return hash != 0 ? hash : 1;
+}
+
+//--------------------------------------------------------//
+slot_t* p_Slot(cdict_t* cd, table_t* t, unsigned int i)
+{
+    return (slot_t*)(t->slots + (size_t)i * cd->stride);
+}
+
+//--------------------------------------------------------//
+bool p_Match(cdict_t* cd, slot_t* sl, key_t k)
+{
+    bool match;
+
+    if(cd->kt == KEY_STRING)
+    {
+        // Any pointer seen here is NULL or a key that is never freed, and every chunk ends in a 0.
+        const char* skey = (const char*)ATOM_LOAD_PTR(&sl->key.skey, ATOM_RELAXED);
+        match = skey != NULL && strcmp(skey, k.ks) == 0;
+    }
+    else
+    {
+        match = sl->key.ikey == k.ki;
+    }
+
+    return match;
+}
+
+//--------------------------------------------------------//
+bool p_Read(cdict_t* cd, table_t* t, key_t k, unsigned long long hash, void* v)
+{
+    unsigned int mask = t->num_bins - 1;
+    unsigned int at = p_Bin(t->shift, hash);
+    bool found = false;
+    bool done = false;
+
+    // Bounded in case a writer leaves no empty slot in view.
+    for(unsigned int n = 0; n < t->num_bins && !done; n++)
+    {
+        unsigned long long h = ATOM_LOAD_U64(&t->hashes[at], ATOM_RELAXED);
+
+        if(h == 0)
+        {
+            done = true;
+        }
+        else if(h == hash && p_Match(cd, p_Slot(cd, t, at), k))
+        {
+            memcpy(v, p_Slot(cd, t, at)->value, cd->value_size);
+            found = true;
+            done = true;
+        }
+
+        at = (at + 1) & mask;
+    }
+
+    return found;
+}
+
+//--------------------------------------------------------//
+bool p_Probe(cdict_t* cd, table_t* t, key_t k, unsigned long long hash, unsigned int* at)
+{
+    unsigned int mask = t->num_bins - 1;
+    bool found = false;
+
+    *at = p_Bin(t->shift, hash);
+
+    while(t->hashes[*at] != 0 && !found)
+    {
+        if(t->hashes[*at] == hash && p_Match(cd, p_Slot(cd, t, *at), k))
+        {
+            found = true;
+        }
+        else
+        {
+            *at = (*at + 1) & mask;
+        }
+    }
+
+    return found;
+}
+
+//--------------------------------------------------------//
+table_t* p_CreateTable(cdict_t* cd, unsigned int num_bins)
+{
+    CREATE_INST(t, table_t);
+    CREATE_ARR(hashes, unsigned long long, num_bins);
+    CREATE_ARR(slots, unsigned char, (size_t)num_bins * cd->stride);
+
+    t->num_bins = num_bins;
+    t->shift = 64;
+    for(unsigned int n = num_bins; n > 1; n /= 2)
+    {
+        t->shift--;
+    }
+    t->hashes = hashes;
+    t->slots = slots;
+
+    return t;
+}
+
+//--------------------------------------------------------//
+void p_Grow(cdict_t* cd, stripe_t* s)
+{
+    table_t* old = s->table;
+    table_t* t = p_CreateTable(cd, old->num_bins * 2);
+    unsigned int mask = t->num_bins - 1;
+
+    // Nobody else can see the new one yet so plain copies are fine.
+    for(unsigned int i = 0; i < old->num_bins; i++)
+    {
+        if(old->hashes[i] != 0)
+        {
+            unsigned int j = p_Bin(t->shift, old->hashes[i]);
+
+            while(t->hashes[j] != 0)
+            {
+                j = (j + 1) & mask;
+            }
+
+            t->hashes[j] = old->hashes[i];
+            memcpy(p_Slot(cd, t, j), p_Slot(cd, old, i), cd->stride);
+        }
+    }
+
+    t->retired = old;
+    ATOM_STORE_PTR(&s->table, t, ATOM_RELEASE);
+}
+
+//--------------------------------------------------------//
+void p_RemoveSlot(cdict_t* cd, table_t* t, unsigned int i)
+{
+    unsigned int mask = t->num_bins - 1;
+    unsigned int hole = i;
+
+    for(unsigned int j = (i + 1) & mask; t->hashes[j] != 0; j = (j + 1) & mask)
+    {
+        // An entry can fill the hole only if its home is not between the hole and where it is now.
+        unsigned int home = p_Bin(t->shift, t->hashes[j]);
+        if(((j - home) & mask) >= ((j - hole) & mask))
+        {
+            p_MoveSlot(cd, t, hole, j);
+            hole = j;
+        }
+    }
+
+    ATOM_STORE_U64(&t->hashes[hole], 0, ATOM_RELAXED);
+    ATOM_STORE_PTR(&p_Slot(cd, t, hole)->key.skey, NULL, ATOM_RELAXED);
+}
+
+//--------------------------------------------------------//
+void p_MoveSlot(cdict_t* cd, table_t* t, unsigned int to, unsigned int from)
+{
+    slot_t* dst = p_Slot(cd, t, to);
+    slot_t* src = p_Slot(cd, t, from);
+
+    ATOM_STORE_U64(&t->hashes[to], t->hashes[from], ATOM_RELAXED);
+    if(cd->kt == KEY_STRING)
+    {
+        ATOM_STORE_PTR(&dst->key.skey, src->key.skey, ATOM_RELAXED);
+    }
+    else
+    {
+        dst->key.ikey = src->key.ikey;
+    }
+    memcpy(dst->value, src->value, cd->value_size);
+}
+
+//--------------------------------------------------------//
+void p_WriteBegin(stripe_t* s)
+{
+    ATOM_STORE_UINT(&s->seq, s->seq + 1, ATOM_RELAXED);
+    // Readers must not see any of the changes before the odd sequence.
+    ATOM_FENCE(ATOM_RELEASE);
+}
+
+//--------------------------------------------------------//
+void p_WriteEnd(stripe_t* s)
+{
+    ATOM_STORE_UINT(&s->seq, s->seq + 1, ATOM_RELEASE);
+}
@@ -1,12 +1,19 @@
-
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "common.h"
 #include "list.h"
 #include "dict.h"
+#include "dict_private.h"
 
 
 /// @brief Definition of dictionary thing.
@@ -14,59 +21,328 @@
 
 //---------------- Private Declarations ------------------//
 
-/// Size should be a prime number somewhere around the quantity of items.
-#define DICT_NUM_BINS 101
+/// Number of bins when the client doesn't give us a clue. Must be a power of 2.
+#define DICT_DEFAULT_BINS 128
+
+/// Grow when the average chain length exceeds this, in percent.
+#define DICT_MAX_LOAD 100
+
+/// Grow an open table when this percent of the slots are used. Linear probing falls apart much above this.
+#define DICT_MAX_LOAD_OPEN 75
+
+/// Static dicts never grow so are sized for this load, in percent. Keeps probe lengths short at any fill.
+#define DICT_MAX_LOAD_STATIC 50
+
+/// dict_GetMany(): keys hashed and prefetched ahead of being looked up. Enough to cover memory latency,
+/// few enough that the prefetched lines are still in L1 when used.
+#define DICT_BATCH 16
+
+/// Hint that memory will be read soon.
+#if defined(__GNUC__) || defined(__clang__)
+#define DICT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define DICT_PREFETCH(p)
+#endif
+
+/// DICT_INCREMENTAL: old bins moved per write operation. Caps the work any one call does.
+#define DICT_REHASH_BINS 16
+
+/// DICT_FILTER: filter bits per entry the table holds before it grows. Rounding the filter size up to a power of 2
+/// gives up to twice this.
+#define DICT_FILTER_BITS 10
+
+/// DICT_FILTER: bits set per key.
+#define DICT_FILTER_HASHES 6
+
+/// DICT_FILTER: all the bits for a key are in one block of this many words, so a check reads one cache line.
+#define DICT_FILTER_BLOCK 8
+
+/// Shrink when the load drops below the max load divided by this. Halving then leaves room before growing again.
+#define DICT_SHRINK_RATIO 4
+
+/// DICT_GROUP: number of control bytes examined together.
+#define DICT_GROUP_SIZE 16
+
+/// DICT_GROUP: control byte for an empty slot. Used slots hold a 7 bit tag so never have the top bit set.
+#define DICT_CTRL_EMPTY 0x80
+
+/// Common part of the create functions.
+/// @param kt Key type.
+/// @param capacity Expected number of entries.
+/// @param opts dictOpt_t flags.
+/// @param value_size Inline value bytes or 0.
+/// @return The dict | BAD_PTR.
+static dict_t* p_Create(keyType_t kt, int capacity, unsigned int opts, size_t value_size);
+
+/// DICT_STATIC: bins for a number of entries, and the bytes needed before the key space.
+/// @param max_entries Most entries.
+/// @param num_bins Where to put the number of bins.
+/// @return Bytes for the dict, its table and the key chunk header.
+static size_t p_StaticTable(int max_entries, unsigned int* num_bins);
+
+/// DICT_STATIC: check that a new entry fits.
+/// @param d The dictionary.
+/// @param k The key.
+/// @return True if there is a slot and space for the key.
+static bool p_HasRoom(dict_t* d, key_t k);
+
+/// DICT_MAPPED: make an entry from a slot of the image.
+/// @param d The dictionary.
+/// @param i The slot. Must be used.
+/// @param kv Where to put it.
+/// @return kv | NULL if the slot points outside the image.
+static kv_t* p_MappedKv(dict_t* d, unsigned int i, kv_t* kv);
+
+/// DICT_MAPPED: locate the entry for a key.
+/// @param d The dictionary.
+/// @param k The key.
+/// @param hash Its hash.
+/// @param kv Where to put the entry.
+/// @return kv | NULL if not there.
+static kv_t* p_MappedFind(dict_t* d, key_t k, unsigned long long hash, kv_t* kv);
+
+
+/// DICT_FILTER: add a key.
+/// @param d The dictionary.
+/// @param hash Its hash.
+static void p_FilterAdd(dict_t* d, unsigned long long hash);
+
+/// DICT_FILTER: check for a key.
+/// @param d The dictionary.
+/// @param hash Its hash.
+/// @return False if it is definitely not in the dict.
+static bool p_FilterMaybe(dict_t* d, unsigned long long hash);
+
+/// DICT_FILTER: the block for a hash.
+/// @param d The dictionary.
+/// @param hash Its hash.
+/// @return The first word.
+static unsigned long long* p_FilterBlock(dict_t* d, unsigned long long hash);
+
+/// Start fetching the memory a lookup will need first.
+/// @param d The dictionary.
+/// @param hash Key hash.
+static void p_PrefetchBin(dict_t* d, unsigned long long hash);
+
+/// dict_GetStats(): add one entry.
+/// @param d The dictionary.
+/// @param stats Being filled in.
+/// @param kv The entry | NULL if it owns no memory of its own.
+/// @param probe Probes to find it.
+static void p_StatsEntry(dict_t* d, dict_stats_t* stats, kv_t* kv, unsigned int probe);
+
+/// Number of set bits.
+/// @param x Value.
+/// @return Count.
+static unsigned int p_PopCount(unsigned long long x);
+
+/// DICT_OPEN: the entry in a slot.
+/// @param d The dictionary.
+/// @param i The slot.
+/// @return The entry.
+static kv_t* p_Slot(dict_t* d, unsigned int i);
+
+
+/// Hand the value of an entry that is about to be removed to the client.
+/// @param d The dictionary.
+/// @param kv The entry.
+/// @return The client pointer, NULL if inline.
+static void* p_TakeValue(dict_t* d, kv_t* kv);
+
+/// Little endian reads at any alignment, so hashes are the same on every platform.
+/// @param p Where.
+/// @return The value.
+static unsigned long long p_Read64(const unsigned char* p);
+static unsigned long long p_Read32(const unsigned char* p);
+
+/// Rotate left.
+/// @param x Value.
+/// @param b Bits. 1 to 63.
+/// @return Rotated value.
+static unsigned long long p_Rotl(unsigned long long x, int b);
+
+/// splitmix64 finalizer. Used to derive the second SipHash key half from the seed.
+/// @param x Value.
+/// @return Scrambled value.
+static unsigned long long p_Mix(unsigned long long x);
+
+
+/// DICT_GROUP: pick the 7 bit tag for a hash. Uses bits just below the ones p_Bin() takes.
+/// @param d The dictionary.
+/// @param hash Full hash value.
+/// @return The tag.
+static unsigned char p_Tag(dict_t* d, unsigned long long hash);
+
+/// DICT_GROUP: set a control byte and its copy past the end if it has one.
+/// @param d The dictionary.
+/// @param i Slot index.
+/// @param c Tag or DICT_CTRL_EMPTY.
+static void p_SetCtrl(dict_t* d, unsigned int i, unsigned char c);
+
+/// DICT_GROUP: find all bytes in a group that equal c. SIMD where we have it.
+/// @param ctrl Start of the group. May be unaligned.
+/// @param c What to look for.
+/// @return Bit n set if ctrl[n] == c.
+static unsigned int p_GroupMatch(const unsigned char* ctrl, unsigned char c);
+
+/// Index of the lowest set bit.
+/// @param m Non-zero mask.
+/// @return The index.
+static unsigned int p_LowBit(unsigned int m);
+
+/// Allocate an all empty control byte array for the current size.
+/// @param d The dictionary.
+static void p_CreateCtrl(dict_t* d);
+
+/// Compare an entry key with a client key.
+/// @param d The dictionary.
+/// @param kv The entry.
+/// @param k The key.
+/// @return True if the same.
+static bool p_Match(dict_t* d, kv_t* kv, key_t k);
+
+
+/// Move all entries to a new set of bins or slots. No keys or values are copied.
+/// @param d The dictionary.
+/// @param num_bins New size. Must be a power of 2.
+/// @return RS_PASS | RS_ERR.
+static int p_Resize(dict_t* d, unsigned int num_bins);
+
+/// Move some old bins to the current table. Everything goes at once unless DICT_INCREMENTAL.
+/// @param d The dictionary.
+/// @param num Max number of old bins to look at.
+static void p_RehashStep(dict_t* d, unsigned int num);
+
+/// DICT_CHAINED: look through a chain.
+/// @param d The dictionary.
+/// @param where The bin.
+/// @param k The key.
+/// @param hash Its hash.
+/// @return What points to the matching link | the NULL at the end of the chain.
+static link_t** p_FindLink(dict_t* d, link_t** where, key_t k, unsigned long long hash);
+
+
+/// Load factor limit for this flavor.
+/// @param opts dictOpt_t flags.
+/// @return Percent.
+static unsigned int p_MaxLoad(unsigned int opts);
+
+
+/// Remove the current entry of a walk. Frees the key copy but not the value. The walk carries on with the next one.
+/// @param d The dictionary.
+/// @param cur Walk position.
+static void p_RemoveCurrent(dict_t* d, cursor_t* cur);
+
+/// DICT_OPEN: empty a slot and shift following entries of the cluster back so that no probe
+/// sequence has a gap. Doesn't touch the key or value.
+/// @param d The dictionary.
+/// @param i The slot.
+static void p_RemoveSlot(dict_t* d, unsigned int i);
+
+/// Free the key copy and the client value of an entry.
+/// @param d The dictionary.
+/// @param kv The entry.
+static void p_FreeKv(dict_t* d, kv_t* kv);
+
+
+/// Get the bytes of a KEY_BYTES key.
+/// @param kv The entry.
+/// @param len Where to put the length.
+/// @return The bytes.
+static const char* p_KeyBytes(const kv_t* kv, size_t* len);
+
+/// Does a key have an allocation of its own. Arena keys don't, they go with the arena.
+/// @param d The dict.
+/// @param kv The entry.
+/// @return True if so.
+static bool p_OwnKey(dict_t* d, const kv_t* kv);
 
-/// Key-value pair.
-typedef struct kv
-{
-    char* skey;     ///> The key.
-    int ikey;       ///> The key.
-    void* value;    ///> Client specific data. Client must cast.
-} kv_t;
+/// Convert client to internal format.
+/// @param d The dictionary.
+/// @param k Key itself.
+/// @param kv Where to put it.
+static void p_ConvertKey(dict_t* d, key_t k, kv_t* kv);
+
+/// DICT_ARENA: free all the chunks.
+/// @param d The dictionary.
+static void p_ArenaFree(dict_t* d);
+
+//---------------- Public API Implementation -------------//
 
 
-/// One instance of a dictionary.
-struct dict
+//--------------------------------------------------------//
+dict_t* dict_Create(keyType_t kt)
+{
+    return dict_CreateEx(kt, DICT_DEFAULT_BINS * DICT_MAX_LOAD / 100, DICT_CHAINED);
+}
+
+//--------------------------------------------------------//
+dict_t* dict_CreateWithCapacity(keyType_t kt, int capacity)
 {
-    keyType_t kt;                   ///> The key type.
-    list_t* bins[DICT_NUM_BINS];    ///> List data is kv_t.
-};
+    return dict_CreateEx(kt, capacity, DICT_CHAINED);
+}
 
-/// Make hash from string and bin it.
-/// @param s The string.
-/// @return Hash value between 0 and DICT_NUM_BINS.
-static unsigned int p_HashString(const char* s);
+//--------------------------------------------------------//
+dict_t* dict_CreateEx(keyType_t kt, int capacity, unsigned int opts)
+{
+    return p_Create(kt, capacity, opts, 0);
+}
 
-/// Make hash from int and bin it.
-/// @param i The int.
-/// @return Hash value between 0 and DICT_NUM_BINS.
-static unsigned int p_HashInt(int i);
+//--------------------------------------------------------//
+dict_t* dict_CreateInline(keyType_t kt, size_t value_size)
+{
+    return dict_CreateInlineEx(kt, DICT_DEFAULT_BINS * DICT_MAX_LOAD / 100, DICT_OPEN, value_size);
+}
 
-/// Convert client to internal format.
-/// @param kt Type.
-/// @param k Key itself.
-/// @return New pointer to thing.
-static kv_t* p_ConvertKey(keyType_t kt, key_t k);
+//--------------------------------------------------------//
+dict_t* dict_CreateInlineEx(keyType_t kt, int capacity, unsigned int opts, size_t value_size)
+{
+    // Zero would be a pointer dict.
+    return value_size > 0 ? p_Create(kt, capacity, opts, value_size) : BAD_PTR;
+}
 
-//---------------- Public API Implementation -------------//
+//--------------------------------------------------------//
+size_t dict_StaticSize(int max_entries, size_t key_bytes)
+{
+    unsigned int num_bins;
 
+    return max_entries > 0 ? p_StaticTable(max_entries, &num_bins) + key_bytes : 0;
+}
 
 //--------------------------------------------------------//
-dict_t* dict_Create(keyType_t kt)
+dict_t* dict_InitStatic(void* buf, size_t bytes, keyType_t kt, int max_entries)
 {
-    CREATE_INST(d, dict_t);
+    VAL_PTR(buf, BAD_PTR);
 
-    // Initialize.
-    d->kt = kt;
+    unsigned int num_bins;
+    size_t table = max_entries > 0 ? p_StaticTable(max_entries, &num_bins) : 0;
 
-    for(int i = 0; i < DICT_NUM_BINS; i++)
+    if(table == 0 || bytes < table || (size_t)buf % 8 != 0)
     {
-        list_t* l = list_Create();
-        VAL_PTR(l, BAD_PTR);
-        d->bins[i] = l;
+        return BAD_PTR;
     }
 
+    // Carve it up: dict, hashes, slots, key chunk.
+    unsigned char* p = (unsigned char*)buf;
+    memset(p, 0, table);
+
+    dict_t* d = (dict_t*)p;
+    p += (sizeof(dict_t) + 7) / 8 * 8;
+    d->hashes = (unsigned long long*)p;
+    p += num_bins * sizeof(unsigned long long);
+    d->slots = p;
+    p += num_bins * sizeof(kv_t);
+    d->keys = (chunk_t*)p;
+    d->keys->size = bytes - table;
+
+    d->kt = kt;
+    d->opts = DICT_OPEN | DICT_ARENA | DICT_STATIC;
+    d->hash_func = dict_HashFast;
+    p_SetSize(d, num_bins);
+    d->min_bins = num_bins;
+    d->stride = sizeof(kv_t);
+    d->max_count = max_entries;
+
     return d;
 }
 
@@ -77,13 +353,43 @@ int dict_Destroy(dict_t* d)
 
     int ret = RS_PASS;
 
+    // Nothing in it is ours but the mapping.
+    if(d->opts & DICT_MAPPED)
+    {
+        d->unmap(d->map, d->map_size);
+        FREE(d);
+        return ret;
+    }
+
     // Clean up user data.
+    d->opts &= ~DICT_FROZEN;
     dict_Clear(d);
 
-    // Remove all bins.
-    for(int i = 0; i < DICT_NUM_BINS; i++)
+    // Client owns it all.
+    if(d->opts & DICT_STATIC)
+    {
+        return ret;
+    }
+
+    // Remove the table.
+    if(d->opts & DICT_OPEN)
+    {
+        FREE(d->hashes);
+        FREE(d->slots);
+
+        if(d->opts & DICT_GROUP)
+        {
+            FREE(d->ctrl);
+        }
+    }
+    else
+    {
+        FREE(d->bins);
+    }
+
+    if(d->filter != NULL)
     {
-        list_Destroy(d->bins[i]);
+        FREE(d->filter);
     }
 
     FREE(d);
@@ -96,292 +402,1942 @@ int dict_Clear(dict_t* d)
 {
     VAL_PTR(d, RS_ERR);
 
+    if(d->opts & DICT_FROZEN)
+    {
+        return RS_ERR;
+    }
+
     int ret = RS_PASS;
 
-    for(int i = 0; i < DICT_NUM_BINS; i++)
-    {
-        list_t* pl = d->bins[i]; // shorthand
-        VAL_PTR(pl, RS_ERR);
+    // Simpler with everything in one place and it is all getting visited anyway.
+    p_RehashStep(d, d->old_num_bins);
+
+    // Open tables that own no memory per entry can just be wiped.
+    bool wipe = (d->opts & DICT_OPEN) && (d->value_size > 0 || (d->opts & DICT_STATIC)) &&
+                (d->kt == KEY_INT || d->kt == KEY_U64 || (d->opts & DICT_ARENA));
 
-        // Remove custom user data.
-        kv_t* kv;
-        list_IterStart(pl);
+    if(wipe)
+    {
+        memset(d->hashes, 0, d->num_bins * sizeof(unsigned long long));
+    }
 
-        while(RS_PASS == list_IterNext(pl, (void**)&kv))
+    for(unsigned int i = 0; i < d->num_bins && !wipe; i++)
+    {
+        if(d->opts & DICT_OPEN)
         {
-            VAL_PTR(kv, RS_ERR);
-            if(d->kt == KEY_STRING && kv->skey != NULL)
+            if(d->hashes[i] != 0)
             {
-                FREE(kv->skey);
-                kv->skey = NULL;
+                p_FreeKv(d, p_Slot(d, i));
+                d->hashes[i] = 0;
             }
+        }
+        else
+        {
+            link_t* link = d->bins[i];
 
-            if(kv->value != NULL)
+            while(link != NULL)
             {
-                FREE(kv->value);
-                kv->value = NULL;
+                link_t* next = link->next;
+                p_FreeKv(d, &link->kv);
+                FREE(link);
+                link = next;
             }
 
-            // kv gets freed in list_clear()
+            d->bins[i] = NULL;
         }
+    }
+
+    d->count = 0;
+    p_ArenaFree(d);
+
+    if(d->opts & DICT_GROUP)
+    {
+        memset(d->ctrl, DICT_CTRL_EMPTY, d->num_bins + DICT_GROUP_SIZE);
+    }
 
-        ret = list_Clear(pl);
+    // Give back the memory from growing.
+    if(d->num_bins > d->min_bins)
+    {
+        ret = p_Resize(d, d->min_bins);
+    }
+    else if(d->opts & DICT_FILTER)
+    {
+        p_FilterBuild(d);
     }
 
     return ret;
 }
 
 //--------------------------------------------------------//
-int dict_Count(dict_t* d)
+int dict_Freeze(dict_t* d)
 {
     VAL_PTR(d, RS_ERR);
 
-    int ret = 0;
-    for(int i = 0; i < DICT_NUM_BINS && ret >= 0; i++)
+    int ret = RS_PASS;
+
+    if(!(d->opts & DICT_FROZEN))
     {
-        int cnt = list_Count(d->bins[i]);
-        if(cnt >= 0)
+        // Finish any move and drop the room left for growing.
+        p_RehashStep(d, d->old_num_bins);
+
+        unsigned int num_bins = p_BinsFor(d->opts, d->count);
+        if(num_bins < d->num_bins && !(d->opts & DICT_STATIC))
         {
-            ret += cnt;
+            ret = p_Resize(d, num_bins);
+            p_RehashStep(d, d->old_num_bins);
+            d->min_bins = num_bins;
         }
-        else
+        else if((d->opts & DICT_FILTER) && d->filter_stale > 0)
         {
-            ret = cnt; // ng
+            p_FilterBuild(d);
         }
+
+        d->opts |= DICT_FROZEN;
     }
 
     return ret;
 }
 
 //--------------------------------------------------------//
-int dict_Set(dict_t* d, key_t k, void* v)
+int dict_Count(dict_t* d)
 {
     VAL_PTR(d, RS_ERR);
-    VAL_PTR(v, RS_ERR);
 
-    int ret = RS_PASS;
+    return d->count;
+}
+
+//--------------------------------------------------------//
+int dict_GetStats(dict_t* d, dict_stats_t* stats)
+{
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(stats, RS_ERR);
 
+    memset(stats, 0, sizeof(dict_stats_t));
+    stats->count = d->count;
+    stats->num_bins = d->num_bins;
+    stats->load = (double)d->count / d->num_bins;
+    stats->resizes = d->resizes;
 
-    // If it is in a bin already, replace the value.
-    unsigned int bin = d->kt == KEY_STRING ? p_HashString(k.ks) : p_HashInt(k.ki);
-    list_t* pl = d->bins[bin]; // shorthand
-    VAL_PTR(pl, RS_ERR);
+    // Look at where everything is without moving anything.
+    if(d->opts & DICT_OPEN)
+    {
+        for(unsigned int i = 0; i < d->num_bins; i++)
+        {
+            if(d->hashes[i] != 0)
+            {
+                unsigned int probe = ((i - p_Bin(d->shift, d->hashes[i])) & (d->num_bins - 1)) + 1;
+                p_StatsEntry(d, stats, d->opts & DICT_MAPPED ? NULL : p_Slot(d, i), probe);
+            }
+        }
+    }
+    else
+    {
+        for(unsigned int i = 0; i < d->num_bins; i++)
+        {
+            unsigned int probe = 1;
+            for(link_t* link = d->bins[i]; link != NULL; link = link->next)
+            {
+                p_StatsEntry(d, stats, &link->kv, probe++);
+            }
+        }
+
+        for(unsigned int i = d->rehash_idx; d->old_bins != NULL && i < d->old_num_bins; i++)
+        {
+            unsigned int probe = 1;
+            for(link_t* link = d->old_bins[i]; link != NULL; link = link->next)
+            {
+                p_StatsEntry(d, stats, &link->kv, probe++);
+            }
+        }
+    }
 
-    list_IterStart(pl);
-    kv_t* lkv;
-    bool found = false;
+    stats->mean_probe = d->count > 0 ? stats->mean_probe / d->count : 0;
 
-    while(RS_PASS == list_IterNext(pl, (void**)&lkv) && !found)
+    // Add up the rest of the memory.
+    if(d->opts & DICT_MAPPED)
+    {
+        stats->bytes += sizeof(dict_t) + d->map_size;
+    }
+    else if(d->opts & DICT_STATIC)
     {
-        VAL_PTR(lkv, RS_ERR);
+        // The whole client buffer.
+        unsigned int num_bins;
+        stats->bytes += p_StaticTable(d->max_count, &num_bins) + d->keys->size;
+    }
+    else
+    {
+        stats->bytes += sizeof(dict_t);
 
-        if(d->kt == KEY_STRING)
+        if(d->opts & DICT_OPEN)
         {
-            found = (strcmp(lkv->skey, k.ks) == 0);
+            stats->bytes += (size_t)d->num_bins * (sizeof(unsigned long long) + d->stride);
+            stats->bytes += d->opts & DICT_GROUP ? d->num_bins + DICT_GROUP_SIZE : 0;
         }
-        else // KEY_INT
+        else
+        {
+            stats->bytes += (size_t)(d->num_bins + (d->old_bins != NULL ? d->old_num_bins : 0)) * sizeof(link_t*);
+            stats->bytes += (size_t)d->count * (offsetof(link_t, kv) + d->stride);
+        }
+
+        for(chunk_t* chunk = d->keys; chunk != NULL; chunk = chunk->next)
         {
-            found = (lkv->ikey == k.ki);
+            stats->bytes += sizeof(chunk_t) + chunk->size;
         }
+    }
+
+    if(d->opts & DICT_FILTER)
+    {
+        // A miss gets past if all its bits are set. That depends on how full its block is.
+        double fp = 0;
 
-        if(found)
+        for(unsigned int b = 0; b < d->filter_blocks; b++)
         {
-            // Need to FREE the original data then copy from the new..
-            if(lkv->value != NULL)
+            unsigned int set = 0;
+            for(int w = 0; w < DICT_FILTER_BLOCK; w++)
             {
-                FREE(lkv->value);
+                set += p_PopCount(d->filter[b * DICT_FILTER_BLOCK + w]);
             }
-            lkv->value = v;
+            fp += pow((double)set / (DICT_FILTER_BLOCK * 64), DICT_FILTER_HASHES);
         }
+
+        stats->filter_bytes = (size_t)d->filter_blocks * DICT_FILTER_BLOCK * sizeof(unsigned long long);
+        stats->filter_fp_rate = fp / d->filter_blocks;
+        stats->bytes += stats->filter_bytes;
     }
 
-    // Not in a bin so add.
-    if(!found)
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int dict_SetHash(dict_t* d, dict_HashFunc_t hash_func, unsigned long long seed)
+{
+    VAL_PTR(d, RS_ERR);
+
+    if(d->opts & DICT_FROZEN)
     {
-        // Pack into our internal format.
-        kv_t* kv = p_ConvertKey(d->kt, k);
-        kv->value = v;
+        return RS_ERR;
+    }
+    VAL_PTR(hash_func, RS_ERR);
+
+    int ret = RS_PASS;
 
-        list_Append(pl, (void*)kv);
+    // Existing entries would be in the wrong place.
+    if(d->count > 0)
+    {
+        ret = RS_ERR;
+    }
+    else
+    {
+        d->hash_func = hash_func;
+        d->seed = seed;
     }
 
     return ret;
 }
 
 //--------------------------------------------------------//
-int dict_Get(dict_t* d, key_t k, void** v)
+unsigned long long dict_HashFast(const void* data, size_t len, unsigned long long seed)
 {
-    VAL_PTR(d, RS_ERR);
-
-    int ret = RS_FAIL;
+    // The short input path of xxHash64 (https://github.com/Cyan4973/xxHash) applied to any length.
+    static const unsigned long long PRIME1 = 0x9E3779B185EBCA87ULL;
+    static const unsigned long long PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    static const unsigned long long PRIME3 = 0x165667B19E3779F9ULL;
+    static const unsigned long long PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    static const unsigned long long PRIME5 = 0x27D4EB2F165667C5ULL;
 
-    // Is it in the bin?
-    unsigned int bin = d->kt == KEY_STRING ? p_HashString(k.ks) : p_HashInt(k.ki);
-    list_t* pl = d->bins[bin]; // shorthand
+    const unsigned char* p = (const unsigned char*)data;
+    unsigned long long hash = seed + PRIME5 + (unsigned long long)len;
 
-    list_IterStart(pl);
-    kv_t* lkv;
-    bool found = false;
+    for(; len >= 8; len -= 8, p += 8)
+    {
+        unsigned long long k = p_Rotl(p_Read64(p) * PRIME2, 31) * PRIME1;
+        hash = p_Rotl(hash ^ k, 27) * PRIME1 + PRIME4;
+    }
 
-    while(RS_PASS == list_IterNext(pl, (void**)&lkv) && !found)
+    if(len >= 4)
     {
-        VAL_PTR(lkv, RS_ERR);
+        hash = p_Rotl(hash ^ (p_Read32(p) * PRIME1), 23) * PRIME2 + PRIME3;
+        len -= 4;
+        p += 4;
+    }
 
-        if(d->kt == KEY_STRING)
-        {
-            if(strcmp(lkv->skey, k.ks) == 0)
-            {
-                ret = RS_PASS;
-                *v = lkv->value;
-                found = true;
-            }
-        }
-        else // KEY_INT
-        {
-            if(lkv->ikey == k.ki)
-            {
-                ret = RS_PASS;
-                *v = lkv->value;
-                found = true;
-            }
-        }
+    for(; len > 0; len--, p++)
+    {
+        hash = p_Rotl(hash ^ (*p * PRIME5), 11) * PRIME1;
     }
 
-    return ret;
+    // Avalanche.
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
 }
 
 //--------------------------------------------------------//
-list_t* dict_GetKeys(dict_t* d)
+unsigned long long dict_HashSip(const void* data, size_t len, unsigned long long seed)
 {
-    VAL_PTR(d, BAD_PTR);
+    // SipHash-2-4 (https://www.aumasson.jp/siphash/siphash.pdf). The key is the seed and a scramble of it.
+    #define SIPROUND \
+    { \
+        v0 += v1; v1 = p_Rotl(v1, 13); v1 ^= v0; v0 = p_Rotl(v0, 32); \
+        v2 += v3; v3 = p_Rotl(v3, 16); v3 ^= v2; \
+        v0 += v3; v3 = p_Rotl(v3, 21); v3 ^= v0; \
+        v2 += v1; v1 = p_Rotl(v1, 17); v1 ^= v2; v2 = p_Rotl(v2, 32); \
+    }
 
-    list_t* l = list_Create();
-    VAL_PTR(l, BAD_PTR);
-    
-    for(int i = 0; i < DICT_NUM_BINS; i++)
+    const unsigned char* p = (const unsigned char*)data;
+    unsigned long long k0 = seed;
+    unsigned long long k1 = p_Mix(seed);
+    unsigned long long v0 = k0 ^ 0x736F6D6570736575ULL;
+    unsigned long long v1 = k1 ^ 0x646F72616E646F6DULL;
+    unsigned long long v2 = k0 ^ 0x6C7967656E657261ULL;
+    unsigned long long v3 = k1 ^ 0x7465646279746573ULL;
+    unsigned long long last = (unsigned long long)len << 56;
+
+    for(; len >= 8; len -= 8, p += 8)
     {
-        list_t* pl = d->bins[i]; // shorthand
-        VAL_PTR(pl, BAD_PTR);
+        unsigned long long m = p_Read64(p);
+        v3 ^= m;
+        SIPROUND;
+        SIPROUND;
+        v0 ^= m;
+    }
 
-        list_IterStart(pl);
+    for(size_t i = 0; i < len; i++)
+    {
+        last |= (unsigned long long)p[i] << (8 * i);
+    }
 
-        kv_t* kv;
+    v3 ^= last;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= last;
 
-        while(RS_PASS == list_IterNext(pl, (void**)&kv))
-        {
-            VAL_PTR(kv, BAD_PTR);
-            if(d->kt == KEY_STRING)
-            {
-                // Copy only.
-                VAL_PTR(kv->skey, BAD_PTR);
-                CREATE_STR(s, strlen(kv->skey));
-                strcpy(s, kv->skey);
-                list_Append(l, s);
-            }
-            else // KEY_INT
-            {
-                CREATE_INST(pi, int);
-                list_Append(l, pi);
-            }
-        }
-    }
+    v2 ^= 0xFF;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
 
-    return l;
+    #undef SIPROUND
+
+    return v0 ^ v1 ^ v2 ^ v3;
 }
 
 //--------------------------------------------------------//
-int dict_Dump(dict_t* d, FILE* fp)
+int dict_Set(dict_t* d, key_t k, void* v)
 {
     VAL_PTR(d, RS_ERR);
-    VAL_PTR(fp, RS_ERR);
-
-    int ret = RS_PASS;
-
-    // Preamble.
-    fprintf(fp, "type,bins,total\n");
-    fprintf(fp, "%d,%d,%d\n\n", d->kt, DICT_NUM_BINS, dict_Count(d));
 
-    // Content.
-    fprintf(fp, "bin,num,key0,key1,key2\n");
+    if(d->opts & DICT_FROZEN)
+    {
+        return RS_ERR;
+    }
+    VAL_PTR(v, RS_ERR);
 
-    for(int i = 0; i < DICT_NUM_BINS; i++)
+    if(!p_KeyOk(d, k))
     {
-        list_t* pl = d->bins[i]; // shorthand
-        VAL_PTR(pl, RS_ERR);
+        return RS_ERR;
+    }
 
-        fprintf(fp, "%d,%d", i, list_Count(pl));
+    int ret = RS_PASS;
 
-        list_IterStart(pl);
+    p_RehashStep(d, DICT_REHASH_BINS);
 
-        for(int k = 0; k < (int)fmin(list_Count(pl), 3); k++)
-        {
-            fprintf(fp, ",");
-            kv_t* kv;
-            list_IterNext(pl, (void**)&kv);
+    // If it is in a bin already, replace the value.
+    cursor_t cur;
+    unsigned long long hash = p_HashKey(d, k);
+    kv_t* lkv = p_Find(d, k, hash, &cur);
 
-            if(d->kt == KEY_STRING)
-            {
-                // Output and fix embedded commas, poorly.
-                for(int ci = 0; ci < strlen(kv->skey); ci++)
-                {
-                    char c = kv->skey[ci];
-                    fprintf(fp, "%c", c == ',' ? '#' : c);
-                }
-            }
-            else // KEY_INT
-            {
-                fprintf(fp, "%d", kv->ikey);
-            }
-        }
+    if(lkv == NULL) // Not in a bin so add.
+    {
+        lkv = p_Insert(d, k, hash, &cur);
+    }
 
-        fprintf(fp, "\n");
+    if(lkv == NULL)
+    {
+        // Static and full.
+        ret = RS_FAIL;
+    }
+    else
+    {
+        p_PutValue(d, lkv, v);
     }
 
     return ret;
 }
 
-//---------------- Private Implementation --------------------------//
-
 //--------------------------------------------------------//
-unsigned int p_HashString(const char* s)
+int dict_GetOrInsert(dict_t* d, key_t k, void*** slot, bool* inserted)
 {
-    // Lifted from http://www.cse.yorku.ca/~oz/hash.html.
-    unsigned long long hash = 5381;
-    int c;
+    VAL_PTR(d, RS_ERR);
+
+    if(d->opts & DICT_FROZEN)
+    {
+        return RS_ERR;
+    }
+    VAL_PTR(slot, RS_ERR);
+    VAL_PTR(inserted, RS_ERR);
+
+    if(!p_KeyOk(d, k))
+    {
+        return RS_ERR;
+    }
+
+    p_RehashStep(d, DICT_REHASH_BINS);
+
+    cursor_t cur;
+    unsigned long long hash = p_HashKey(d, k);
+    kv_t* lkv = p_Find(d, k, hash, &cur);
+
+    *inserted = lkv == NULL;
+    if(lkv == NULL)
+    {
+        lkv = p_Insert(d, k, hash, &cur);
+    }
 
-    while ((c = *s++))
+    // Static and full.
+    if(lkv == NULL)
     {
-        // djb2
-        hash = ((hash << 5) + hash) + c; // aka: hash * 33 + c 
-        // djb2 revised: hash = hash(i - 1) * 33 ^ str[i];
+        *inserted = false;
+        return RS_FAIL;
     }
 
-    return (unsigned int)(hash % DICT_NUM_BINS);
+    *slot = d->value_size > 0 ? (void**)p_Value(d, lkv) : &lkv->value;
+
+    return RS_PASS;
 }
 
 //--------------------------------------------------------//
-unsigned int p_HashInt(int i)
+int dict_Get(dict_t* d, key_t k, void** v)
 {
-    // Simple "hash".
-    return (unsigned int)(i % DICT_NUM_BINS);
+    VAL_PTR(d, RS_ERR);
+
+    if(!p_KeyOk(d, k))
+    {
+        return RS_ERR;
+    }
+
+    int ret = RS_FAIL;
+
+    // Is it in the bin?
+    kv_t mkv;
+    kv_t* lkv = NULL;
+    unsigned long long hash = p_HashKey(d, k);
+
+    // The filter can say it is definitely not there.
+    if(!(d->opts & DICT_FILTER) || p_FilterMaybe(d, hash))
+    {
+        lkv = d->opts & DICT_MAPPED ? p_MappedFind(d, k, hash, &mkv) : p_Find(d, k, hash, NULL);
+    }
+
+    if(lkv != NULL)
+    {
+        ret = RS_PASS;
+        *v = p_Value(d, lkv);
+    }
+
+    return ret;
 }
 
 //--------------------------------------------------------//
-kv_t* p_ConvertKey(keyType_t kt, key_t k)
+int dict_GetMany(dict_t* d, const key_t* keys, int n, void** values, int* status)
 {
-    // Pack into our preferred format.
-    CREATE_INST(kv, kv_t);
-    if(kt == KEY_STRING)
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(keys, RS_ERR);
+    VAL_PTR(values, RS_ERR);
+    VAL_PTR(status, RS_ERR);
+
+    for(int i = 0; d->kt == KEY_BYTES && i < n; i++)
     {
-        CREATE_STR(s, strlen(k.ks));
-        strcpy(s, k.ks);
-        kv->skey = s;
-        kv->ikey = 0;
+        if(!p_KeyOk(d, keys[i]))
+        {
+            return RS_ERR;
+        }
     }
-    else
+
+    unsigned long long hashes[DICT_BATCH];
+    kv_t mkv;
+
+    for(int base = 0; base < n; base += DICT_BATCH)
     {
-        kv->skey = NULL;
-        kv->ikey = k.ki;
+        int num = n - base < DICT_BATCH ? n - base : DICT_BATCH;
+
+        // Hash them all and start fetching where each one lives, or its filter block first if there is one.
+        for(int j = 0; j < num; j++)
+        {
+            hashes[j] = p_HashKey(d, keys[base + j]);
+
+            if(d->opts & DICT_FILTER)
+            {
+                DICT_PREFETCH(p_FilterBlock(d, hashes[j]));
+            }
+            else
+            {
+                p_PrefetchBin(d, hashes[j]);
+            }
+        }
+
+        // Drop the ones the filter rules out, marked with a hash of 0, and fetch the table for the rest.
+        if(d->opts & DICT_FILTER)
+        {
+            for(int j = 0; j < num; j++)
+            {
+                if(p_FilterMaybe(d, hashes[j]))
+                {
+                    p_PrefetchBin(d, hashes[j]);
+                }
+                else
+                {
+                    hashes[j] = 0;
+                }
+            }
+        }
+
+        // Chains need the head pointer before the first link can be fetched. By now it should be here.
+        if(!(d->opts & DICT_OPEN))
+        {
+            for(int j = 0; j < num; j++)
+            {
+                link_t* link = hashes[j] != 0 ? d->bins[p_Bin(d->shift, hashes[j])] : NULL;
+                if(link != NULL)
+                {
+                    DICT_PREFETCH(link);
+                }
+            }
+        }
+
+        // Now the lookups should mostly hit cache.
+        for(int j = 0; j < num; j++)
+        {
+            kv_t* lkv = NULL;
+
+            if(hashes[j] != 0)
+            {
+                lkv = d->opts & DICT_MAPPED ?
+                    p_MappedFind(d, keys[base + j], hashes[j], &mkv) :
+                    p_Find(d, keys[base + j], hashes[j], NULL);
+            }
+
+            values[base + j] = lkv != NULL ? p_Value(d, lkv) : NULL;
+            status[base + j] = lkv != NULL ? RS_PASS : RS_FAIL;
+        }
+    }
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int dict_Remove(dict_t* d, key_t k, void** v)
+{
+    VAL_PTR(d, RS_ERR);
+
+    if(d->opts & DICT_FROZEN)
+    {
+        return RS_ERR;
+    }
+    VAL_PTR(v, RS_ERR);
+
+    if(!p_KeyOk(d, k))
+    {
+        return RS_ERR;
+    }
+
+    int ret = RS_FAIL;
+
+    p_RehashStep(d, DICT_REHASH_BINS);
+
+    cursor_t cur;
+    unsigned long long hash = p_HashKey(d, k);
+    kv_t* lkv = (d->opts & DICT_FILTER) && !p_FilterMaybe(d, hash) ? NULL : p_Find(d, k, hash, &cur);
+
+    if(lkv != NULL)
+    {
+        // Client owns the value now.
+        *v = p_TakeValue(d, lkv);
+        p_RemoveCurrent(d, &cur);
+        ret = RS_PASS;
+
+        // Give back memory if it has mostly emptied out.
+        if(d->num_bins > d->min_bins &&
+           (unsigned long long)d->count * 100 * DICT_SHRINK_RATIO < (unsigned long long)d->num_bins * p_MaxLoad(d->opts))
+        {
+            ret = p_Resize(d, d->num_bins / 2);
+        }
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+list_t* dict_GetKeys(dict_t* d)
+{
+    VAL_PTR(d, BAD_PTR);
+
+    list_t* l = list_Create();
+    VAL_PTR(l, BAD_PTR);
+
+    cursor_t cur;
+    kv_t* kv;
+
+    p_Begin(d, &cur);
+    while((kv = p_Next(d, &cur)) != NULL)
+    {
+        if(d->kt == KEY_STRING)
+        {
+            // Copy only.
+            CREATE_STR(s, strlen(p_KeyStr(kv)));
+            strcpy(s, p_KeyStr(kv));
+            list_Append(l, s);
+        }
+        else if(d->kt == KEY_BYTES)
+        {
+            // The bytes follow the header.
+            size_t len;
+            const char* b = p_KeyBytes(kv, &len);
+            kbytes_t* pb = (kbytes_t*)calloc(1, sizeof(kbytes_t) + len);
+            _CREATE(pb);
+            memcpy(pb + 1, b, len);
+            pb->data = pb + 1;
+            pb->len = len;
+            list_Append(l, pb);
+        }
+        else if(d->kt == KEY_U64)
+        {
+            CREATE_INST(pu, unsigned long long);
+            *pu = kv->key.ukey;
+            list_Append(l, pu);
+        }
+        else // KEY_INT
+        {
+            CREATE_INST(pi, int);
+            *pi = kv->key.ikey;
+            list_Append(l, pi);
+        }
+    }
+
+    return l;
+}
+
+//--------------------------------------------------------//
+int dict_IterStart(dict_t* d)
+{
+    VAL_PTR(d, RS_ERR);
+
+    p_Begin(d, &d->iter);
+
+    return d->count > 0 ? RS_PASS : RS_FAIL;
+}
+
+//--------------------------------------------------------//
+int dict_IterNext(dict_t* d, key_t* k, void** v)
+{
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(k, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    int ret = RS_FAIL;
+
+    kv_t* kv = p_Next(d, &d->iter);
+
+    if(kv != NULL)
+    {
+        if(d->kt == KEY_STRING)
+        {
+            k->ks = p_KeyStr(kv);
+        }
+        else if(d->kt == KEY_BYTES)
+        {
+            d->iter_key.data = p_KeyBytes(kv, &d->iter_key.len);
+            k->kb = &d->iter_key;
+        }
+        else if(d->kt == KEY_U64)
+        {
+            k->ku = kv->key.ukey;
+        }
+        else // KEY_INT
+        {
+            k->ki = kv->key.ikey;
+        }
+
+        *v = p_Value(d, kv);
+        ret = RS_PASS;
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int dict_IterRemove(dict_t* d, void** v)
+{
+    VAL_PTR(d, RS_ERR);
+
+    if(d->opts & DICT_FROZEN)
+    {
+        return RS_ERR;
+    }
+    VAL_PTR(v, RS_ERR);
+
+    int ret = RS_PASS;
+
+    if(!d->iter.valid)
+    {
+        ret = RS_ERR;
+    }
+    else
+    {
+        // Client owns the value now.
+        kv_t* kv = d->opts & DICT_OPEN ?
+            p_Slot(d, (d->iter.start + d->iter.step - 1) & (d->num_bins - 1)) :
+            &(*d->iter.where)->kv;
+        *v = p_TakeValue(d, kv);
+
+        p_RemoveCurrent(d, &d->iter);
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int dict_Dump(dict_t* d, FILE* fp)
+{
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(fp, RS_ERR);
+
+    int ret = RS_PASS;
+
+    // Show the settled table.
+    p_RehashStep(d, d->old_num_bins);
+
+    // Preamble.
+    dict_stats_t stats;
+    dict_GetStats(d, &stats);
+    fprintf(fp, "type,bins,total,load,max_probe,mean_probe,bytes,resizes\n");
+    fprintf(fp, "%d,%u,%d,%.3f,%u,%.3f,%llu,%u\n\n", d->kt, d->num_bins, d->count, stats.load, stats.max_probe,
+            stats.mean_probe, (unsigned long long)stats.bytes, stats.resizes);
+
+    // Content. For DICT_OPEN a bin is one slot.
+    fprintf(fp, "bin,num,key0,key1,key2\n");
+
+    for(unsigned int i = 0; i < d->num_bins; i++)
+    {
+        // Gather what's in this bin.
+        kv_t* kvs[3];
+        kv_t mkv;
+        int num = 0;
+
+        if(d->opts & DICT_OPEN)
+        {
+            if(d->hashes[i] != 0)
+            {
+                kvs[num] = d->opts & DICT_MAPPED ? p_MappedKv(d, i, &mkv) : p_Slot(d, i);
+                num += kvs[num] != NULL ? 1 : 0;
+            }
+        }
+        else
+        {
+            for(link_t* link = d->bins[i]; link != NULL; link = link->next)
+            {
+                if(num < 3)
+                {
+                    kvs[num] = &link->kv;
+                }
+                num++;
+            }
+        }
+
+        fprintf(fp, "%u,%d", i, num);
+
+        for(int k = 0; k < (int)fmin(num, 3); k++)
+        {
+            fprintf(fp, ",");
+
+            if(d->kt == KEY_STRING)
+            {
+                // Output and fix embedded commas, poorly.
+                const char* ks = p_KeyStr(kvs[k]);
+                for(size_t ci = 0; ci < strlen(ks); ci++)
+                {
+                    char c = ks[ci];
+                    fprintf(fp, "%c", c == ',' ? '#' : c);
+                }
+            }
+            else if(d->kt == KEY_BYTES)
+            {
+                size_t len;
+                const char* b = p_KeyBytes(kvs[k], &len);
+                for(size_t bi = 0; bi < len; bi++)
+                {
+                    fprintf(fp, "%02x", (unsigned char)b[bi]);
+                }
+            }
+            else if(d->kt == KEY_U64)
+            {
+                fprintf(fp, "%llu", kvs[k]->key.ukey);
+            }
+            else // KEY_INT
+            {
+                fprintf(fp, "%d", kvs[k]->key.ikey);
+            }
+        }
+
+        fprintf(fp, "\n");
+    }
+
+    return ret;
+}
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+dict_t* p_Create(keyType_t kt, int capacity, unsigned int opts, size_t value_size)
+{
+    // Only chains can be moved a bin at a time.
+    if(capacity < 0 || ((opts & DICT_INCREMENTAL) && (opts & (DICT_OPEN | DICT_GROUP))))
+    {
+        return BAD_PTR;
+    }
+
+    CREATE_INST(d, dict_t);
+
+    // Group probing is a refinement of open addressing.
+    if(opts & DICT_GROUP)
+    {
+        opts |= DICT_OPEN;
+    }
+
+    // Initialize.
+    d->kt = kt;
+    d->opts = opts;
+    d->hash_func = dict_HashFast;
+    d->seed = 0;
+    d->count = 0;
+    p_SetSize(d, p_BinsFor(opts, capacity));
+    d->min_bins = d->num_bins;
+    d->value_size = value_size;
+
+    // Inline values overlay the value pointer, and keep the next entry aligned.
+    d->stride = offsetof(kv_t, value) + (value_size + 7) / 8 * 8;
+    d->stride = d->stride > sizeof(kv_t) ? d->stride : sizeof(kv_t);
+
+    if(opts & DICT_OPEN)
+    {
+        CREATE_ARR(hashes, unsigned long long, d->num_bins);
+        CREATE_ARR(slots, unsigned char, d->num_bins * d->stride);
+        d->hashes = hashes;
+        d->slots = slots;
+
+        if(opts & DICT_GROUP)
+        {
+            p_CreateCtrl(d);
+        }
+    }
+    else
+    {
+        CREATE_ARR(bins, link_t*, d->num_bins);
+        d->bins = bins;
+    }
+
+    if(opts & DICT_FILTER)
+    {
+        p_FilterBuild(d);
+    }
+
+    return d;
+}
+
+//--------------------------------------------------------//
+size_t p_StaticTable(int max_entries, unsigned int* num_bins)
+{
+    *num_bins = p_BinsFor(DICT_STATIC, max_entries);
+
+    return (sizeof(dict_t) + 7) / 8 * 8 + *num_bins * (sizeof(unsigned long long) + sizeof(kv_t)) + sizeof(chunk_t);
+}
+
+//--------------------------------------------------------//
+bool p_HasRoom(dict_t* d, key_t k)
+{
+    bool room = d->count < d->max_count;
+
+    if(room && d->kt == KEY_STRING)
+    {
+        size_t len = strlen(k.ks);
+        room = len < DICT_INLINE_KEY || d->keys->size - d->keys->used > len;
+    }
+    else if(room && d->kt == KEY_BYTES)
+    {
+        room = k.kb->len <= DICT_INLINE_BYTES || d->keys->size - d->keys->used >= k.kb->len;
+    }
+
+    return room;
+}
+
+//--------------------------------------------------------//
+void p_FilterBuild(dict_t* d)
+{
+    // Enough for a full table.
+    unsigned long long bits = (unsigned long long)d->num_bins * p_MaxLoad(d->opts) / 100 * DICT_FILTER_BITS;
+    unsigned int blocks = 1;
+
+    while((unsigned long long)blocks * DICT_FILTER_BLOCK * 64 < bits)
+    {
+        blocks *= 2;
+    }
+
+    if(blocks != d->filter_blocks)
+    {
+        if(d->filter != NULL)
+        {
+            FREE(d->filter);
+        }
+
+        CREATE_ARR(filter, unsigned long long, (size_t)blocks * DICT_FILTER_BLOCK);
+        d->filter = filter;
+        d->filter_blocks = blocks;
+    }
+    else
+    {
+        memset(d->filter, 0, (size_t)blocks * DICT_FILTER_BLOCK * sizeof(unsigned long long));
+    }
+
+    d->filter_stale = 0;
+
+    // From the saved hashes, in both tables if a move is going on.
+    if(d->opts & DICT_OPEN)
+    {
+        for(unsigned int i = 0; i < d->num_bins; i++)
+        {
+            if(d->hashes[i] != 0)
+            {
+                p_FilterAdd(d, d->hashes[i]);
+            }
+        }
+    }
+    else
+    {
+        for(unsigned int i = 0; i < d->num_bins; i++)
+        {
+            for(link_t* link = d->bins[i]; link != NULL; link = link->next)
+            {
+                p_FilterAdd(d, link->hash);
+            }
+        }
+
+        for(unsigned int i = d->rehash_idx; d->old_bins != NULL && i < d->old_num_bins; i++)
+        {
+            for(link_t* link = d->old_bins[i]; link != NULL; link = link->next)
+            {
+                p_FilterAdd(d, link->hash);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------//
+void p_FilterAdd(dict_t* d, unsigned long long hash)
+{
+    unsigned long long* block = p_FilterBlock(d, hash);
+    unsigned long long bits = p_Mix(hash);
+
+    // 9 bits pick one of the 512 in the block.
+    for(int i = 0; i < DICT_FILTER_HASHES; i++, bits >>= 9)
+    {
+        block[(bits >> 6) & (DICT_FILTER_BLOCK - 1)] |= 1ULL << (bits & 63);
+    }
+}
+
+//--------------------------------------------------------//
+bool p_FilterMaybe(dict_t* d, unsigned long long hash)
+{
+    unsigned long long* block = p_FilterBlock(d, hash);
+    unsigned long long bits = p_Mix(hash);
+    bool maybe = true;
+
+    for(int i = 0; i < DICT_FILTER_HASHES && maybe; i++, bits >>= 9)
+    {
+        maybe = (block[(bits >> 6) & (DICT_FILTER_BLOCK - 1)] & (1ULL << (bits & 63))) != 0;
+    }
+
+    return maybe;
+}
+
+//--------------------------------------------------------//
+unsigned long long* p_FilterBlock(dict_t* d, unsigned long long hash)
+{
+    // Low bits, where p_Bin() uses the spread high bits.
+    return d->filter + (size_t)(hash & (d->filter_blocks - 1)) * DICT_FILTER_BLOCK;
+}
+
+//--------------------------------------------------------//
+void p_PrefetchBin(dict_t* d, unsigned long long hash)
+{
+    unsigned int bin = p_Bin(d->shift, hash);
+
+    if(d->opts & DICT_OPEN)
+    {
+        DICT_PREFETCH(&d->hashes[bin]);
+        DICT_PREFETCH(d->opts & DICT_MAPPED ? (const void*)&d->mslots[bin] : (const void*)p_Slot(d, bin));
+        if(d->opts & DICT_GROUP)
+        {
+            DICT_PREFETCH(&d->ctrl[bin]);
+        }
+    }
+    else
+    {
+        DICT_PREFETCH(&d->bins[bin]);
+    }
+}
+
+//--------------------------------------------------------//
+void p_StatsEntry(dict_t* d, dict_stats_t* stats, kv_t* kv, unsigned int probe)
+{
+    stats->probe_hist[(probe < DICT_STATS_HIST ? probe : DICT_STATS_HIST) - 1]++;
+    stats->max_probe = probe > stats->max_probe ? probe : stats->max_probe;
+    stats->mean_probe += probe; // Divided at the end.
+
+    // Long keys have their own allocation unless in the arena, which is counted whole.
+    if(kv != NULL && p_OwnKey(d, kv))
+    {
+        stats->bytes += d->kt == KEY_STRING ? strlen(kv->key.skey) + 1 : kv->key.bkey.len;
+    }
+}
+
+//--------------------------------------------------------//
+unsigned int p_PopCount(unsigned long long x)
+{
+#if defined(__GNUC__)
+    return (unsigned int)__builtin_popcountll(x);
+#else
+    unsigned int n = 0;
+    for(; x != 0; x &= x - 1)
+    {
+        n++;
+    }
+    return n;
+#endif
+}
+
+//--------------------------------------------------------//
+kv_t* p_Slot(dict_t* d, unsigned int i)
+{
+    return (kv_t*)(d->slots + (size_t)i * d->stride);
+}
+
+//--------------------------------------------------------//
+kv_t* p_MappedKv(dict_t* d, unsigned int i, kv_t* kv)
+{
+    const mslot_t* slot = &d->mslots[i];
+
+    if(slot->entry >= (unsigned int)d->count || (d->kt == KEY_STRING && slot->key >= d->mkeys_size))
+    {
+        return NULL;
+    }
+
+    if(d->kt == KEY_STRING)
+    {
+        // Same as an out of line key.
+        kv->key.skey = (char*)d->mkeys + slot->key;
+        kv->key.inl[DICT_INLINE_KEY - 1] = 1;
+    }
+    else // KEY_INT
+    {
+        kv->key.ikey = (int)slot->key;
+    }
+
+    kv->value = (void*)(d->mvalues + (size_t)slot->entry * ((d->value_size + 7) / 8 * 8));
+
+    return kv;
+}
+
+//--------------------------------------------------------//
+kv_t* p_MappedFind(dict_t* d, key_t k, unsigned long long hash, kv_t* kv)
+{
+    kv_t* lkv = NULL;
+    unsigned int mask = d->num_bins - 1;
+    unsigned int at = p_Bin(d->shift, hash);
+
+    // As DICT_OPEN but a bad image might have no empty slot, so give up after looking at all of them.
+    for(unsigned int n = 0; n < d->num_bins && d->hashes[at] != 0 && lkv == NULL; n++)
+    {
+        if(d->hashes[at] == hash && p_MappedKv(d, at, kv) != NULL && p_Match(d, kv, k))
+        {
+            lkv = kv;
+        }
+
+        at = (at + 1) & mask;
+    }
+
+    return lkv;
+}
+
+//--------------------------------------------------------//
+void* p_Value(dict_t* d, kv_t* kv)
+{
+    // Entries made from an image point at their value.
+    return d->value_size > 0 && !(d->opts & DICT_MAPPED) ? (void*)&kv->value : kv->value;
+}
+
+//--------------------------------------------------------//
+void* p_TakeValue(dict_t* d, kv_t* kv)
+{
+    void* v = NULL;
+
+    if(d->value_size == 0)
+    {
+        v = kv->value;
+        kv->value = NULL;
+    }
+
+    return v;
+}
+
+//--------------------------------------------------------//
+unsigned long long p_Read64(const unsigned char* p)
+{
+    return p_Read32(p) | (p_Read32(p + 4) << 32);
+}
+
+//--------------------------------------------------------//
+unsigned long long p_Read32(const unsigned char* p)
+{
+    return (unsigned long long)p[0] | ((unsigned long long)p[1] << 8) |
+           ((unsigned long long)p[2] << 16) | ((unsigned long long)p[3] << 24);
+}
+
+//--------------------------------------------------------//
+unsigned long long p_Rotl(unsigned long long x, int b)
+{
+    return (x << b) | (x >> (64 - b));
+}
+
+//--------------------------------------------------------//
+unsigned long long p_Mix(unsigned long long x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+//--------------------------------------------------------//
+unsigned long long p_HashKey(dict_t* d, key_t k)
+{
+    unsigned long long hash;
+
+    switch(d->kt)
+    {
+        case KEY_STRING:
+            hash = d->hash_func(k.ks, strlen(k.ks), d->seed);
+            break;
+
+        case KEY_BYTES:
+            hash = d->hash_func(k.kb->data, k.kb->len, d->seed);
+            break;
+
+        case KEY_U64:
+            // One mix of the value does as well as hashing its bytes, unless the client picked the hash.
+            hash = d->hash_func == dict_HashFast ? p_Mix(k.ku ^ d->seed) : d->hash_func(&k.ku, sizeof(k.ku), d->seed);
+            break;
+
+        default: // KEY_INT
+            hash = d->hash_func(&k.ki, sizeof(k.ki), d->seed);
+            break;
+    }
+
+    return hash != 0 ? hash : 1;
+}
+
+//--------------------------------------------------------//
+unsigned int p_Bin(unsigned int shift, unsigned long long hash)
+{
+    return (unsigned int)((hash * DICT_HASH_SPREAD) >> shift);
+}
+
+//--------------------------------------------------------//
+unsigned char p_Tag(dict_t* d, unsigned long long hash)
+{
+    return (unsigned char)(((hash * DICT_HASH_SPREAD) >> (d->shift - 7)) & 0x7F);
+}
+
+//--------------------------------------------------------//
+void p_SetCtrl(dict_t* d, unsigned int i, unsigned char c)
+{
+    d->ctrl[i] = c;
+
+    // The copy lets a group that starts near the end read straight through. Tiny tables wrap more than once.
+    for(unsigned int j = i; j < DICT_GROUP_SIZE; j += d->num_bins)
+    {
+        d->ctrl[d->num_bins + j] = c;
+    }
+}
+
+//--------------------------------------------------------//
+unsigned int p_GroupMatch(const unsigned char* ctrl, unsigned char c)
+{
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    // No movemask so weight each lane by its bit and add across.
+    static const uint8_t weights[DICT_GROUP_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t eq = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(c));
+    uint8x16_t bits = vandq_u8(eq, vld1q_u8(weights));
+    return (unsigned int)vaddv_u8(vget_low_u8(bits)) | ((unsigned int)vaddv_u8(vget_high_u8(bits)) << 8);
+#else
+    unsigned int match = 0;
+    for(unsigned int n = 0; n < DICT_GROUP_SIZE; n++)
+    {
+        match |= (ctrl[n] == c) ? (1u << n) : 0;
+    }
+    return match;
+#endif
+}
+
+//--------------------------------------------------------//
+unsigned int p_LowBit(unsigned int m)
+{
+#if defined(__GNUC__)
+    return (unsigned int)__builtin_ctz(m);
+#else
+    unsigned int n = 0;
+    while((m & 1) == 0)
+    {
+        m >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+//--------------------------------------------------------//
+void p_CreateCtrl(dict_t* d)
+{
+    CREATE_ARR(ctrl, unsigned char, d->num_bins + DICT_GROUP_SIZE);
+    memset(ctrl, DICT_CTRL_EMPTY, d->num_bins + DICT_GROUP_SIZE);
+    d->ctrl = ctrl;
+}
+
+//--------------------------------------------------------//
+bool p_Match(dict_t* d, kv_t* kv, key_t k)
+{
+    switch(d->kt)
+    {
+        case KEY_STRING:
+            return strcmp(p_KeyStr(kv), k.ks) == 0;
+
+        case KEY_BYTES:
+        {
+            size_t len;
+            const char* b = p_KeyBytes(kv, &len);
+            return len == k.kb->len && memcmp(b, k.kb->data, len) == 0;
+        }
+
+        case KEY_U64:
+            return kv->key.ukey == k.ku;
+
+        default: // KEY_INT
+            return kv->key.ikey == k.ki;
+    }
+}
+
+//--------------------------------------------------------//
+bool p_KeyOk(dict_t* d, key_t k)
+{
+    return d->kt != KEY_BYTES || (k.kb != NULL && k.kb->len <= UINT_MAX);
+}
+
+//--------------------------------------------------------//
+kv_t* p_Find(dict_t* d, key_t k, unsigned long long hash, cursor_t* cur)
+{
+    kv_t* lkv = NULL;
+    unsigned int mask = d->num_bins - 1;
+    unsigned int at = 0; // DICT_OPEN: where it is or the empty slot where it would go.
+
+    if(d->opts & DICT_GROUP)
+    {
+        // Same linear probe order as DICT_OPEN but a group at a time. Only slots with the
+        // right tag get a closer look. Stop at the first group with an empty slot.
+        unsigned char tag = p_Tag(d, hash);
+        bool done = false;
+
+        for(unsigned int pos = p_Bin(d->shift, hash); !done; pos = (pos + DICT_GROUP_SIZE) & mask)
+        {
+            unsigned int match = p_GroupMatch(&d->ctrl[pos], tag);
+
+            while(match != 0 && lkv == NULL)
+            {
+                at = (pos + p_LowBit(match)) & mask;
+                if(d->hashes[at] == hash && p_Match(d, p_Slot(d, at), k))
+                {
+                    lkv = p_Slot(d, at);
+                }
+                match &= match - 1;
+            }
+
+            unsigned int empty = p_GroupMatch(&d->ctrl[pos], DICT_CTRL_EMPTY);
+            if(lkv == NULL && empty != 0)
+            {
+                // The first empty of the first group that has one is the first empty in probe order.
+                at = (pos + p_LowBit(empty)) & mask;
+            }
+
+            done = lkv != NULL || empty != 0;
+        }
+    }
+    else if(d->opts & DICT_OPEN)
+    {
+        // Linear probe until an empty slot. Cheap hash compare first.
+        at = p_Bin(d->shift, hash);
+
+        while(d->hashes[at] != 0 && lkv == NULL)
+        {
+            if(d->hashes[at] == hash && p_Match(d, p_Slot(d, at), k))
+            {
+                lkv = p_Slot(d, at);
+            }
+            else
+            {
+                at = (at + 1) & mask;
+            }
+        }
+    }
+    else
+    {
+        link_t** where = p_FindLink(d, &d->bins[p_Bin(d->shift, hash)], k, hash);
+
+        // Could still be in a bin that hasn't moved yet.
+        if(*where == NULL && d->old_bins != NULL)
+        {
+            unsigned int bin = p_Bin(d->old_shift, hash);
+            if(bin >= d->rehash_idx)
+            {
+                link_t** old_where = p_FindLink(d, &d->old_bins[bin], k, hash);
+                where = *old_where != NULL ? old_where : where;
+            }
+        }
+
+        lkv = *where != NULL ? &(*where)->kv : NULL;
+
+        if(cur != NULL)
+        {
+            cur->where = where;
+        }
+    }
+
+    if(cur != NULL)
+    {
+        // As if a walk just stepped past it.
+        cur->start = at;
+        cur->step = 1;
+        cur->valid = lkv != NULL;
+    }
+
+    return lkv;
+}
+
+//--------------------------------------------------------//
+kv_t* p_Insert(dict_t* d, key_t k, unsigned long long hash, cursor_t* cur)
+{
+    kv_t* kv;
+
+    if((d->opts & DICT_STATIC) && !p_HasRoom(d, k))
+    {
+        return NULL;
+    }
+
+    // Make room first so the new entry doesn't get moved.
+    if((unsigned long long)(d->count + 1) * 100 > (unsigned long long)d->num_bins * p_MaxLoad(d->opts))
+    {
+        p_Resize(d, d->num_bins * 2);
+        cur = NULL;
+    }
+
+    if(d->opts & DICT_OPEN)
+    {
+        unsigned int mask = d->num_bins - 1;
+        unsigned int i = cur != NULL ? cur->start : p_Bin(d->shift, hash);
+
+        while(d->hashes[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+
+        d->hashes[i] = hash;
+        kv = p_Slot(d, i);
+
+        if(d->opts & DICT_GROUP)
+        {
+            p_SetCtrl(d, i, p_Tag(d, hash));
+        }
+    }
+    else
+    {
+        // Inline value goes on the end.
+        link_t* link = (link_t*)calloc(1, offsetof(link_t, kv) + d->stride);
+        _CREATE(link);
+        unsigned int bin = p_Bin(d->shift, hash);
+        link->hash = hash;
+        link->next = d->bins[bin];
+        d->bins[bin] = link;
+        kv = &link->kv;
+    }
+
+    // Pack into our internal format.
+    p_ConvertKey(d, k, kv);
+    memset(&kv->value, 0, d->stride - offsetof(kv_t, value));
+    d->count++;
+
+    if(d->opts & DICT_FILTER)
+    {
+        p_FilterAdd(d, hash);
+    }
+
+    return kv;
+}
+
+//--------------------------------------------------------//
+int p_Resize(dict_t* d, unsigned int num_bins)
+{
+    // Only one move at a time.
+    p_RehashStep(d, d->old_num_bins);
+
+    unsigned int old_num_bins = d->num_bins;
+    unsigned int old_shift = d->shift;
+    p_SetSize(d, num_bins);
+    d->resizes++;
+
+    if(d->opts & DICT_OPEN)
+    {
+        unsigned long long* old_hashes = d->hashes;
+        unsigned char* old_slots = d->slots;
+
+        CREATE_ARR(hashes, unsigned long long, num_bins);
+        CREATE_ARR(slots, unsigned char, (size_t)num_bins * d->stride);
+        d->hashes = hashes;
+        d->slots = slots;
+
+        unsigned char* old_ctrl = d->ctrl;
+        if(d->opts & DICT_GROUP)
+        {
+            p_CreateCtrl(d);
+        }
+
+        // Reinsert using the saved hashes.
+        unsigned int mask = num_bins - 1;
+
+        for(unsigned int i = 0; i < old_num_bins; i++)
+        {
+            if(old_hashes[i] != 0)
+            {
+                unsigned int j = p_Bin(d->shift, old_hashes[i]);
+
+                while(hashes[j] != 0)
+                {
+                    j = (j + 1) & mask;
+                }
+
+                hashes[j] = old_hashes[i];
+                memcpy(slots + (size_t)j * d->stride, old_slots + (size_t)i * d->stride, d->stride);
+
+                if(d->opts & DICT_GROUP)
+                {
+                    p_SetCtrl(d, j, p_Tag(d, hashes[j]));
+                }
+            }
+        }
+
+        FREE(old_hashes);
+        FREE(old_slots);
+
+        if(d->opts & DICT_GROUP)
+        {
+            FREE(old_ctrl);
+        }
+    }
+    else
+    {
+        CREATE_ARR(bins, link_t*, num_bins);
+        d->old_bins = d->bins;
+        d->old_num_bins = old_num_bins;
+        d->old_shift = old_shift;
+        d->rehash_idx = 0;
+        d->bins = bins;
+
+        // Move it all now unless the client wants it spread out over the next operations.
+        if(!(d->opts & DICT_INCREMENTAL) || d->count == 0)
+        {
+            p_RehashStep(d, old_num_bins);
+        }
+    }
+
+    // Resized to suit the new table, and a chance to drop removed keys.
+    if(d->opts & DICT_FILTER)
+    {
+        p_FilterBuild(d);
+    }
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+void p_RehashStep(dict_t* d, unsigned int num)
+{
+    // Relink every entry into its new bin using the saved hashes.
+    for(; num > 0 && d->old_bins != NULL; num--)
+    {
+        link_t* link = d->old_bins[d->rehash_idx];
+
+        while(link != NULL)
+        {
+            link_t* next = link->next;
+            unsigned int bin = p_Bin(d->shift, link->hash);
+            link->next = d->bins[bin];
+            d->bins[bin] = link;
+            link = next;
+        }
+
+        d->old_bins[d->rehash_idx++] = NULL;
+
+        if(d->rehash_idx >= d->old_num_bins)
+        {
+            FREE(d->old_bins);
+            d->old_bins = NULL;
+            d->old_num_bins = 0;
+        }
+    }
+}
+
+//--------------------------------------------------------//
+link_t** p_FindLink(dict_t* d, link_t** where, key_t k, unsigned long long hash)
+{
+    while(*where != NULL && !((*where)->hash == hash && p_Match(d, &(*where)->kv, k)))
+    {
+        where = &(*where)->next;
+    }
+
+    return where;
+}
+
+//--------------------------------------------------------//
+void p_SetSize(dict_t* d, unsigned int num_bins)
+{
+    unsigned int bits = 0;
+
+    while((1u << bits) < num_bins)
+    {
+        bits++;
+    }
+
+    d->num_bins = num_bins;
+    d->shift = 64 - bits;
+}
+
+//--------------------------------------------------------//
+unsigned int p_BinsFor(unsigned int opts, int capacity)
+{
+    unsigned int num_bins = DICT_MIN_BINS;
+
+    while((unsigned long long)num_bins * p_MaxLoad(opts) < (unsigned long long)capacity * 100)
+    {
+        num_bins *= 2;
+    }
+
+    return num_bins;
+}
+
+//--------------------------------------------------------//
+unsigned int p_MaxLoad(unsigned int opts)
+{
+    if(opts & (DICT_STATIC | DICT_MAPPED))
+    {
+        return DICT_MAX_LOAD_STATIC;
+    }
+
+    return (opts & DICT_OPEN) ? DICT_MAX_LOAD_OPEN : DICT_MAX_LOAD;
+}
+
+//--------------------------------------------------------//
+void p_Begin(dict_t* d, cursor_t* cur)
+{
+    // Walking two tables that are changing underneath is no fun. Costs the same as the walk anyway.
+    p_RehashStep(d, d->old_num_bins);
+
+    cur->bin = 0;
+    cur->where = d->bins != NULL ? &d->bins[0] : NULL;
+    cur->start = 0;
+    cur->step = 0;
+    cur->valid = false;
+
+    // Images can't be changed during a walk so start anywhere. Also a bad one might not have an empty slot.
+    if((d->opts & DICT_OPEN) && !(d->opts & DICT_MAPPED))
+    {
+        // There is always at least one empty slot.
+        while(d->hashes[cur->start] != 0)
+        {
+            cur->start++;
+        }
+        cur->start = (cur->start + 1) & (d->num_bins - 1);
+    }
+}
+
+//--------------------------------------------------------//
+kv_t* p_Next(dict_t* d, cursor_t* cur)
+{
+    kv_t* kv = NULL;
+
+    if(d->opts & DICT_OPEN)
+    {
+        unsigned int mask = d->num_bins - 1;
+
+        for(; cur->step < d->num_bins && kv == NULL; cur->step++)
+        {
+            unsigned int i = (cur->start + cur->step) & mask;
+            if(d->hashes[i] != 0)
+            {
+                kv = d->opts & DICT_MAPPED ? p_MappedKv(d, i, &cur->kv) : p_Slot(d, i);
+            }
+        }
+    }
+    else if(cur->where != NULL)
+    {
+        // Move past the current one unless it was removed and where already points at the next.
+        if(cur->valid)
+        {
+            cur->where = &(*cur->where)->next;
+        }
+
+        // Look for the next chain if this one is done.
+        while(cur->where != NULL && *cur->where == NULL)
+        {
+            cur->bin++;
+            cur->where = cur->bin < d->num_bins ? &d->bins[cur->bin] : NULL;
+        }
+
+        kv = cur->where != NULL ? &(*cur->where)->kv : NULL;
+    }
+
+    cur->valid = kv != NULL;
+
+    return kv;
+}
+
+//--------------------------------------------------------//
+void p_RemoveCurrent(dict_t* d, cursor_t* cur)
+{
+    if(d->opts & DICT_OPEN)
+    {
+        // Whatever shifts back into this slot comes from later in the walk, so look at it again.
+        cur->step--;
+        unsigned int i = (cur->start + cur->step) & (d->num_bins - 1);
+        p_FreeKv(d, p_Slot(d, i));
+        p_RemoveSlot(d, i);
+    }
+    else
+    {
+        // Unlink. where now points at the next one.
+        link_t* link = *cur->where;
+        *cur->where = link->next;
+        p_FreeKv(d, &link->kv);
+        FREE(link);
+    }
+
+    cur->valid = false;
+    d->count--;
+
+    // Keys can't be taken out of the filter. Start again once there are a lot of them, which costs about the
+    // same per remove as the remove.
+    if(d->opts & DICT_FILTER)
+    {
+        d->filter_stale++;
+        if(d->filter_stale > d->num_bins / 2)
+        {
+            p_FilterBuild(d);
+        }
+    }
+}
+
+//--------------------------------------------------------//
+void p_RemoveSlot(dict_t* d, unsigned int i)
+{
+    unsigned int mask = d->num_bins - 1;
+    unsigned int hole = i;
+
+    for(unsigned int j = (i + 1) & mask; d->hashes[j] != 0; j = (j + 1) & mask)
+    {
+        // An entry can fill the hole only if its home is not between the hole and where it is now.
+        unsigned int home = p_Bin(d->shift, d->hashes[j]);
+        if(((j - home) & mask) >= ((j - hole) & mask))
+        {
+            d->hashes[hole] = d->hashes[j];
+            memcpy(p_Slot(d, hole), p_Slot(d, j), d->stride);
+            if(d->opts & DICT_GROUP)
+            {
+                p_SetCtrl(d, hole, d->ctrl[j]);
+            }
+            hole = j;
+        }
+    }
+
+    d->hashes[hole] = 0;
+    memset(p_Slot(d, hole), 0, d->stride);
+    if(d->opts & DICT_GROUP)
+    {
+        p_SetCtrl(d, hole, DICT_CTRL_EMPTY);
+    }
+}
+
+//--------------------------------------------------------//
+void p_FreeKv(dict_t* d, kv_t* kv)
+{
+    // Arena keys go when the whole arena does.
+    if(p_OwnKey(d, kv))
+    {
+        FREE(kv->key.skey);
+    }
+    memset(&kv->key, 0, sizeof(kv->key));
+
+    if(d->value_size == 0 && !(d->opts & DICT_STATIC) && kv->value != NULL)
+    {
+        FREE(kv->value);
+        kv->value = NULL;
+    }
+}
+
+//--------------------------------------------------------//
+void p_ConvertKey(dict_t* d, key_t k, kv_t* kv)
+{
+    // Pack into our preferred format.
+    memset(&kv->key, 0, sizeof(kv->key));
+
+    if(d->kt == KEY_STRING)
+    {
+        size_t len = strlen(k.ks);
+
+        if(len < DICT_INLINE_KEY)
+        {
+            memcpy(kv->key.inl, k.ks, len + 1);
+        }
+        else
+        {
+            if(d->opts & DICT_ARENA)
+            {
+                kv->key.skey = p_ArenaCopy(&d->keys, k.ks, len + 1);
+            }
+            else
+            {
+                CREATE_STR(s, len);
+                memcpy(s, k.ks, len + 1);
+                kv->key.skey = s;
+            }
+
+            // Mark as not inline. The pointer is only 8 bytes so this doesn't touch it.
+            kv->key.inl[DICT_INLINE_KEY - 1] = 1;
+        }
+    }
+    else if(d->kt == KEY_BYTES)
+    {
+        if(k.kb->len <= DICT_INLINE_BYTES)
+        {
+            memcpy(kv->key.inl, k.kb->data, k.kb->len);
+            kv->key.inl[DICT_INLINE_KEY - 2] = (char)k.kb->len;
+        }
+        else
+        {
+            if(d->opts & DICT_ARENA)
+            {
+                kv->key.bkey.data = p_ArenaCopy(&d->keys, k.kb->data, k.kb->len);
+            }
+            else
+            {
+                CREATE_ARR(b, char, k.kb->len);
+                memcpy(b, k.kb->data, k.kb->len);
+                kv->key.bkey.data = b;
+            }
+
+            // Pointer and length are 12 bytes, clear of the marker.
+            kv->key.bkey.len = (unsigned int)k.kb->len;
+            kv->key.inl[DICT_INLINE_KEY - 1] = 1;
+        }
+    }
+    else if(d->kt == KEY_U64)
+    {
+        kv->key.ukey = k.ku;
+    }
+    else // KEY_INT
+    {
+        kv->key.ikey = k.ki;
+    }
+}
+
+//--------------------------------------------------------//
+const char* p_KeyStr(const kv_t* kv)
+{
+    return kv->key.inl[DICT_INLINE_KEY - 1] == 0 ? kv->key.inl : kv->key.skey;
+}
+
+//--------------------------------------------------------//
+const char* p_KeyBytes(const kv_t* kv, size_t* len)
+{
+    bool inl = kv->key.inl[DICT_INLINE_KEY - 1] == 0;
+    *len = inl ? (unsigned char)kv->key.inl[DICT_INLINE_KEY - 2] : kv->key.bkey.len;
+    return inl ? kv->key.inl : kv->key.bkey.data;
+}
+
+//--------------------------------------------------------//
+bool p_OwnKey(dict_t* d, const kv_t* kv)
+{
+    return (d->kt == KEY_STRING || d->kt == KEY_BYTES) && kv->key.inl[DICT_INLINE_KEY - 1] != 0 &&
+           !(d->opts & DICT_ARENA);
+}
+
+//--------------------------------------------------------//
+char* p_ArenaCopy(chunk_t** keys, const void* data, size_t len)
+{
+    chunk_t* chunk = *keys;
+
+    if(chunk == NULL || chunk->size - chunk->used < len)
+    {
+        size_t size = len > DICT_ARENA_CHUNK ? len : DICT_ARENA_CHUNK;
+        chunk_t* fresh = (chunk_t*)calloc(1, sizeof(chunk_t) + size + 1);
+        _CREATE(fresh);
+        fresh->size = size;
+
+        if(chunk != NULL && size > DICT_ARENA_CHUNK)
+        {
+            // Oversize key. Keep filling the current chunk after it.
+            fresh->next = chunk->next;
+            chunk->next = fresh;
+        }
+        else
+        {
+            fresh->next = chunk;
+            *keys = fresh;
+        }
+
+        chunk = fresh;
+    }
+
+    char* s = chunk->data + chunk->used;
+    memcpy(s, data, len);
+    chunk->used += len;
+
+    return s;
+}
+
+//--------------------------------------------------------//
+void p_ArenaFree(dict_t* d)
+{
+    // Client memory, just start over.
+    if(d->opts & DICT_STATIC)
+    {
+        d->keys->used = 0;
+        return;
+    }
+
+    p_ArenaRelease(&d->keys);
+}
+
+//--------------------------------------------------------//
+void p_ArenaRelease(chunk_t** keys)
+{
+    while(*keys != NULL)
+    {
+        chunk_t* next = (*keys)->next;
+        FREE(*keys);
+        *keys = next;
+    }
+}
+
+//--------------------------------------------------------//
+void p_PutValue(dict_t* d, kv_t* kv, void* v)
+{
+    if(d->value_size > 0)
+    {
+        // Copy in, client keeps theirs.
+        memcpy(p_Value(d, kv), v, d->value_size);
+    }
+    else
+    {
+        // Need to FREE the original data then copy from the new..
+        if(kv->value != NULL && !(d->opts & DICT_STATIC))
+        {
+            FREE(kv->value);
+        }
+        kv->value = v;
+    }
+}
+
+//--------------------------------------------------------//
+void p_Reserve(dict_t* d, int n)
+{
+    // Finish any move, then make room for everything now so no bin moves while the workers fill them.
+    p_RehashStep(d, d->old_num_bins);
+    unsigned int num_bins = p_BinsFor(d->opts, d->count + n);
+
+    if(num_bins > d->num_bins)
+    {
+        p_Resize(d, num_bins);
+        p_RehashStep(d, d->old_num_bins);
+    }
+}
+
+//--------------------------------------------------------//
+kv_t* p_AddInRange(dict_t* d, key_t k, unsigned long long hash, unsigned int hi, bool* added)
+{
+    unsigned int bin = p_Bin(d->shift, hash);
+    kv_t* kv;
+
+    *added = false;
+
+    if(d->opts & DICT_OPEN)
+    {
+        // Same probe as p_Find() and p_Insert() but not past the range. The next one isn't ours.
+        unsigned int at = bin;
+
+        while(at < hi && d->hashes[at] != 0 && !(d->hashes[at] == hash && p_Match(d, p_Slot(d, at), k)))
+        {
+            at++;
+        }
+
+        if(at == hi)
+        {
+            return NULL;
+        }
+
+        kv = p_Slot(d, at);
+
+        if(d->hashes[at] == 0)
+        {
+            d->hashes[at] = hash;
+            if(d->opts & DICT_GROUP)
+            {
+                p_SetCtrl(d, at, p_Tag(d, hash));
+            }
+
+            p_ConvertKey(d, k, kv);
+            memset(&kv->value, 0, d->stride - offsetof(kv_t, value));
+            *added = true;
+        }
+    }
+    else
+    {
+        link_t** where = p_FindLink(d, &d->bins[bin], k, hash);
+
+        if(*where == NULL)
+        {
+            // On the end of the chain, where the search stopped.
+            link_t* link = (link_t*)calloc(1, offsetof(link_t, kv) + d->stride);
+            _CREATE(link);
+            link->hash = hash;
+            p_ConvertKey(d, k, &link->kv);
+            *where = link;
+            *added = true;
+        }
+
+        kv = &(*where)->kv;
     }
 
     return kv;
@@ -0,0 +1,780 @@
+#ifndef _WIN32
+// fseeko() and 64 bit file offsets on 32 bit platforms.
+#define _POSIX_C_SOURCE 200112L
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "dict.h"
+#include "dict_private.h"
+
+
+/// @brief Definition of the dict bulk loaders dict_SetMany() and dict_LoadFile(). Kept apart from dict.c
+/// because they need pthreads. Leave this file out where there are none and those two are all that is missing.
+
+
+//---------------- Private Declarations ------------------//
+
+/// dict_LoadFile(): bytes each worker reads at a time. A longer line grows its buffer.
+#define DICT_READ_SIZE (1 << 20)
+
+/// dict_LoadFile(): bytes per chunk of a worker's copies of keys and inline values.
+#define DICT_STORE_CHUNK (1 << 20)
+
+/// 64 bit file positions, so files over 2G work where long is 32 bits.
+#ifdef _WIN32
+#define DICT_SEEK(fp, off, whence) _fseeki64(fp, (long long)(off), whence)
+#define DICT_TELL(fp) ((long long)_ftelli64(fp))
+#else
+#define DICT_SEEK(fp, off, whence) fseeko(fp, (off_t)(off), whence)
+#define DICT_TELL(fp) ((long long)ftello(fp))
+#endif
+
+/// One input, hashed.
+typedef struct entry
+{
+    unsigned long long hash;    ///> Of the key.
+    key_t key;                  ///> As given or parsed.
+    void* value;                ///> As given or parsed.
+} entry_t;
+
+/// dict_SetMany() and dict_LoadFile(): the whole job.
+typedef struct bulk
+{
+    dict_t* d;                      ///> Being filled.
+    const key_t* keys;              ///> dict_SetMany(): the input.
+    void* const* values;            ///> dict_SetMany(): the input.
+    entry_t* entries;               ///> The inputs made into entries, a piece per worker.
+    entry_t** sorted;               ///> All the entries, grouped by the worker whose bins they go in, in input order.
+    int* counts;                    ///> Row per worker: how many of its entries go to each worker, then where in sorted.
+    int n;                          ///> Number of inputs.
+    int num_threads;                ///> Number of workers.
+    const char* path;               ///> dict_LoadFile(): the file.
+    dict_ParseFunc_t parse;         ///> dict_LoadFile(): client parser.
+    void* ctx;                      ///> dict_LoadFile(): for parse.
+} bulk_t;
+
+/// dict_SetMany() and dict_LoadFile(): what one thread does.
+typedef struct worker
+{
+    bulk_t* b;              ///> The job.
+    int index;              ///> Which worker it is.
+    int first;              ///> dict_SetMany(): first input it hashes.
+    int last;               ///> dict_SetMany(): one past the last.
+    long long begin;        ///> dict_LoadFile(): file offset of its first line.
+    long long end;          ///> dict_LoadFile(): one past its last line.
+    entry_t* in;            ///> Entries it made. dict_SetMany(): from first on in the shared ones.
+    int num_in;             ///> Number of them. Skipped lines make none.
+    int cap_in;             ///> dict_LoadFile(): room in its own in.
+    chunk_t* store;         ///> dict_LoadFile(): copies of the keys and inline values of its lines.
+    void* scratch;          ///> dict_LoadFile(): inline dicts, where parse puts a value.
+    unsigned int lo;        ///> First bin it fills.
+    unsigned int hi;        ///> One past the last.
+    int start;              ///> Its entries in sorted, the ones for bins lo to hi.
+    int stop;               ///> One past the last.
+    chunk_t* keys;          ///> DICT_ARENA: its key storage, added to the dict's after.
+    int added;              ///> New entries.
+    entry_t** spill;        ///> DICT_OPEN: entries whose probe ran past hi, added after.
+    int num_spill;          ///> Number in spill.
+    int cap_spill;          ///> Room in spill.
+    int ret;                ///> RS_PASS | RS_ERR.
+    pthread_t thread;       ///> Runs it, unless that is the caller's.
+    bool threaded;          ///> thread was started.
+} worker_t;
+
+/// dict_SetMany() and dict_LoadFile(): make the workers, each with an equal share of the inputs.
+/// @param b The job.
+/// @param num_threads How many.
+/// @return The workers.
+static worker_t* p_Workers(bulk_t* b, int num_threads);
+
+/// dict_SetMany() and dict_LoadFile(): run a step on all the workers, one in this thread, and wait for them.
+/// @param workers The workers.
+/// @param num How many.
+/// @param func The step.
+/// @return RS_PASS | RS_ERR if any failed.
+static int p_RunWorkers(worker_t* workers, int num, void* (*func)(void*));
+
+/// dict_SetMany() and dict_LoadFile(): size the table for all the entries, sort them by the worker whose range of
+/// bins they go in, let each worker fill its range, then gather up what they did.
+/// @param b The job, hashed.
+/// @param workers The workers.
+/// @return RS_PASS.
+static int p_Fill(bulk_t* b, worker_t* workers);
+
+/// Which worker fills the bin of a hash. Worker t has bins from t * num_bins / num_threads, rounded up.
+/// @param d The dictionary, sized.
+/// @param num_threads Number of workers.
+/// @param hash Full hash value.
+/// @return The worker.
+static int p_Owner(dict_t* d, int num_threads, unsigned long long hash);
+
+/// Worker step: hash a share of dict_SetMany() inputs.
+/// @param arg The worker_t.
+/// @return NULL.
+static void* p_HashWorker(void* arg);
+
+/// dict_LoadFile(): where the line after a file offset starts.
+/// @param fp The file.
+/// @param from Offset.
+/// @param size Of the file.
+/// @return Offset just past the next end of line | size if there is none.
+static long long p_NextLine(FILE* fp, long long from, long long size);
+
+/// Worker step: read, parse and hash the lines of a piece of a dict_LoadFile() file.
+/// @param arg The worker_t.
+/// @return NULL.
+static void* p_ParseWorker(void* arg);
+
+/// dict_LoadFile(): parse one line into a new entry with its own copies of the key and inline value.
+/// @param w The worker.
+/// @param line The line, terminated.
+/// @param stop Its terminator.
+static void p_ParseLine(worker_t* w, char* line, char* stop);
+
+/// dict_LoadFile(): space in the worker's store, pointer aligned. Freed by p_FreeParsed().
+/// @param w The worker.
+/// @param len Bytes.
+/// @return The space.
+static void* p_Store(worker_t* w, size_t len);
+
+/// dict_LoadFile(): free what a worker parsed, and the values too if the dict didn't get them.
+/// @param w The worker.
+/// @param fail The load failed.
+static void p_FreeParsed(worker_t* w, bool fail);
+
+/// Worker step: count its entries for each worker.
+/// @param arg The worker_t.
+/// @return NULL.
+static void* p_CountWorker(void* arg);
+
+/// Worker step: put its entries in sorted, each in the part of the worker that fills its bin.
+/// @param arg The worker_t.
+/// @return NULL.
+static void* p_ScatterWorker(void* arg);
+
+/// Worker step: add its part of sorted, whose bins are all in its range.
+/// @param arg The worker_t.
+/// @return NULL.
+static void* p_FillWorker(void* arg);
+
+/// DICT_OPEN: remember an entry whose probe ran out of the worker's range.
+/// @param w The worker.
+/// @param e The entry.
+static void p_Spill(worker_t* w, entry_t* e);
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+int dict_SetMany(dict_t* d, const key_t* keys, int n, void* const* values, int num_threads)
+{
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(keys, RS_ERR);
+    VAL_PTR(values, RS_ERR);
+
+    if((d->opts & (DICT_FROZEN | DICT_STATIC)) || n < 0 || num_threads < 1)
+    {
+        return RS_ERR;
+    }
+
+    if(n == 0)
+    {
+        return RS_PASS;
+    }
+
+    // No more workers than entries.
+    num_threads = num_threads < DICT_MAX_THREADS ? num_threads : DICT_MAX_THREADS;
+    num_threads = num_threads < n ? num_threads : n;
+
+    CREATE_ARR(entries, entry_t, n);
+
+    bulk_t b;
+    memset(&b, 0, sizeof(b));
+    b.d = d;
+    b.keys = keys;
+    b.values = values;
+    b.entries = entries;
+    b.n = n;
+
+    worker_t* workers = p_Workers(&b, num_threads);
+
+    // A NULL value fails the lot before anything changes.
+    int ret = p_RunWorkers(workers, num_threads, p_HashWorker);
+
+    if(ret == RS_PASS)
+    {
+        ret = p_Fill(&b, workers);
+    }
+
+    FREE(workers);
+    FREE(entries);
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int dict_LoadFile(dict_t* d, const char* path, dict_ParseFunc_t parse, void* ctx, int num_threads)
+{
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(path, RS_ERR);
+    VAL_PTR(parse, RS_ERR);
+
+    if((d->opts & (DICT_FROZEN | DICT_STATIC)) || num_threads < 1)
+    {
+        return RS_ERR;
+    }
+
+    num_threads = num_threads < DICT_MAX_THREADS ? num_threads : DICT_MAX_THREADS;
+
+    FILE* fp = fopen(path, "rb");
+    VAL_PTR(fp, RS_ERR);
+
+    long long size = DICT_SEEK(fp, 0, SEEK_END) == 0 ? DICT_TELL(fp) : -1;
+
+    if(size < 0)
+    {
+        fclose(fp);
+        return RS_ERR;
+    }
+
+    bulk_t b;
+    memset(&b, 0, sizeof(b));
+    b.d = d;
+    b.path = path;
+    b.parse = parse;
+    b.ctx = ctx;
+
+    worker_t* workers = p_Workers(&b, num_threads);
+
+    // An equal piece each, moved on to the start of a line. Each worker reads its own.
+    long long at = 0;
+
+    for(int t = 0; t < num_threads; t++)
+    {
+        long long split = size / num_threads * (t + 1) + size % num_threads * (t + 1) / num_threads;
+
+        workers[t].begin = at;
+        at = t + 1 < num_threads ? p_NextLine(fp, split > at ? split : at, size) : size;
+        workers[t].end = at;
+    }
+
+    fclose(fp);
+
+    int ret = p_RunWorkers(workers, num_threads, p_ParseWorker);
+
+    if(ret == RS_PASS)
+    {
+        ret = p_Fill(&b, workers);
+    }
+
+    for(int t = 0; t < num_threads; t++)
+    {
+        p_FreeParsed(&workers[t], ret != RS_PASS);
+    }
+
+    FREE(workers);
+
+    return ret;
+}
+
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+worker_t* p_Workers(bulk_t* b, int num_threads)
+{
+    CREATE_ARR(workers, worker_t, num_threads);
+    b->num_threads = num_threads;
+
+    for(int t = 0; t < num_threads; t++)
+    {
+        workers[t].b = b;
+        workers[t].index = t;
+        workers[t].first = (int)((long long)b->n * t / num_threads);
+        workers[t].last = (int)((long long)b->n * (t + 1) / num_threads);
+        workers[t].in = b->entries != NULL ? b->entries + workers[t].first : NULL;
+        workers[t].ret = RS_PASS;
+    }
+
+    return workers;
+}
+
+//--------------------------------------------------------//
+int p_RunWorkers(worker_t* workers, int num, void* (*func)(void*))
+{
+    int ret = RS_PASS;
+
+    for(int t = 1; t < num; t++)
+    {
+        // Short of threads just means less parallel.
+        workers[t].threaded = pthread_create(&workers[t].thread, NULL, func, &workers[t]) == 0;
+        if(!workers[t].threaded)
+        {
+            func(&workers[t]);
+        }
+    }
+
+    func(&workers[0]);
+
+    for(int t = 0; t < num; t++)
+    {
+        if(workers[t].threaded)
+        {
+            pthread_join(workers[t].thread, NULL);
+            workers[t].threaded = false;
+        }
+
+        ret = workers[t].ret == RS_PASS ? ret : RS_ERR;
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int p_Fill(bulk_t* b, worker_t* workers)
+{
+    dict_t* d = b->d;
+    int num = b->num_threads;
+    int total = 0;
+
+    for(int t = 0; t < num; t++)
+    {
+        total += workers[t].num_in;
+    }
+
+    if(total == 0)
+    {
+        return RS_PASS;
+    }
+
+    p_Reserve(d, total);
+
+    for(int t = 0; t < num; t++)
+    {
+        workers[t].lo = (unsigned int)(((unsigned long long)t * d->num_bins + num - 1) / num);
+        workers[t].hi = (unsigned int)(((unsigned long long)(t + 1) * d->num_bins + num - 1) / num);
+    }
+
+    // Counting sort by owner. Within each owner's part the entries stay in input order so later ones still win.
+    CREATE_ARR(counts, int, (size_t)num * num);
+    CREATE_ARR(sorted, entry_t*, total);
+    b->counts = counts;
+    b->sorted = sorted;
+
+    p_RunWorkers(workers, num, p_CountWorker);
+
+    int at = 0;
+
+    for(int owner = 0; owner < num; owner++)
+    {
+        workers[owner].start = at;
+
+        for(int t = 0; t < num; t++)
+        {
+            int count = counts[t * num + owner];
+            counts[t * num + owner] = at;
+            at += count;
+        }
+
+        workers[owner].stop = at;
+    }
+
+    p_RunWorkers(workers, num, p_ScatterWorker);
+    p_RunWorkers(workers, num, p_FillWorker);
+
+    for(int t = 0; t < num; t++)
+    {
+        worker_t* w = &workers[t];
+        d->count += w->added;
+
+        while(w->keys != NULL)
+        {
+            chunk_t* next = w->keys->next;
+            w->keys->next = d->keys;
+            d->keys = w->keys;
+            w->keys = next;
+        }
+
+        // Now the probes can carry on into the next range. Different workers never have the same key.
+        for(int i = 0; i < w->num_spill; i++)
+        {
+            entry_t* e = w->spill[i];
+            cursor_t cur;
+            kv_t* kv = p_Find(d, e->key, e->hash, &cur);
+            kv = kv != NULL ? kv : p_Insert(d, e->key, e->hash, &cur);
+            p_PutValue(d, kv, e->value);
+        }
+
+        if(w->spill != NULL)
+        {
+            FREE(w->spill);
+        }
+    }
+
+    FREE(sorted);
+    FREE(counts);
+    b->sorted = NULL;
+    b->counts = NULL;
+
+    // The workers left it alone.
+    if(d->opts & DICT_FILTER)
+    {
+        p_FilterBuild(d);
+    }
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int p_Owner(dict_t* d, int num_threads, unsigned long long hash)
+{
+    // bin * num_threads / num_bins, and num_bins is 1 << (64 - shift).
+    unsigned long long bin = p_Bin(d->shift, hash);
+    return (int)((bin * (unsigned long long)num_threads) >> (64 - d->shift));
+}
+
+//--------------------------------------------------------//
+void* p_HashWorker(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    bulk_t* b = w->b;
+
+    for(int i = w->first; i < w->last; i++)
+    {
+        if(b->values[i] == NULL || !p_KeyOk(b->d, b->keys[i]))
+        {
+            w->ret = RS_ERR;
+            continue;
+        }
+
+        entry_t* e = &w->in[w->num_in++];
+        e->hash = p_HashKey(b->d, b->keys[i]);
+        e->key = b->keys[i];
+        e->value = b->values[i];
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------//
+long long p_NextLine(FILE* fp, long long from, long long size)
+{
+    int c = 0;
+
+    if(DICT_SEEK(fp, from, SEEK_SET) != 0)
+    {
+        return size;
+    }
+
+    while(from < size && c != '\n' && (c = getc(fp)) != EOF)
+    {
+        from++;
+    }
+
+    return c == EOF ? size : from;
+}
+
+//--------------------------------------------------------//
+void* p_ParseWorker(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    bulk_t* b = w->b;
+
+    if(w->begin == w->end)
+    {
+        return NULL;
+    }
+
+    FILE* fp = fopen(b->path, "rb");
+
+    if(fp == NULL || DICT_SEEK(fp, w->begin, SEEK_SET) != 0)
+    {
+        w->ret = RS_ERR;
+    }
+
+    if(b->d->value_size > 0)
+    {
+        CREATE_ARR(scratch, unsigned char, b->d->value_size);
+        w->scratch = scratch;
+    }
+
+    // Plus a terminator for a last line with no end of line.
+    size_t cap = DICT_READ_SIZE;
+    CREATE_ARR(buf, char, cap + 1);
+    size_t have = 0;
+    long long left = w->end - w->begin;
+
+    while(w->ret == RS_PASS && (left > 0 || have > 0))
+    {
+        size_t want = cap - have;
+        want = (long long)want > left ? (size_t)left : want;
+
+        if(fread(buf + have, 1, want, fp) != want)
+        {
+            w->ret = RS_ERR;
+            break;
+        }
+
+        have += want;
+        left -= (long long)want;
+
+        // The whole lines.
+        char* line = buf;
+        char* eol;
+
+        while(w->ret == RS_PASS && (eol = (char*)memchr(line, '\n', (size_t)(buf + have - line))) != NULL)
+        {
+            *eol = 0;
+            p_ParseLine(w, line, eol);
+            line = eol + 1;
+        }
+
+        size_t rest = (size_t)(buf + have - line);
+
+        if(left == 0 && rest > 0)
+        {
+            line[rest] = 0;
+            p_ParseLine(w, line, line + rest);
+            rest = 0;
+        }
+        else if(rest == cap)
+        {
+            // One line fills the lot.
+            CREATE_ARR(bigger, char, cap * 2 + 1);
+            memcpy(bigger, buf, rest);
+            FREE(buf);
+            buf = bigger;
+            cap *= 2;
+        }
+        else
+        {
+            // The start of a line goes round again.
+            memmove(buf, line, rest);
+        }
+
+        have = rest;
+    }
+
+    FREE(buf);
+
+    if(fp != NULL)
+    {
+        fclose(fp);
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------//
+void p_ParseLine(worker_t* w, char* line, char* stop)
+{
+    bulk_t* b = w->b;
+    dict_t* d = b->d;
+
+    if(stop > line && stop[-1] == '\r')
+    {
+        stop[-1] = 0;
+    }
+
+    if(w->num_in == w->cap_in)
+    {
+        int cap = w->cap_in > 0 ? w->cap_in * 2 : 1024;
+        CREATE_ARR(in, entry_t, cap);
+
+        if(w->in != NULL)
+        {
+            memcpy(in, w->in, (size_t)w->num_in * sizeof(entry_t));
+            FREE(w->in);
+        }
+
+        w->in = in;
+        w->cap_in = cap;
+    }
+
+    // The parser fills in a bytes key here.
+    entry_t* e = &w->in[w->num_in];
+    kbytes_t kb = { NULL, 0 };
+    memset(e, 0, sizeof(entry_t));
+    if(d->kt == KEY_BYTES)
+    {
+        e->key.kb = &kb;
+    }
+
+    void* v = d->value_size > 0 ? w->scratch : (void*)&e->value;
+    int ret = b->parse(line, &e->key, v, b->ctx);
+
+    if(ret == RS_FAIL)
+    {
+        return;
+    }
+
+    if(ret != RS_PASS || (d->value_size == 0 && e->value == NULL))
+    {
+        w->ret = RS_ERR;
+        return;
+    }
+
+    // Kept even if the key is no good, so the value is freed with the rest.
+    w->num_in++;
+
+    if(!p_KeyOk(d, e->key))
+    {
+        w->ret = RS_ERR;
+        return;
+    }
+
+    // The line buffer gets reused.
+    if(d->kt == KEY_STRING)
+    {
+        size_t len = strlen(e->key.ks) + 1;
+        e->key.ks = (const char*)memcpy(p_Store(w, len), e->key.ks, len);
+    }
+    else if(d->kt == KEY_BYTES)
+    {
+        kbytes_t* pb = (kbytes_t*)p_Store(w, sizeof(kbytes_t) + e->key.kb->len);
+        memcpy(pb + 1, e->key.kb->data, e->key.kb->len);
+        pb->data = pb + 1;
+        pb->len = e->key.kb->len;
+        e->key.kb = pb;
+    }
+
+    if(d->value_size > 0)
+    {
+        e->value = memcpy(p_Store(w, d->value_size), w->scratch, d->value_size);
+    }
+
+    e->hash = p_HashKey(d, e->key);
+}
+
+//--------------------------------------------------------//
+void* p_Store(worker_t* w, size_t len)
+{
+    size_t at = w->store != NULL ? (w->store->used + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*) : 0;
+
+    if(w->store == NULL || at + len > w->store->size)
+    {
+        size_t size = len > DICT_STORE_CHUNK ? len : DICT_STORE_CHUNK;
+        chunk_t* chunk = (chunk_t*)calloc(1, sizeof(chunk_t) + size);
+        _CREATE(chunk);
+        chunk->size = size;
+        chunk->next = w->store;
+        w->store = chunk;
+        at = 0;
+    }
+
+    w->store->used = at + len;
+
+    return w->store->data + at;
+}
+
+//--------------------------------------------------------//
+void p_FreeParsed(worker_t* w, bool fail)
+{
+    if(w->in != NULL)
+    {
+        for(int i = 0; fail && w->b->d->value_size == 0 && i < w->num_in; i++)
+        {
+            FREE(w->in[i].value);
+        }
+
+        FREE(w->in);
+    }
+
+    p_ArenaRelease(&w->store);
+
+    if(w->scratch != NULL)
+    {
+        FREE(w->scratch);
+    }
+}
+
+//--------------------------------------------------------//
+void* p_CountWorker(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    bulk_t* b = w->b;
+    int* counts = b->counts + w->index * b->num_threads;
+
+    for(int i = 0; i < w->num_in; i++)
+    {
+        counts[p_Owner(b->d, b->num_threads, w->in[i].hash)]++;
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------//
+void* p_ScatterWorker(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    bulk_t* b = w->b;
+    int* next = b->counts + w->index * b->num_threads;
+
+    for(int i = 0; i < w->num_in; i++)
+    {
+        b->sorted[next[p_Owner(b->d, b->num_threads, w->in[i].hash)]++] = &w->in[i];
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------//
+void* p_FillWorker(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    bulk_t* b = w->b;
+
+    // Own copy of the dict so DICT_ARENA keys go to chunks of this worker. The tables are shared but
+    // nobody else touches these bins.
+    dict_t local = *b->d;
+    dict_t* d = &local;
+    d->keys = NULL;
+
+    for(int i = w->start; i < w->stop; i++)
+    {
+        entry_t* e = b->sorted[i];
+        bool added;
+        kv_t* kv = p_AddInRange(d, e->key, e->hash, w->hi, &added);
+
+        if(kv == NULL)
+        {
+            // DICT_OPEN probe ran out of the range.
+            p_Spill(w, e);
+            continue;
+        }
+
+        w->added += added ? 1 : 0;
+        p_PutValue(d, kv, e->value);
+    }
+
+    w->keys = d->keys;
+
+    return NULL;
+}
+
+//--------------------------------------------------------//
+void p_Spill(worker_t* w, entry_t* e)
+{
+    if(w->num_spill == w->cap_spill)
+    {
+        int cap = w->cap_spill > 0 ? w->cap_spill * 2 : 64;
+        CREATE_ARR(spill, entry_t*, cap);
+
+        if(w->spill != NULL)
+        {
+            memcpy(spill, w->spill, (size_t)w->num_spill * sizeof(entry_t*));
+            FREE(w->spill);
+        }
+
+        w->spill = spill;
+        w->cap_spill = cap;
+    }
+
+    w->spill[w->num_spill++] = e;
+}
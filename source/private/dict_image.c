@@ -0,0 +1,327 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "common.h"
+#include "dict.h"
+#include "dict_private.h"
+
+
+/// @brief Definition of dict images: dict_Save() and dict_OpenMapped(). Kept apart from dict.c because mapping
+/// files needs the OS. Leave this file out on a platform without files and those two are all that is missing.
+
+
+//---------------- Private Declarations ------------------//
+
+/// dict_Save() image identification. The order mark reads wrong on a machine of the other endianness.
+#define DICT_IMAGE_MAGIC "CBOTDICT"
+#define DICT_IMAGE_VERSION 1
+#define DICT_IMAGE_ORDER 0x01020304
+
+/// Start of a dict_Save() image. All sections are 8 byte aligned and located by offset from the start.
+/// Every field is a fixed size so the layout is the same for any compiler.
+typedef struct image
+{
+    char magic[8];                  ///> DICT_IMAGE_MAGIC, no terminator.
+    unsigned int version;           ///> DICT_IMAGE_VERSION.
+    unsigned int order;             ///> DICT_IMAGE_ORDER.
+    unsigned int kt;                ///> keyType_t.
+    unsigned int hash_id;           ///> 0 for dict_HashFast(), 1 for dict_HashSip().
+    unsigned long long seed;        ///> For the hash function.
+    unsigned int num_bins;          ///> Slots. A power of 2.
+    unsigned int count;             ///> Entries.
+    unsigned long long value_size;  ///> Bytes of each value. They are rounded up to 8 apart.
+    unsigned long long hashes_off;  ///> num_bins full hashes, 0 for empty, same as DICT_OPEN.
+    unsigned long long slots_off;   ///> num_bins mslot_t.
+    unsigned long long values_off;  ///> count values.
+    unsigned long long keys_off;    ///> KEY_STRING: the keys back to back, each terminated.
+    unsigned long long keys_size;   ///> Bytes of keys.
+    unsigned long long total;       ///> Bytes of the whole image.
+} image_t;
+
+/// Map a whole file read-only.
+/// @param path File name.
+/// @param size Where to put its size.
+/// @return The mapping | NULL.
+static void* p_MapFile(const char* path, size_t* size);
+
+/// Check that a section lies inside the image without adding anything that could wrap.
+/// @param size Bytes of the image.
+/// @param off Start of the section.
+/// @param len Bytes of the section.
+/// @return T/F
+static bool p_InImage(size_t size, unsigned long long off, unsigned long long len);
+
+/// Undo p_MapFile().
+/// @param map The mapping.
+/// @param size Its size.
+static void p_UnmapFile(void* map, size_t size);
+
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+int dict_Save(dict_t* d, const char* path)
+{
+    VAL_PTR(d, RS_ERR);
+    VAL_PTR(path, RS_ERR);
+
+    unsigned int hash_id = d->hash_func == dict_HashFast ? 0 : d->hash_func == dict_HashSip ? 1 : 2;
+
+    if(d->value_size == 0 || hash_id > 1 || (d->kt != KEY_INT && d->kt != KEY_STRING))
+    {
+        return RS_ERR;
+    }
+
+    int ret = RS_PASS;
+    cursor_t cur;
+    kv_t* kv;
+
+    // Size it all up first so the image is built in one piece.
+    size_t keys_size = 0;
+    if(d->kt == KEY_STRING)
+    {
+        p_Begin(d, &cur);
+        while((kv = p_Next(d, &cur)) != NULL)
+        {
+            keys_size += strlen(p_KeyStr(kv)) + 1;
+        }
+    }
+
+    // Offsets in the slots are 32 bits.
+    if(keys_size > 0xFFFFFFFFu)
+    {
+        return RS_ERR;
+    }
+
+    image_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DICT_IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.version = DICT_IMAGE_VERSION;
+    hdr.order = DICT_IMAGE_ORDER;
+    hdr.kt = d->kt;
+    hdr.hash_id = hash_id;
+    hdr.seed = d->seed;
+    hdr.num_bins = p_BinsFor(DICT_MAPPED, d->count);
+    hdr.count = d->count;
+    hdr.value_size = d->value_size;
+
+    size_t value_stride = (d->value_size + 7) / 8 * 8;
+    hdr.hashes_off = (sizeof(image_t) + 7) / 8 * 8;
+    hdr.slots_off = hdr.hashes_off + hdr.num_bins * sizeof(unsigned long long);
+    hdr.values_off = hdr.slots_off + hdr.num_bins * sizeof(mslot_t);
+    hdr.keys_off = hdr.values_off + hdr.count * value_stride;
+    hdr.keys_size = keys_size;
+    hdr.total = (hdr.keys_off + keys_size + 7) / 8 * 8;
+
+    CREATE_ARR(image, unsigned char, hdr.total);
+    memcpy(image, &hdr, sizeof(hdr));
+
+    unsigned long long* hashes = (unsigned long long*)(image + hdr.hashes_off);
+    mslot_t* slots = (mslot_t*)(image + hdr.slots_off);
+    unsigned char* values = image + hdr.values_off;
+    char* keys = (char*)(image + hdr.keys_off);
+    unsigned int shift = 64 - (unsigned int)log2(hdr.num_bins);
+    unsigned int entry = 0;
+    size_t key_at = 0;
+
+    // Same probing as DICT_OPEN, with the values packed in walk order.
+    p_Begin(d, &cur);
+    while((kv = p_Next(d, &cur)) != NULL)
+    {
+        key_t k;
+        mslot_t slot = { 0, entry };
+
+        if(d->kt == KEY_STRING)
+        {
+            k.ks = p_KeyStr(kv);
+            slot.key = (unsigned int)key_at;
+            strcpy(keys + key_at, k.ks);
+            key_at += strlen(k.ks) + 1;
+        }
+        else // KEY_INT
+        {
+            k.ki = kv->key.ikey;
+            slot.key = (unsigned int)k.ki;
+        }
+
+        unsigned long long hash = p_HashKey(d, k);
+        unsigned int at = p_Bin(shift, hash);
+        while(hashes[at] != 0)
+        {
+            at = (at + 1) & (hdr.num_bins - 1);
+        }
+
+        hashes[at] = hash;
+        slots[at] = slot;
+        memcpy(values + (size_t)entry * value_stride, p_Value(d, kv), d->value_size);
+        entry++;
+    }
+
+    FILE* fp = fopen(path, "wb");
+
+    if(fp == NULL)
+    {
+        ret = RS_ERR;
+    }
+    else
+    {
+        if(fwrite(image, 1, hdr.total, fp) != hdr.total)
+        {
+            ret = RS_ERR;
+        }
+
+        if(fclose(fp) != 0)
+        {
+            ret = RS_ERR;
+        }
+    }
+
+    FREE(image);
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+dict_t* dict_OpenMapped(const char* path)
+{
+    VAL_PTR(path, BAD_PTR);
+
+    size_t size;
+    unsigned char* map = (unsigned char*)p_MapFile(path, &size);
+    VAL_PTR(map, BAD_PTR);
+
+    // Check everything needed to make sure lookups stay inside the image. Slot contents are checked as they are used.
+    // Each section is checked to fit before its end is used to check the next, so none of the sums can wrap.
+    image_t hdr;
+    bool valid = size >= sizeof(image_t);
+
+    if(valid)
+    {
+        memcpy(&hdr, map, sizeof(hdr));
+        unsigned long long value_stride = (hdr.value_size + 7) / 8 * 8;
+
+        valid = memcmp(hdr.magic, DICT_IMAGE_MAGIC, sizeof(hdr.magic)) == 0 &&
+                hdr.version == DICT_IMAGE_VERSION &&
+                hdr.order == DICT_IMAGE_ORDER &&
+                (hdr.kt == KEY_INT || hdr.kt == KEY_STRING) &&
+                hdr.hash_id <= 1 &&
+                hdr.num_bins >= DICT_MIN_BINS && (hdr.num_bins & (hdr.num_bins - 1)) == 0 &&
+                hdr.count < hdr.num_bins &&
+                hdr.value_size > 0 && hdr.value_size < 0xFFFFFFFFu &&
+                hdr.total == size &&
+                hdr.hashes_off >= sizeof(image_t) && hdr.hashes_off % 8 == 0 &&
+                p_InImage(size, hdr.hashes_off, (unsigned long long)hdr.num_bins * sizeof(unsigned long long)) &&
+                hdr.slots_off >= hdr.hashes_off + hdr.num_bins * sizeof(unsigned long long) && hdr.slots_off % 8 == 0 &&
+                p_InImage(size, hdr.slots_off, (unsigned long long)hdr.num_bins * sizeof(mslot_t)) &&
+                hdr.values_off >= hdr.slots_off + hdr.num_bins * sizeof(mslot_t) && hdr.values_off % 8 == 0 &&
+                p_InImage(size, hdr.values_off, hdr.count * value_stride) &&
+                hdr.keys_off >= hdr.values_off + hdr.count * value_stride &&
+                p_InImage(size, hdr.keys_off, hdr.keys_size) &&
+                (hdr.keys_size == 0 || map[hdr.keys_off + hdr.keys_size - 1] == 0);
+    }
+
+    if(!valid)
+    {
+        p_UnmapFile(map, size);
+        return BAD_PTR;
+    }
+
+    CREATE_INST(d, dict_t);
+
+    // Looks like a frozen open dict that doesn't own its table.
+    d->kt = (keyType_t)hdr.kt;
+    d->opts = DICT_OPEN | DICT_MAPPED | DICT_FROZEN;
+    d->hash_func = hdr.hash_id == 0 ? dict_HashFast : dict_HashSip;
+    d->seed = hdr.seed;
+    p_SetSize(d, hdr.num_bins);
+    d->min_bins = d->num_bins;
+    d->count = (int)hdr.count;
+    d->value_size = (size_t)hdr.value_size;
+    d->hashes = (unsigned long long*)(map + hdr.hashes_off);
+    d->map = map;
+    d->map_size = size;
+    d->unmap = p_UnmapFile;
+    d->mslots = (const mslot_t*)(map + hdr.slots_off);
+    d->mvalues = map + hdr.values_off;
+    d->mkeys = (const char*)(map + hdr.keys_off);
+    d->mkeys_size = (size_t)hdr.keys_size;
+
+    return d;
+}
+
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+bool p_InImage(size_t size, unsigned long long off, unsigned long long len)
+{
+    return off <= size && len <= size - off;
+}
+
+//--------------------------------------------------------//
+void* p_MapFile(const char* path, size_t* size)
+{
+    void* map = NULL;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER len;
+
+    if(file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &len) && len.QuadPart > 0)
+    {
+        // The view keeps the mapping alive after the handles are closed.
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping != NULL)
+        {
+            map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)len.QuadPart;
+    }
+
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if(fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        // The mapping stays after the file is closed.
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        map = map != MAP_FAILED ? map : NULL;
+        *size = (size_t)st.st_size;
+    }
+
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+
+    return map;
+}
+
+//--------------------------------------------------------//
+void p_UnmapFile(void* map, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(map);
+#else
+    munmap(map, size);
+#endif
+}
@@ -0,0 +1,233 @@
+#ifndef DICT_PRIVATE_H
+#define DICT_PRIVATE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "dict.h"
+
+/// @brief Internals of dict shared by its source files: dict.c has the table, dict_image.c saves and maps
+/// images, dict_bulk.c fills it from many threads. cdict.c uses the bin and key arena parts too. Not for clients.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Smallest number of bins. Must be a power of 2.
+#define DICT_MIN_BINS 8
+
+/// Private opts flag for dict_InitStatic(). All memory belongs to the client, nothing is allocated or freed.
+#define DICT_STATIC (1u << 16)
+
+/// Private opts flag set by dict_Freeze(). Anything that would change the dict fails.
+#define DICT_FROZEN (1u << 17)
+
+/// Private opts flag for dict_OpenMapped(). The table is a read-only file image.
+#define DICT_MAPPED (1u << 18)
+
+/// String keys shorter than this live in the entry itself so need no allocation or pointer chasing.
+/// 16 covers most real keys and keeps an entry at 24 bytes.
+#define DICT_INLINE_KEY 16
+
+/// KEY_BYTES keys up to this long live in the entry, with their length in the byte before the marker byte.
+#define DICT_INLINE_BYTES (DICT_INLINE_KEY - 2)
+
+/// Bytes per key arena chunk. Longer keys get a chunk of their own.
+#define DICT_ARENA_CHUNK 65536
+
+/// Fibonacci hashing multiplier. Spreads the hash bits before picking the bin.
+#define DICT_HASH_SPREAD 0x9E3779B97F4A7C15ULL
+
+/// Key-value pair.
+typedef struct kv
+{
+    union
+    {
+        char* skey;                 ///> String key of DICT_INLINE_KEY or more chars. Last byte of inl is then set.
+        char inl[DICT_INLINE_KEY];  ///> Shorter string key, in place with its terminator. Last byte is 0.
+        int ikey;                   ///> Int key.
+        unsigned long long ukey;    ///> KEY_U64 key.
+        struct
+        {
+            char* data;             ///> Same place as skey.
+            unsigned int len;       ///> Before the marker byte.
+        } bkey;                     ///> KEY_BYTES key of more than DICT_INLINE_BYTES. Last byte of inl is then set.
+    } key;
+    void* value;        ///> Client specific data. Client must cast.
+} kv_t;
+
+/// DICT_CHAINED entry.
+typedef struct link
+{
+    struct link* next;          ///> Next in this bin.
+    unsigned long long hash;    ///> Full hash of the key. Compared before the key, reused for resizing.
+    kv_t kv;                    ///> The payload.
+} link_t;
+
+/// Block of keys, allocated together and freed together. For DICT_ARENA and cdict.
+typedef struct chunk
+{
+    struct chunk* next;     ///> Older chunks.
+    size_t size;            ///> Bytes in data.
+    size_t used;            ///> Bytes handed out so far.
+    char data[];            ///> The keys, back to back.
+} chunk_t;
+
+/// DICT_MAPPED: a used slot of the image.
+typedef struct mslot
+{
+    unsigned int key;       ///> Int key, or offset of the string key in the key section.
+    unsigned int entry;     ///> Index of the value.
+} mslot_t;
+
+/// Position of a walk through all the entries.
+typedef struct cursor
+{
+    unsigned int bin;   ///> DICT_CHAINED: current bin.
+    link_t** where;     ///> DICT_CHAINED: what points to the current link. NULL when done.
+    unsigned int start; ///> DICT_OPEN: first slot. Just after an empty one so no cluster wraps past the end of the walk.
+    unsigned int step;  ///> DICT_OPEN: next slot to look at, relative to start.
+    bool valid;         ///> There is a current entry.
+    kv_t kv;            ///> DICT_MAPPED: the current entry, made from the image.
+} cursor_t;
+
+/// One instance of a dictionary.
+struct dict
+{
+    keyType_t kt;               ///> The key type.
+    unsigned int opts;          ///> dictOpt_t flags.
+    dict_HashFunc_t hash_func;  ///> Makes hashes from keys.
+    unsigned long long seed;    ///> Passed to hash_func.
+    unsigned int num_bins;      ///> Number of bins or slots. Always a power of 2.
+    unsigned int shift;         ///> Picks the bin from the top bits of the spread hash.
+    unsigned int min_bins;      ///> Initial size. We don't shrink below this.
+    int count;                  ///> Number of entries.
+    link_t** bins;              ///> DICT_CHAINED: head of each chain.
+    unsigned long long* hashes; ///> DICT_OPEN: full hash of each slot. 0 means empty.
+    unsigned char* slots;       ///> DICT_OPEN: the entries, in line, stride bytes apart. Use p_Slot().
+    unsigned char* ctrl;        ///> DICT_GROUP: tag of each slot, plus a copy of the first group at the end.
+    cursor_t iter;              ///> For client iteration.
+    kbytes_t iter_key;          ///> KEY_BYTES: the key dict_IterNext() gave out.
+    link_t** old_bins;          ///> DICT_INCREMENTAL: table being emptied into bins. NULL if not moving.
+    unsigned int old_num_bins;  ///> DICT_INCREMENTAL: its size.
+    unsigned int old_shift;     ///> DICT_INCREMENTAL: its shift.
+    unsigned int rehash_idx;    ///> DICT_INCREMENTAL: next old bin to move. The ones below are empty.
+    chunk_t* keys;              ///> DICT_ARENA: key storage, newest chunk first.
+    size_t value_size;          ///> Bytes of each inline value. 0 if values are client pointers.
+    size_t stride;              ///> Bytes of a kv_t plus its inline value.
+    int max_count;              ///> DICT_STATIC: most entries that fit.
+    void* map;                  ///> DICT_MAPPED: the whole image.
+    size_t map_size;            ///> DICT_MAPPED: its bytes.
+    void (*unmap)(void* map, size_t size); ///> DICT_MAPPED: releases map.
+    const mslot_t* mslots;      ///> DICT_MAPPED: the slots. hashes also points into the image.
+    const unsigned char* mvalues; ///> DICT_MAPPED: the values.
+    const char* mkeys;          ///> DICT_MAPPED: the string keys.
+    size_t mkeys_size;          ///> DICT_MAPPED: bytes of mkeys.
+    unsigned long long* filter; ///> DICT_FILTER: the bloom filter, in blocks.
+    unsigned int filter_blocks; ///> DICT_FILTER: number of blocks. Always a power of 2.
+    unsigned int filter_stale;  ///> DICT_FILTER: removes since it was built. Their bits are still set.
+    unsigned int resizes;       ///> Number of times the table changed size.
+};
+
+/// Set the table size and the derived shift.
+/// @param d The dictionary.
+/// @param num_bins New size. Must be a power of 2.
+void p_SetSize(dict_t* d, unsigned int num_bins);
+
+/// Smallest number of bins that holds capacity entries without exceeding the load factor.
+/// @param opts dictOpt_t flags.
+/// @param capacity Expected number of entries.
+/// @return The size.
+unsigned int p_BinsFor(unsigned int opts, int capacity);
+
+/// Hash a client key according to the dict key type.
+/// @param d The dictionary.
+/// @param k The key.
+/// @return Full hash value. Never 0 as that marks an empty slot.
+unsigned long long p_HashKey(dict_t* d, key_t k);
+
+/// Pick the bin or home slot for a hash.
+/// @param shift Of the table. See p_SetSize().
+/// @param hash Full hash value.
+/// @return Index between 0 and num_bins.
+unsigned int p_Bin(unsigned int shift, unsigned long long hash);
+
+/// Where the value of an entry is. Inline values start at the value member and run on past the kv_t.
+/// @param d The dictionary.
+/// @param kv The entry.
+/// @return The client pointer or the inline value.
+void* p_Value(dict_t* d, kv_t* kv);
+
+/// The string key of an entry, wherever it lives. Moves with the entry if inline.
+/// @param kv The entry.
+/// @return The key.
+const char* p_KeyStr(const kv_t* kv);
+
+/// Start a walk through all the entries.
+/// @param d The dictionary.
+/// @param cur Walk position.
+void p_Begin(dict_t* d, cursor_t* cur);
+
+/// Step to the next entry.
+/// @param d The dictionary.
+/// @param cur Walk position.
+/// @return The entry | NULL at the end.
+kv_t* p_Next(dict_t* d, cursor_t* cur);
+
+/// Check a client key fits the entry. KEY_BYTES lengths are kept as unsigned int so longer ones would not match.
+/// @param d The dictionary.
+/// @param k The key.
+/// @return OK.
+bool p_KeyOk(dict_t* d, key_t k);
+
+/// Locate the entry for a key.
+/// @param d The dictionary.
+/// @param k The key.
+/// @param hash Its hash.
+/// @param cur Optional. If found, set up so p_RemoveCurrent() removes it. If not, remembers where it would go.
+/// @return The entry | NULL if not there.
+kv_t* p_Find(dict_t* d, key_t k, unsigned long long hash, cursor_t* cur);
+
+/// Add a new entry for a key that is not already there. Grows the table if needed.
+/// @param d The dictionary.
+/// @param k The key.
+/// @param hash Its hash.
+/// @param cur Optional. From the p_Find() that missed. Saves probing again if the table doesn't grow.
+/// @return The entry with key filled in and no value.
+kv_t* p_Insert(dict_t* d, key_t k, unsigned long long hash, cursor_t* cur);
+
+/// Store the value of a found or new entry like dict_Set().
+/// @param d The dictionary.
+/// @param kv The entry.
+/// @param v The value.
+void p_PutValue(dict_t* d, kv_t* kv, void* v);
+
+/// Copy a key into the newest chunk of an arena, starting a new chunk if it doesn't fit. Chunks made here have
+/// a 0 byte after size that is never written, so a reader racing the copy still finds a terminator.
+/// @param keys The arena, newest chunk first.
+/// @param data The key bytes.
+/// @param len How many, including the terminator of a string.
+/// @return The copy.
+char* p_ArenaCopy(chunk_t** keys, const void* data, size_t len);
+
+/// Free all the chunks of an arena.
+/// @param keys The arena. Left empty.
+void p_ArenaRelease(chunk_t** keys);
+
+/// DICT_FILTER: make the filter again, sized for the table, from the hashes of the entries.
+/// @param d The dictionary.
+void p_FilterBuild(dict_t* d);
+
+/// Finish any move and grow the table so n more entries fit. For filling bins directly, which must not move.
+/// @param d The dictionary.
+/// @param n Number of entries to come.
+void p_Reserve(dict_t* d, int n);
+
+/// Find or add the entry for a key without growing the table or probing past a slot. The count is not changed.
+/// @param d The dictionary.
+/// @param k The key.
+/// @param hash Its hash.
+/// @param hi DICT_OPEN: the probe stops here.
+/// @param added Set if the entry is new. It has no value yet.
+/// @return The entry | NULL if the probe reached hi.
+kv_t* p_AddInRange(dict_t* d, key_t k, unsigned long long hash, unsigned int hi, bool* added);
+
+#endif // DICT_PRIVATE_H
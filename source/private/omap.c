@@ -0,0 +1,651 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "dict.h"
+#include "omap.h"
+
+
+/// @brief Definition of ordered map.
+/// A B+ tree: all entries are in the leaves, which are linked in key order. Inner nodes hold separator keys,
+/// child i has the keys from separator i-1 up to but not including separator i. Every node but the root is kept
+/// at least half full. Inserts split a node when it overflows and push a separator up, removes borrow from or
+/// merge with a sibling when a node gets too small. Separators are copies, so a removed key may live on as a
+/// separator, which is still a valid bound.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Most keys in a node. 32 keeps a node a few cache lines of keys that a binary search touches little of.
+#define OMAP_ORDER 32
+
+/// Fewest keys in a node other than the root.
+#define OMAP_MIN (OMAP_ORDER / 2)
+
+/// One node of the tree. Has room for one extra key while it is being split.
+typedef struct onode
+{
+    bool leaf;                      ///> Leaf or inner node.
+    int num;                        ///> Number of keys.
+    struct onode* next;             ///> Leaf only: the next leaf in key order | NULL.
+    key_t keys[OMAP_ORDER + 1];     ///> Sorted keys. String keys are owned.
+    void* ptrs[OMAP_ORDER + 2];     ///> Leaf: the value of each key. Inner: the num + 1 children.
+} onode_t;
+
+/// Definition of ordered map.
+struct omap
+{
+    keyType_t kt;                   ///> The key type.
+    int count;                      ///> Number of entries.
+    onode_t* root;                  ///> A leaf while small.
+    onode_t* iter_leaf;             ///> Walk position | NULL if done.
+    int iter_pos;                   ///> Walk position in iter_leaf.
+    key_t iter_hi;                  ///> Walk end, not owned.
+    bool iter_has_hi;               ///> iter_hi is set.
+};
+
+/// Compare keys.
+/// @param m The map.
+/// @param a One key.
+/// @param b Other key.
+/// @return < 0, 0, > 0 like strcmp().
+static int p_Compare(omap_t* m, key_t a, key_t b);
+
+/// Copy a key, allocating for strings.
+/// @param m The map.
+/// @param k The key.
+/// @return The copy.
+static key_t p_CopyKey(omap_t* m, key_t k);
+
+/// Free a copied key.
+/// @param m The map.
+/// @param k The key.
+static void p_FreeKey(omap_t* m, key_t k);
+
+/// Position of the first key in a node that is not less than k.
+/// @param m The map.
+/// @param n The node.
+/// @param k The key.
+/// @return 0 to n->num.
+static int p_LowerBound(omap_t* m, onode_t* n, key_t k);
+
+/// Child of an inner node that would hold a key.
+/// @param m The map.
+/// @param n The node.
+/// @param k The key.
+/// @return 0 to n->num.
+static int p_ChildIndex(omap_t* m, onode_t* n, key_t k);
+
+/// Find the leaf that would hold a key.
+/// @param m The map.
+/// @param k The key.
+/// @return The leaf.
+static onode_t* p_FindLeaf(omap_t* m, key_t k);
+
+/// Make a node.
+/// @param leaf Leaf or inner.
+/// @return The node.
+static onode_t* p_NewNode(bool leaf);
+
+/// Free a node and everything under it.
+/// @param m The map.
+/// @param n The node.
+static void p_FreeNode(omap_t* m, onode_t* n);
+
+/// Insert under a node. It may be left one key over full for the caller to split.
+/// @param m The map.
+/// @param n The node.
+/// @param k The key, not yet copied.
+/// @param v The value.
+static void p_Insert(omap_t* m, onode_t* n, key_t k, void* v);
+
+/// Split the over full child of an inner node in two and add the separator.
+/// @param m The map.
+/// @param n The inner node.
+/// @param i Which child.
+static void p_Split(omap_t* m, onode_t* n, int i);
+
+/// Remove a key from under a node. The node may be left under full for the caller to fix.
+/// @param m The map.
+/// @param n The node.
+/// @param k The key.
+/// @param v Where to put the value.
+/// @return RS_PASS | RS_FAIL if not there.
+static int p_Delete(omap_t* m, onode_t* n, key_t k, void** v);
+
+/// Bring an under full child of an inner node back to OMAP_MIN keys.
+/// @param m The map.
+/// @param n The inner node.
+/// @param i Which child.
+static void p_Refill(omap_t* m, onode_t* n, int i);
+
+/// Join a child of an inner node with the next child.
+/// @param m The map.
+/// @param n The inner node.
+/// @param i The left child.
+static void p_Join(omap_t* m, onode_t* n, int i);
+
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+omap_t* omap_Create(keyType_t kt)
+{
+    if(kt != KEY_INT && kt != KEY_STRING)
+    {
+        return BAD_PTR;
+    }
+
+    CREATE_INST(m, omap_t);
+    VAL_PTR(m, BAD_PTR);
+
+    m->kt = kt;
+    m->root = p_NewNode(true);
+
+    return m;
+}
+
+//--------------------------------------------------------//
+int omap_Destroy(omap_t* m)
+{
+    VAL_PTR(m, RS_ERR);
+
+    p_FreeNode(m, m->root);
+    FREE(m);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int omap_Clear(omap_t* m)
+{
+    VAL_PTR(m, RS_ERR);
+
+    p_FreeNode(m, m->root);
+    m->root = p_NewNode(true);
+    m->count = 0;
+    m->iter_leaf = NULL;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int omap_Count(omap_t* m)
+{
+    VAL_PTR(m, RS_ERR);
+
+    return m->count;
+}
+
+//--------------------------------------------------------//
+int omap_Set(omap_t* m, key_t k, void* v)
+{
+    VAL_PTR(m, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    if(m->kt == KEY_STRING)
+    {
+        VAL_PTR(k.ks, RS_ERR);
+    }
+
+    p_Insert(m, m->root, k, v);
+    m->iter_leaf = NULL;
+
+    if(m->root->num > OMAP_ORDER)
+    {
+        // Grow a level.
+        onode_t* root = p_NewNode(false);
+        root->ptrs[0] = m->root;
+        m->root = root;
+        p_Split(m, root, 0);
+    }
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int omap_Get(omap_t* m, key_t k, void** v)
+{
+    VAL_PTR(m, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    if(m->kt == KEY_STRING)
+    {
+        VAL_PTR(k.ks, RS_ERR);
+    }
+
+    onode_t* leaf = p_FindLeaf(m, k);
+    int pos = p_LowerBound(m, leaf, k);
+
+    if(pos == leaf->num || p_Compare(m, leaf->keys[pos], k) != 0)
+    {
+        return RS_FAIL;
+    }
+
+    *v = leaf->ptrs[pos];
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int omap_Remove(omap_t* m, key_t k, void** v)
+{
+    VAL_PTR(m, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    if(m->kt == KEY_STRING)
+    {
+        VAL_PTR(k.ks, RS_ERR);
+    }
+
+    int ret = p_Delete(m, m->root, k, v);
+    m->iter_leaf = NULL;
+
+    if(!m->root->leaf && m->root->num == 0)
+    {
+        // Drop a level.
+        onode_t* root = m->root;
+        m->root = (onode_t*)root->ptrs[0];
+        FREE(root);
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int omap_IterStart(omap_t* m, const key_t* lo, const key_t* hi)
+{
+    VAL_PTR(m, RS_ERR);
+
+    if(lo != NULL)
+    {
+        m->iter_leaf = p_FindLeaf(m, *lo);
+        m->iter_pos = p_LowerBound(m, m->iter_leaf, *lo);
+    }
+    else
+    {
+        onode_t* n = m->root;
+        while(!n->leaf)
+        {
+            n = (onode_t*)n->ptrs[0];
+        }
+        m->iter_leaf = n;
+        m->iter_pos = 0;
+    }
+
+    // The bound may be past the end of its leaf.
+    if(m->iter_pos == m->iter_leaf->num)
+    {
+        m->iter_leaf = m->iter_leaf->next;
+        m->iter_pos = 0;
+    }
+
+    m->iter_has_hi = hi != NULL;
+    if(hi != NULL)
+    {
+        m->iter_hi = *hi;
+    }
+
+    if(m->iter_leaf == NULL || (hi != NULL && p_Compare(m, m->iter_leaf->keys[m->iter_pos], *hi) >= 0))
+    {
+        m->iter_leaf = NULL;
+        return RS_FAIL;
+    }
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int omap_IterNext(omap_t* m, key_t* k, void** v)
+{
+    VAL_PTR(m, RS_ERR);
+    VAL_PTR(k, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    onode_t* leaf = m->iter_leaf;
+
+    if(leaf == NULL || (m->iter_has_hi && p_Compare(m, leaf->keys[m->iter_pos], m->iter_hi) >= 0))
+    {
+        m->iter_leaf = NULL;
+        return RS_FAIL;
+    }
+
+    *k = leaf->keys[m->iter_pos];
+    *v = leaf->ptrs[m->iter_pos];
+
+    if(++m->iter_pos == leaf->num)
+    {
+        m->iter_leaf = leaf->next;
+        m->iter_pos = 0;
+    }
+
+    return RS_PASS;
+}
+
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+int p_Compare(omap_t* m, key_t a, key_t b)
+{
+    if(m->kt == KEY_STRING)
+    {
+        return strcmp(a.ks, b.ks);
+    }
+
+    return a.ki < b.ki ? -1 : (a.ki > b.ki ? 1 : 0);
+}
+
+//--------------------------------------------------------//
+key_t p_CopyKey(omap_t* m, key_t k)
+{
+    if(m->kt == KEY_STRING)
+    {
+        CREATE_STR(s, strlen(k.ks));
+        strcpy(s, k.ks);
+        k.ks = s;
+    }
+
+    return k;
+}
+
+//--------------------------------------------------------//
+void p_FreeKey(omap_t* m, key_t k)
+{
+    if(m->kt == KEY_STRING)
+    {
+        FREE((char*)k.ks);
+    }
+}
+
+//--------------------------------------------------------//
+int p_LowerBound(omap_t* m, onode_t* n, key_t k)
+{
+    int lo = 0;
+    int hi = n->num;
+
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if(p_Compare(m, n->keys[mid], k) < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+//--------------------------------------------------------//
+int p_ChildIndex(omap_t* m, onode_t* n, key_t k)
+{
+    // Keys equal to a separator are in the child to its right.
+    int lo = 0;
+    int hi = n->num;
+
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if(p_Compare(m, n->keys[mid], k) <= 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+//--------------------------------------------------------//
+onode_t* p_FindLeaf(omap_t* m, key_t k)
+{
+    onode_t* n = m->root;
+
+    while(!n->leaf)
+    {
+        n = (onode_t*)n->ptrs[p_ChildIndex(m, n, k)];
+    }
+
+    return n;
+}
+
+//--------------------------------------------------------//
+onode_t* p_NewNode(bool leaf)
+{
+    CREATE_INST(n, onode_t);
+    n->leaf = leaf;
+
+    return n;
+}
+
+//--------------------------------------------------------//
+void p_FreeNode(omap_t* m, onode_t* n)
+{
+    for(int i = 0; i < n->num; i++)
+    {
+        p_FreeKey(m, n->keys[i]);
+    }
+
+    if(n->leaf)
+    {
+        for(int i = 0; i < n->num; i++)
+        {
+            FREE(n->ptrs[i]);
+        }
+    }
+    else
+    {
+        for(int i = 0; i <= n->num; i++)
+        {
+            p_FreeNode(m, (onode_t*)n->ptrs[i]);
+        }
+    }
+
+    FREE(n);
+}
+
+//--------------------------------------------------------//
+void p_Insert(omap_t* m, onode_t* n, key_t k, void* v)
+{
+    if(n->leaf)
+    {
+        int pos = p_LowerBound(m, n, k);
+
+        if(pos < n->num && p_Compare(m, n->keys[pos], k) == 0)
+        {
+            FREE(n->ptrs[pos]);
+            n->ptrs[pos] = v;
+        }
+        else
+        {
+            memmove(n->keys + pos + 1, n->keys + pos, (n->num - pos) * sizeof(key_t));
+            memmove(n->ptrs + pos + 1, n->ptrs + pos, (n->num - pos) * sizeof(void*));
+            n->keys[pos] = p_CopyKey(m, k);
+            n->ptrs[pos] = v;
+            n->num++;
+            m->count++;
+        }
+    }
+    else
+    {
+        int i = p_ChildIndex(m, n, k);
+        onode_t* kid = (onode_t*)n->ptrs[i];
+
+        p_Insert(m, kid, k, v);
+
+        if(kid->num > OMAP_ORDER)
+        {
+            p_Split(m, n, i);
+        }
+    }
+}
+
+//--------------------------------------------------------//
+void p_Split(omap_t* m, onode_t* n, int i)
+{
+    onode_t* left = (onode_t*)n->ptrs[i];
+    onode_t* right = p_NewNode(left->leaf);
+    int half = left->num / 2;
+    key_t sep;
+
+    if(left->leaf)
+    {
+        // Right gets the top half, its first key is copied up.
+        right->num = left->num - half;
+        memcpy(right->keys, left->keys + half, right->num * sizeof(key_t));
+        memcpy(right->ptrs, left->ptrs + half, right->num * sizeof(void*));
+        right->next = left->next;
+        left->next = right;
+        sep = p_CopyKey(m, right->keys[0]);
+    }
+    else
+    {
+        // The middle key moves up.
+        right->num = left->num - half - 1;
+        memcpy(right->keys, left->keys + half + 1, right->num * sizeof(key_t));
+        memcpy(right->ptrs, left->ptrs + half + 1, (right->num + 1) * sizeof(void*));
+        sep = left->keys[half];
+    }
+
+    left->num = half;
+
+    memmove(n->keys + i + 1, n->keys + i, (n->num - i) * sizeof(key_t));
+    memmove(n->ptrs + i + 2, n->ptrs + i + 1, (n->num - i) * sizeof(void*));
+    n->keys[i] = sep;
+    n->ptrs[i + 1] = right;
+    n->num++;
+}
+
+//--------------------------------------------------------//
+int p_Delete(omap_t* m, onode_t* n, key_t k, void** v)
+{
+    if(n->leaf)
+    {
+        int pos = p_LowerBound(m, n, k);
+
+        if(pos == n->num || p_Compare(m, n->keys[pos], k) != 0)
+        {
+            return RS_FAIL;
+        }
+
+        *v = n->ptrs[pos];
+        p_FreeKey(m, n->keys[pos]);
+        memmove(n->keys + pos, n->keys + pos + 1, (n->num - pos - 1) * sizeof(key_t));
+        memmove(n->ptrs + pos, n->ptrs + pos + 1, (n->num - pos - 1) * sizeof(void*));
+        n->num--;
+        m->count--;
+
+        return RS_PASS;
+    }
+
+    int i = p_ChildIndex(m, n, k);
+    int ret = p_Delete(m, (onode_t*)n->ptrs[i], k, v);
+
+    if(ret == RS_PASS && ((onode_t*)n->ptrs[i])->num < OMAP_MIN)
+    {
+        p_Refill(m, n, i);
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+void p_Refill(omap_t* m, onode_t* n, int i)
+{
+    onode_t* kid = (onode_t*)n->ptrs[i];
+    onode_t* left = i > 0 ? (onode_t*)n->ptrs[i - 1] : NULL;
+    onode_t* right = i < n->num ? (onode_t*)n->ptrs[i + 1] : NULL;
+
+    if(left != NULL && left->num > OMAP_MIN)
+    {
+        // Borrow the last of the left sibling.
+        memmove(kid->keys + 1, kid->keys, kid->num * sizeof(key_t));
+        memmove(kid->ptrs + 1, kid->ptrs, (kid->num + (kid->leaf ? 0 : 1)) * sizeof(void*));
+
+        if(kid->leaf)
+        {
+            kid->keys[0] = left->keys[left->num - 1];
+            kid->ptrs[0] = left->ptrs[left->num - 1];
+            p_FreeKey(m, n->keys[i - 1]);
+            n->keys[i - 1] = p_CopyKey(m, kid->keys[0]);
+        }
+        else
+        {
+            kid->keys[0] = n->keys[i - 1];
+            kid->ptrs[0] = left->ptrs[left->num];
+            n->keys[i - 1] = left->keys[left->num - 1];
+        }
+
+        left->num--;
+        kid->num++;
+    }
+    else if(right != NULL && right->num > OMAP_MIN)
+    {
+        // Borrow the first of the right sibling.
+        if(kid->leaf)
+        {
+            kid->keys[kid->num] = right->keys[0];
+            kid->ptrs[kid->num] = right->ptrs[0];
+            memmove(right->keys, right->keys + 1, (right->num - 1) * sizeof(key_t));
+            memmove(right->ptrs, right->ptrs + 1, (right->num - 1) * sizeof(void*));
+            p_FreeKey(m, n->keys[i]);
+            n->keys[i] = p_CopyKey(m, right->keys[0]);
+        }
+        else
+        {
+            kid->keys[kid->num] = n->keys[i];
+            kid->ptrs[kid->num + 1] = right->ptrs[0];
+            n->keys[i] = right->keys[0];
+            memmove(right->keys, right->keys + 1, (right->num - 1) * sizeof(key_t));
+            memmove(right->ptrs, right->ptrs + 1, right->num * sizeof(void*));
+        }
+
+        right->num--;
+        kid->num++;
+    }
+    else
+    {
+        // Both siblings are at the minimum so the two fit in one node.
+        p_Join(m, n, left != NULL ? i - 1 : i);
+    }
+}
+
+//--------------------------------------------------------//
+void p_Join(omap_t* m, onode_t* n, int i)
+{
+    onode_t* left = (onode_t*)n->ptrs[i];
+    onode_t* right = (onode_t*)n->ptrs[i + 1];
+
+    if(left->leaf)
+    {
+        memcpy(left->keys + left->num, right->keys, right->num * sizeof(key_t));
+        memcpy(left->ptrs + left->num, right->ptrs, right->num * sizeof(void*));
+        left->num += right->num;
+        left->next = right->next;
+        p_FreeKey(m, n->keys[i]);
+    }
+    else
+    {
+        // The separator comes down between them.
+        left->keys[left->num] = n->keys[i];
+        memcpy(left->keys + left->num + 1, right->keys, right->num * sizeof(key_t));
+        memcpy(left->ptrs + left->num + 1, right->ptrs, (right->num + 1) * sizeof(void*));
+        left->num += right->num + 1;
+    }
+
+    memmove(n->keys + i, n->keys + i + 1, (n->num - i - 1) * sizeof(key_t));
+    memmove(n->ptrs + i + 1, n->ptrs + i + 2, (n->num - i - 1) * sizeof(void*));
+    n->num--;
+
+    FREE(right);
+}
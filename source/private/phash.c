@@ -0,0 +1,512 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "dict.h"
+#include "phash.h"
+
+
+/// @brief Definition of perfect hash thing.
+/// A key hash gives a bucket and two numbers f1 and f2 below num_slots. The key goes in slot
+/// (f1 + d0 * f2 + d1) % num_slots where d0 and d1 are the displacement pair of its bucket. The build places
+/// the biggest buckets first while the table is empty, trying pairs until all keys of the bucket land in free
+/// slots. This is the CHD algorithm (Belazzougui, Botelho, Dietzfelbinger) without the compression.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Average keys per bucket. More makes the displacement table smaller and the build slower.
+#define PHASH_BUCKET_KEYS 4
+
+/// Largest d0 tried before giving up on a seed. Big buckets are placed early so this is rarely reached.
+#define PHASH_MAX_D0 1024
+
+/// Seeds tried before giving up. A seed only fails if two keys of a bucket get the same f1 and f2.
+#define PHASH_MAX_SEEDS 64
+
+/// Keys per line in generated source.
+#define PHASH_LINE_ITEMS 8
+
+/// Where a key hash sends it.
+typedef struct place
+{
+    unsigned int bucket;    ///> Which displacement pair.
+    unsigned int f1;        ///> Base slot.
+    unsigned int f2;        ///> Step for d0.
+} place_t;
+
+/// Split a key hash.
+/// @param num_buckets Of the table.
+/// @param num_slots Of the table.
+/// @param hash Key hash.
+/// @return Where it goes.
+static place_t p_Place(unsigned int num_buckets, unsigned int num_slots, unsigned long long hash);
+
+/// The slot for a key.
+/// @param p Where its hash sends it.
+/// @param disp The displacement pair of its bucket.
+/// @param num_slots Of the table.
+/// @return The slot.
+static unsigned int p_Slot(place_t p, const unsigned int* disp, unsigned int num_slots);
+
+/// Hash a key the same way for build and lookup.
+/// @param kt Key type.
+/// @param seed Hash seed.
+/// @param k The key.
+/// @return The hash.
+static unsigned long long p_Hash(keyType_t kt, unsigned long long seed, key_t k);
+
+/// Find the slot of a key.
+/// @param ph The table.
+/// @param k The key.
+/// @return The slot | RS_FAIL if not a key.
+static int p_Lookup(const phash_t* ph, key_t k);
+
+/// Try to place all keys with the seed of the table. Fills in disp.
+/// @param ph The table being built.
+/// @param places Where each key hash sends it.
+/// @param slots Where to put the slot of each key.
+/// @return True if every key got a slot of its own.
+static bool p_Assign(phash_t* ph, const place_t* places, unsigned int* slots);
+
+/// Write a string key as a C literal.
+/// @param fp Output stream.
+/// @param ks The key.
+static void p_WriteStr(FILE* fp, const char* ks);
+
+
+//---------------- Public API Implementation -------------//
+
+
+//--------------------------------------------------------//
+phash_t* phash_Build(keyType_t kt, const key_t* keys, void* const* values, int n)
+{
+    VAL_PTR(keys, BAD_PTR);
+
+    if(n <= 0 || (kt != KEY_INT && kt != KEY_STRING))
+    {
+        return BAD_PTR;
+    }
+
+    // No two keys can have a slot of their own if they are the same.
+    bool dupe = false;
+    dict_t* seen = dict_CreateInlineEx(kt, n, DICT_OPEN, 1);
+    for(int i = 0; i < n && !dupe; i++)
+    {
+        void** slot;
+        bool inserted;
+        dict_GetOrInsert(seen, keys[i], &slot, &inserted);
+        dupe = !inserted;
+    }
+    dict_Destroy(seen);
+
+    if(dupe)
+    {
+        return BAD_PTR;
+    }
+
+    CREATE_INST(ph, phash_t);
+    ph->kt = kt;
+    ph->num_slots = (unsigned int)n;
+    ph->num_buckets = (ph->num_slots + PHASH_BUCKET_KEYS - 1) / PHASH_BUCKET_KEYS;
+    ph->owned = true;
+
+    CREATE_ARR(disp, unsigned int, 2 * ph->num_buckets);
+    CREATE_ARR(places, place_t, n);
+    CREATE_ARR(slots, unsigned int, n);
+    ph->disp = disp;
+
+    bool placed = false;
+    for(unsigned long long seed = 0; seed < PHASH_MAX_SEEDS && !placed; seed++)
+    {
+        ph->seed = seed;
+        for(int i = 0; i < n; i++)
+        {
+            places[i] = p_Place(ph->num_buckets, ph->num_slots, p_Hash(kt, seed, keys[i]));
+        }
+        placed = p_Assign(ph, places, slots);
+    }
+
+    if(placed)
+    {
+        // Everything in slot order.
+        CREATE_ARR(index, unsigned int, n);
+        ph->index = index;
+
+        for(int i = 0; i < n; i++)
+        {
+            index[slots[i]] = (unsigned int)i;
+        }
+
+        if(kt == KEY_STRING)
+        {
+            CREATE_ARR(skeys, const char*, n);
+            for(int i = 0; i < n; i++)
+            {
+                CREATE_STR(s, strlen(keys[i].ks));
+                strcpy(s, keys[i].ks);
+                skeys[slots[i]] = s;
+            }
+            ph->skeys = skeys;
+        }
+        else // KEY_INT
+        {
+            CREATE_ARR(ikeys, int, n);
+            for(int i = 0; i < n; i++)
+            {
+                ikeys[slots[i]] = keys[i].ki;
+            }
+            ph->ikeys = ikeys;
+        }
+
+        if(values != NULL)
+        {
+            CREATE_ARR(vals, void*, n);
+            for(int i = 0; i < n; i++)
+            {
+                vals[slots[i]] = values[i];
+            }
+            ph->values = vals;
+        }
+    }
+
+    FREE(places);
+    FREE(slots);
+
+    if(!placed)
+    {
+        phash_Destroy(ph);
+        ph = BAD_PTR;
+    }
+
+    return ph;
+}
+
+//--------------------------------------------------------//
+int phash_Destroy(phash_t* ph)
+{
+    VAL_PTR(ph, RS_ERR);
+
+    // Generated ones are in read-only memory.
+    if(!ph->owned)
+    {
+        return RS_ERR;
+    }
+
+    if(ph->skeys != NULL)
+    {
+        for(unsigned int i = 0; i < ph->num_slots; i++)
+        {
+            FREE((char*)ph->skeys[i]);
+        }
+        FREE((char**)ph->skeys);
+    }
+
+    if(ph->ikeys != NULL)
+    {
+        FREE((int*)ph->ikeys);
+    }
+
+    if(ph->index != NULL)
+    {
+        FREE((unsigned int*)ph->index);
+    }
+
+    if(ph->values != NULL)
+    {
+        FREE((void**)ph->values);
+    }
+
+    FREE((unsigned int*)ph->disp);
+    FREE(ph);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int phash_Count(const phash_t* ph)
+{
+    VAL_PTR(ph, RS_ERR);
+
+    return (int)ph->num_slots;
+}
+
+//--------------------------------------------------------//
+int phash_Get(const phash_t* ph, key_t k, void** v)
+{
+    VAL_PTR(ph, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    int slot = p_Lookup(ph, k);
+
+    if(slot == RS_FAIL)
+    {
+        return RS_FAIL;
+    }
+
+    *v = ph->values != NULL ? ph->values[slot] : NULL;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int phash_Index(const phash_t* ph, key_t k)
+{
+    VAL_PTR(ph, RS_ERR);
+
+    int slot = p_Lookup(ph, k);
+
+    return slot != RS_FAIL ? (int)ph->index[slot] : RS_FAIL;
+}
+
+//--------------------------------------------------------//
+int phash_Write(const phash_t* ph, const char* name, const char* const* value_exprs, FILE* fp)
+{
+    VAL_PTR(ph, RS_ERR);
+    VAL_PTR(name, RS_ERR);
+    VAL_PTR(fp, RS_ERR);
+
+    fprintf(fp, "// Generated by phash_Write(). Do not edit.\n\n");
+    fprintf(fp, "#include \"phash.h\"\n\n");
+
+    fprintf(fp, "static const unsigned int %s_disp[] =\n{", name);
+    for(unsigned int i = 0; i < 2 * ph->num_buckets; i++)
+    {
+        fprintf(fp, "%s%u,", i % PHASH_LINE_ITEMS == 0 ? "\n    " : " ", ph->disp[i]);
+    }
+    fprintf(fp, "\n};\n\n");
+
+    if(ph->kt == KEY_STRING)
+    {
+        fprintf(fp, "static const char* const %s_skeys[] =\n{", name);
+        for(unsigned int i = 0; i < ph->num_slots; i++)
+        {
+            fprintf(fp, "\n    ");
+            p_WriteStr(fp, ph->skeys[i]);
+            fprintf(fp, ",");
+        }
+    }
+    else // KEY_INT
+    {
+        fprintf(fp, "static const int %s_ikeys[] =\n{", name);
+        for(unsigned int i = 0; i < ph->num_slots; i++)
+        {
+            fprintf(fp, "%s%d,", i % PHASH_LINE_ITEMS == 0 ? "\n    " : " ", ph->ikeys[i]);
+        }
+    }
+    fprintf(fp, "\n};\n\n");
+
+    fprintf(fp, "static const unsigned int %s_index[] =\n{", name);
+    for(unsigned int i = 0; i < ph->num_slots; i++)
+    {
+        fprintf(fp, "%s%u,", i % PHASH_LINE_ITEMS == 0 ? "\n    " : " ", ph->index[i]);
+    }
+    fprintf(fp, "\n};\n\n");
+
+    if(value_exprs != NULL)
+    {
+        fprintf(fp, "static void* const %s_values[] =\n{", name);
+        for(unsigned int i = 0; i < ph->num_slots; i++)
+        {
+            const char* expr = value_exprs[ph->index[i]];
+            fprintf(fp, "\n    (void*)(%s),", expr != NULL ? expr : "0");
+        }
+        fprintf(fp, "\n};\n\n");
+    }
+
+    fprintf(fp, "const phash_t %s =\n{\n", name);
+    fprintf(fp, "    %s,\n", ph->kt == KEY_STRING ? "KEY_STRING" : "KEY_INT");
+    fprintf(fp, "    0x%llXULL,\n", ph->seed);
+    fprintf(fp, "    %u,\n", ph->num_buckets);
+    fprintf(fp, "    %u,\n", ph->num_slots);
+    fprintf(fp, "    %s_disp,\n", name);
+    fprintf(fp, ph->kt == KEY_STRING ? "    %s_skeys,\n    NULL,\n" : "    NULL,\n    %s_ikeys,\n", name);
+    fprintf(fp, "    %s_index,\n", name);
+    if(value_exprs != NULL)
+    {
+        fprintf(fp, "    %s_values,\n", name);
+    }
+    else
+    {
+        fprintf(fp, "    NULL,\n");
+    }
+    fprintf(fp, "    false\n};\n");
+
+    return ferror(fp) ? RS_ERR : RS_PASS;
+}
+
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+place_t p_Place(unsigned int num_buckets, unsigned int num_slots, unsigned long long hash)
+{
+    // Multiply and shift to get into a range, cheaper than %. f2 uses remixed bits so it is independent of f1.
+    place_t p;
+    unsigned long long mixed = (hash ^ (hash >> 29)) * 0xBF58476D1CE4E5B9ULL;
+
+    p.bucket = (unsigned int)(((hash >> 32) * num_buckets) >> 32);
+    p.f1 = (unsigned int)(((hash & 0xFFFFFFFFULL) * num_slots) >> 32);
+    p.f2 = (unsigned int)(((mixed >> 32) * num_slots) >> 32);
+
+    return p;
+}
+
+//--------------------------------------------------------//
+unsigned int p_Slot(place_t p, const unsigned int* disp, unsigned int num_slots)
+{
+    return (unsigned int)((p.f1 + (unsigned long long)disp[0] * p.f2 + disp[1]) % num_slots);
+}
+
+//--------------------------------------------------------//
+unsigned long long p_Hash(keyType_t kt, unsigned long long seed, key_t k)
+{
+    return kt == KEY_STRING ? dict_HashFast(k.ks, strlen(k.ks), seed) : dict_HashFast(&k.ki, sizeof(k.ki), seed);
+}
+
+//--------------------------------------------------------//
+int p_Lookup(const phash_t* ph, key_t k)
+{
+    place_t p = p_Place(ph->num_buckets, ph->num_slots, p_Hash(ph->kt, ph->seed, k));
+    unsigned int slot = p_Slot(p, &ph->disp[2 * p.bucket], ph->num_slots);
+
+    // Every key has a slot, so anything else just has to not match what is there.
+    bool match = ph->kt == KEY_STRING ? strcmp(ph->skeys[slot], k.ks) == 0 : ph->ikeys[slot] == k.ki;
+
+    return match ? (int)slot : RS_FAIL;
+}
+
+//--------------------------------------------------------//
+bool p_Assign(phash_t* ph, const place_t* places, unsigned int* slots)
+{
+    unsigned int n = ph->num_slots;
+    unsigned int nb = ph->num_buckets;
+    unsigned int* disp = (unsigned int*)ph->disp;
+    bool ok = true;
+
+    // Group the keys by bucket.
+    CREATE_ARR(start, unsigned int, nb + 1);
+    CREATE_ARR(members, unsigned int, n);
+    CREATE_ARR(taken, bool, n);
+
+    unsigned int biggest = 0;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        start[places[i].bucket + 1]++;
+    }
+    for(unsigned int b = 0; b < nb; b++)
+    {
+        biggest = start[b + 1] > biggest ? start[b + 1] : biggest;
+        start[b + 1] += start[b];
+    }
+
+    CREATE_ARR(fill, unsigned int, nb);
+    for(unsigned int i = 0; i < n; i++)
+    {
+        unsigned int b = places[i].bucket;
+        members[start[b] + fill[b]++] = i;
+    }
+    FREE(fill);
+
+    memset(disp, 0, 2 * nb * sizeof(unsigned int));
+
+    // Biggest buckets first, while there is the most room.
+    unsigned int next_free = 0;
+
+    for(unsigned int size = biggest; size > 0 && ok; size--)
+    {
+        for(unsigned int b = 0; b < nb && ok; b++)
+        {
+            unsigned int first = start[b];
+
+            if(start[b + 1] - first != size)
+            {
+                continue;
+            }
+
+            if(size == 1)
+            {
+                // Any free slot will do so go straight to one.
+                while(taken[next_free])
+                {
+                    next_free++;
+                }
+
+                unsigned int i = members[first];
+                disp[2 * b + 1] = (next_free + n - places[i].f1) % n;
+                slots[i] = next_free;
+                taken[next_free] = true;
+                continue;
+            }
+
+            bool found = false;
+
+            for(unsigned int d0 = 0; d0 < n && d0 < PHASH_MAX_D0 && !found; d0++)
+            {
+                for(unsigned int d1 = 0; d1 < n && !found; d1++)
+                {
+                    unsigned int pair[2] = { d0, d1 };
+                    found = true;
+
+                    // Every key of the bucket in a free slot, and not on top of each other.
+                    for(unsigned int m = 0; m < size && found; m++)
+                    {
+                        unsigned int i = members[first + m];
+                        slots[i] = p_Slot(places[i], pair, n);
+                        found = !taken[slots[i]];
+
+                        for(unsigned int o = 0; o < m && found; o++)
+                        {
+                            found = slots[members[first + o]] != slots[i];
+                        }
+                    }
+
+                    if(found)
+                    {
+                        disp[2 * b] = d0;
+                        disp[2 * b + 1] = d1;
+                    }
+                }
+            }
+
+            for(unsigned int m = 0; m < size && found; m++)
+            {
+                taken[slots[members[first + m]]] = true;
+            }
+
+            ok = found;
+        }
+    }
+
+    FREE(start);
+    FREE(members);
+    FREE(taken);
+
+    return ok;
+}
+
+//--------------------------------------------------------//
+void p_WriteStr(FILE* fp, const char* ks)
+{
+    fprintf(fp, "\"");
+
+    for(const unsigned char* p = (const unsigned char*)ks; *p != 0; p++)
+    {
+        if(*p == '"' || *p == '\\')
+        {
+            fprintf(fp, "\\%c", *p);
+        }
+        else if(*p < 0x20 || *p >= 0x7F)
+        {
+            // Always 3 digits so a following digit isn't taken as part of it.
+            fprintf(fp, "\\%03o", *p);
+        }
+        else
+        {
+            fprintf(fp, "%c", *p);
+        }
+    }
+
+    fprintf(fp, "\"");
+}
@@ -0,0 +1,594 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "radix.h"
+
+
+/// @brief Definition of radix tree.
+/// Each node holds a run of key characters (its label), so a chain of single child nodes is stored as one
+/// node. The key of a node is the labels on the path from the root. Children are kept sorted by the first
+/// byte of their label, which is unique among siblings, so finding the next node is a search on one byte
+/// and a walk in child order gives sorted keys. Every node but the root has a value or at least two children,
+/// remove merges nodes to keep it that way.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Child array sizes go up in steps of this.
+#define RADIX_MIN_KIDS 2
+
+/// Most children a node can have, one per byte value.
+#define RADIX_MAX_KIDS 256
+
+/// One node of the tree.
+typedef struct rnode
+{
+    void* value;                ///> Client value | NULL if no key ends here.
+    struct rnode** kids;        ///> Children, sorted by first label byte. Their first bytes follow the pointers.
+    unsigned short num_kids;    ///> Children in use.
+    unsigned short cap_kids;    ///> Children room.
+    unsigned int len;           ///> Label length.
+    char label[];               ///> Label, not terminated. Allocated with room for what it was made with.
+} rnode_t;
+
+/// One level of a walk.
+typedef struct iframe
+{
+    rnode_t* node;              ///> The node.
+    int next;                   ///> Next child to visit | -1 if the node value is not reported yet.
+    unsigned int keylen;        ///> Key length through the end of this node label.
+} iframe_t;
+
+/// Definition of radix tree.
+struct radix
+{
+    rnode_t* root;              ///> Empty label, holds the "" key. Always there.
+    int count;                  ///> Number of keys.
+    iframe_t* stack;            ///> Walk state.
+    int depth;                  ///> Frames in use | 0 if no walk.
+    int stack_cap;              ///> Frames room.
+    char* kbuf;                 ///> Key of the current walk position.
+    unsigned int kbuf_cap;      ///> Key buffer room, including the terminator.
+};
+
+/// Make a node.
+/// @param label Label chars.
+/// @param len Label length.
+/// @return The node.
+static rnode_t* p_NewNode(const char* label, unsigned int len);
+
+/// Free a node and everything under it.
+/// @param n The node.
+static void p_FreeNode(rnode_t* n);
+
+/// First label bytes of the children of a node.
+/// @param n The node.
+/// @return The bytes.
+static unsigned char* p_Firsts(rnode_t* n);
+
+/// Find the child of a node whose label starts with a byte.
+/// @param n The node.
+/// @param c The byte.
+/// @param pos Where to put the index of the child, or where it would go.
+/// @return true if there is one.
+static bool p_FindKid(rnode_t* n, unsigned char c, int* pos);
+
+/// Add a child to a node.
+/// @param n The node.
+/// @param pos Where, from p_FindKid().
+/// @param kid The child.
+static void p_AddKid(rnode_t* n, int pos, rnode_t* kid);
+
+/// Take a child out of a node.
+/// @param n The node.
+/// @param pos Which.
+static void p_RemoveKid(rnode_t* n, int pos);
+
+/// Join a node that has no value with its only child.
+/// @param parent Parent of the node.
+/// @param n The node.
+static void p_Merge(rnode_t* parent, rnode_t* n);
+
+/// Make sure the walk key buffer has room.
+/// @param t The tree.
+/// @param len Key length needed.
+static void p_KeyRoom(radix_t* t, unsigned int len);
+
+/// Push a walk frame.
+/// @param t The tree.
+/// @param n Node.
+/// @param keylen Key length through the end of the node label.
+static void p_Push(radix_t* t, rnode_t* n, unsigned int keylen);
+
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+radix_t* radix_Create(void)
+{
+    CREATE_INST(t, radix_t);
+    VAL_PTR(t, BAD_PTR);
+
+    t->root = p_NewNode("", 0);
+    return t;
+}
+
+//--------------------------------------------------------//
+int radix_Destroy(radix_t* t)
+{
+    VAL_PTR(t, RS_ERR);
+
+    p_FreeNode(t->root);
+
+    if(t->stack != NULL)
+    {
+        FREE(t->stack);
+    }
+
+    if(t->kbuf != NULL)
+    {
+        FREE(t->kbuf);
+    }
+
+    FREE(t);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int radix_Clear(radix_t* t)
+{
+    VAL_PTR(t, RS_ERR);
+
+    p_FreeNode(t->root);
+    t->root = p_NewNode("", 0);
+    t->count = 0;
+    t->depth = 0;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int radix_Count(radix_t* t)
+{
+    VAL_PTR(t, RS_ERR);
+
+    return t->count;
+}
+
+//--------------------------------------------------------//
+int radix_Set(radix_t* t, const char* key, void* v)
+{
+    VAL_PTR(t, RS_ERR);
+    VAL_PTR(key, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    rnode_t* n = t->root;
+    const char* p = key;
+    t->depth = 0;
+
+    while(*p != 0)
+    {
+        int pos;
+
+        if(!p_FindKid(n, (unsigned char)*p, &pos))
+        {
+            // Rest of the key is a new leaf.
+            rnode_t* leaf = p_NewNode(p, (unsigned int)strlen(p));
+            leaf->value = v;
+            p_AddKid(n, pos, leaf);
+            t->count++;
+            return RS_PASS;
+        }
+
+        rnode_t* kid = n->kids[pos];
+        unsigned int m = 1;
+        while(m < kid->len && kid->label[m] == p[m])
+        {
+            m++;
+        }
+
+        if(m < kid->len)
+        {
+            // Key leaves the label part way. Split it, the front goes in a new node between.
+            rnode_t* mid = p_NewNode(kid->label, m);
+            memmove(kid->label, kid->label + m, kid->len - m);
+            kid->len -= m;
+            p_AddKid(mid, 0, kid);
+            n->kids[pos] = mid;
+            kid = mid;
+        }
+
+        n = kid;
+        p += m;
+    }
+
+    if(n->value != NULL)
+    {
+        FREE(n->value);
+    }
+    else
+    {
+        t->count++;
+    }
+
+    n->value = v;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int radix_Get(radix_t* t, const char* key, void** v)
+{
+    VAL_PTR(t, RS_ERR);
+    VAL_PTR(key, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    rnode_t* n = t->root;
+    const char* p = key;
+
+    while(*p != 0)
+    {
+        int pos;
+
+        // strncmp() stops at the end of the key, labels have no terminators in them.
+        if(!p_FindKid(n, (unsigned char)*p, &pos) || strncmp(n->kids[pos]->label, p, n->kids[pos]->len) != 0)
+        {
+            return RS_FAIL;
+        }
+
+        n = n->kids[pos];
+        p += n->len;
+    }
+
+    if(n->value == NULL)
+    {
+        return RS_FAIL;
+    }
+
+    *v = n->value;
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int radix_Remove(radix_t* t, const char* key, void** v)
+{
+    VAL_PTR(t, RS_ERR);
+    VAL_PTR(key, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    rnode_t* gparent = NULL;
+    rnode_t* parent = NULL;
+    rnode_t* n = t->root;
+    int pos = 0;
+    const char* p = key;
+
+    while(*p != 0)
+    {
+        if(!p_FindKid(n, (unsigned char)*p, &pos) || strncmp(n->kids[pos]->label, p, n->kids[pos]->len) != 0)
+        {
+            return RS_FAIL;
+        }
+
+        gparent = parent;
+        parent = n;
+        n = n->kids[pos];
+        p += n->len;
+    }
+
+    if(n->value == NULL)
+    {
+        return RS_FAIL;
+    }
+
+    *v = n->value;
+    n->value = NULL;
+    t->count--;
+    t->depth = 0;
+
+    // Tidy up so every node but the root still has a value or two children.
+    if(parent == NULL)
+    {
+        // Root stays.
+    }
+    else if(n->num_kids == 0)
+    {
+        p_RemoveKid(parent, pos);
+        p_FreeNode(n);
+
+        if(gparent != NULL && parent->value == NULL && parent->num_kids == 1)
+        {
+            p_Merge(gparent, parent);
+        }
+    }
+    else if(n->num_kids == 1)
+    {
+        p_Merge(parent, n);
+    }
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int radix_IterStart(radix_t* t, const char* prefix)
+{
+    VAL_PTR(t, RS_ERR);
+    VAL_PTR(prefix, RS_ERR);
+
+    rnode_t* n = t->root;
+    const char* p = prefix;
+    unsigned int base = 0;
+    t->depth = 0;
+
+    // Find the top node of everything under the prefix. The prefix may end part way into its label.
+    while(*p != 0)
+    {
+        int pos;
+
+        if(!p_FindKid(n, (unsigned char)*p, &pos))
+        {
+            return RS_FAIL;
+        }
+
+        rnode_t* kid = n->kids[pos];
+        size_t rest = strlen(p);
+
+        if(rest <= kid->len)
+        {
+            if(memcmp(kid->label, p, rest) != 0)
+            {
+                return RS_FAIL;
+            }
+
+            base = (unsigned int)(p - prefix);
+            n = kid;
+            break;
+        }
+
+        if(memcmp(kid->label, p, kid->len) != 0)
+        {
+            return RS_FAIL;
+        }
+
+        base = (unsigned int)(p - prefix);
+        n = kid;
+        p += kid->len;
+    }
+
+    if(n == t->root && t->count == 0)
+    {
+        return RS_FAIL;
+    }
+
+    // Key so far is the prefix up to this node then all of its label.
+    unsigned int keylen = base + n->len;
+    p_KeyRoom(t, keylen);
+    memcpy(t->kbuf, prefix, base);
+    memcpy(t->kbuf + base, n->label, n->len);
+    p_Push(t, n, keylen);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int radix_IterNext(radix_t* t, const char** key, void** v)
+{
+    VAL_PTR(t, RS_ERR);
+    VAL_PTR(key, RS_ERR);
+    VAL_PTR(v, RS_ERR);
+
+    while(t->depth > 0)
+    {
+        iframe_t* f = &t->stack[t->depth - 1];
+
+        if(f->next < 0)
+        {
+            f->next = 0;
+
+            if(f->node->value != NULL)
+            {
+                t->kbuf[f->keylen] = 0;
+                *key = t->kbuf;
+                *v = f->node->value;
+                return RS_PASS;
+            }
+        }
+        else if(f->next < f->node->num_kids)
+        {
+            rnode_t* kid = f->node->kids[f->next++];
+            unsigned int keylen = f->keylen + kid->len;
+            p_KeyRoom(t, keylen);
+            memcpy(t->kbuf + f->keylen, kid->label, kid->len);
+            p_Push(t, kid, keylen);
+        }
+        else
+        {
+            t->depth--;
+        }
+    }
+
+    return RS_FAIL;
+}
+
+
+//---------------- Private Implementation --------------------------//
+
+//--------------------------------------------------------//
+rnode_t* p_NewNode(const char* label, unsigned int len)
+{
+    rnode_t* n = (rnode_t*)calloc(1, sizeof(rnode_t) + len);
+    _CREATE(n);
+
+    memcpy(n->label, label, len);
+    n->len = len;
+
+    return n;
+}
+
+//--------------------------------------------------------//
+void p_FreeNode(rnode_t* n)
+{
+    for(int i = 0; i < n->num_kids; i++)
+    {
+        p_FreeNode(n->kids[i]);
+    }
+
+    if(n->kids != NULL)
+    {
+        FREE(n->kids);
+    }
+
+    if(n->value != NULL)
+    {
+        FREE(n->value);
+    }
+
+    FREE(n);
+}
+
+//--------------------------------------------------------//
+unsigned char* p_Firsts(rnode_t* n)
+{
+    return (unsigned char*)(n->kids + n->cap_kids);
+}
+
+//--------------------------------------------------------//
+bool p_FindKid(rnode_t* n, unsigned char c, int* pos)
+{
+    unsigned char* firsts = p_Firsts(n);
+    int lo = 0;
+    int hi = n->num_kids;
+
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if(firsts[mid] < c)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    *pos = lo;
+
+    return lo < n->num_kids && firsts[lo] == c;
+}
+
+//--------------------------------------------------------//
+void p_AddKid(rnode_t* n, int pos, rnode_t* kid)
+{
+    if(n->num_kids == n->cap_kids)
+    {
+        // Pointers then first bytes in one block.
+        int cap = n->cap_kids == 0 ? RADIX_MIN_KIDS : n->cap_kids * 2;
+        cap = cap > RADIX_MAX_KIDS ? RADIX_MAX_KIDS : cap;
+        rnode_t** kids = (rnode_t**)calloc(cap, sizeof(rnode_t*) + 1);
+        _CREATE(kids);
+
+        if(n->kids != NULL)
+        {
+            memcpy(kids, n->kids, n->num_kids * sizeof(rnode_t*));
+            memcpy(kids + cap, p_Firsts(n), n->num_kids);
+            FREE(n->kids);
+        }
+
+        n->kids = kids;
+        n->cap_kids = (unsigned short)cap;
+    }
+
+    unsigned char* firsts = p_Firsts(n);
+    int after = n->num_kids - pos;
+    memmove(n->kids + pos + 1, n->kids + pos, after * sizeof(rnode_t*));
+    memmove(firsts + pos + 1, firsts + pos, after);
+    n->kids[pos] = kid;
+    firsts[pos] = (unsigned char)kid->label[0];
+    n->num_kids++;
+}
+
+//--------------------------------------------------------//
+void p_RemoveKid(rnode_t* n, int pos)
+{
+    unsigned char* firsts = p_Firsts(n);
+    int after = n->num_kids - pos - 1;
+    memmove(n->kids + pos, n->kids + pos + 1, after * sizeof(rnode_t*));
+    memmove(firsts + pos, firsts + pos + 1, after);
+    n->num_kids--;
+}
+
+//--------------------------------------------------------//
+void p_Merge(rnode_t* parent, rnode_t* n)
+{
+    rnode_t* kid = n->kids[0];
+    int pos;
+    p_FindKid(parent, (unsigned char)n->label[0], &pos);
+
+    // The joined node takes over the child.
+    rnode_t* joined = (rnode_t*)calloc(1, sizeof(rnode_t) + n->len + kid->len);
+    _CREATE(joined);
+    memcpy(joined->label, n->label, n->len);
+    memcpy(joined->label + n->len, kid->label, kid->len);
+    joined->len = n->len + kid->len;
+    joined->value = kid->value;
+    joined->kids = kid->kids;
+    joined->num_kids = kid->num_kids;
+    joined->cap_kids = kid->cap_kids;
+    parent->kids[pos] = joined;
+
+    FREE(n->kids);
+    FREE(n);
+    FREE(kid);
+}
+
+//--------------------------------------------------------//
+void p_KeyRoom(radix_t* t, unsigned int len)
+{
+    if(len + 1 > t->kbuf_cap)
+    {
+        unsigned int cap = t->kbuf_cap == 0 ? 64 : t->kbuf_cap;
+        while(cap < len + 1)
+        {
+            cap *= 2;
+        }
+
+        CREATE_STR(kbuf, cap - 1);
+        if(t->kbuf != NULL)
+        {
+            memcpy(kbuf, t->kbuf, t->kbuf_cap);
+            FREE(t->kbuf);
+        }
+
+        t->kbuf = kbuf;
+        t->kbuf_cap = cap;
+    }
+}
+
+//--------------------------------------------------------//
+void p_Push(radix_t* t, rnode_t* n, unsigned int keylen)
+{
+    if(t->depth == t->stack_cap)
+    {
+        int cap = t->stack_cap == 0 ? 16 : t->stack_cap * 2;
+        CREATE_ARR(stack, iframe_t, cap);
+
+        if(t->stack != NULL)
+        {
+            memcpy(stack, t->stack, t->depth * sizeof(iframe_t));
+            FREE(t->stack);
+        }
+
+        t->stack = stack;
+        t->stack_cap = cap;
+    }
+
+    iframe_t* f = &t->stack[t->depth++];
+    f->node = n;
+    f->next = -1;
+    f->keylen = keylen;
+}
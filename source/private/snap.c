@@ -0,0 +1,203 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "dict.h"
+#include "snap.h"
+#include "atomics.h"
+
+
+/// @brief Definition of snapshot thing.
+/// Grace periods use a global epoch. A reader records the epoch when it acquires and clears it on release.
+/// After swapping in a new dict the publisher bumps the epoch and waits until no reader is still in an
+/// older one. Any reader that acquires after the swap gets the new dict so doesn't count.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Per reader state. A cache line each so readers don't slow each other down.
+typedef struct reader
+{
+    unsigned long long epoch;   ///> Epoch when it acquired, 0 if not holding anything.
+    int used;                   ///> Registered.
+    char pad[64];               ///> Keeps the next reader off this cache line.
+} reader_t;
+
+/// One instance of a snapshot holder.
+struct snap
+{
+    dict_t* current;            ///> What readers get. NULL until the first publish.
+    unsigned long long epoch;   ///> Bumped on each publish.
+    int max_readers;            ///> Size of readers.
+    reader_t* readers;          ///> Reader slots.
+    pthread_mutex_t lock;       ///> One publisher at a time.
+};
+
+/// Wait until no reader is in an epoch before this one.
+/// @param s The snap.
+/// @param epoch The new epoch.
+static void p_WaitReaders(snap_t* s, unsigned long long epoch);
+
+/// Check a reader id.
+/// @param s The snap.
+/// @param reader The id.
+/// @return True if registered.
+static bool p_ValidReader(snap_t* s, int reader);
+
+
+//---------------- Public API Implementation -------------//
+
+//--------------------------------------------------------//
+snap_t* snap_Create(int max_readers)
+{
+    if(max_readers <= 0)
+    {
+        return BAD_PTR;
+    }
+
+    CREATE_INST(s, snap_t);
+    CREATE_ARR(readers, reader_t, max_readers);
+
+    s->epoch = 1;
+    s->max_readers = max_readers;
+    s->readers = readers;
+    pthread_mutex_init(&s->lock, NULL);
+
+    return s;
+}
+
+//--------------------------------------------------------//
+int snap_Destroy(snap_t* s)
+{
+    VAL_PTR(s, RS_ERR);
+
+    if(s->current != NULL)
+    {
+        dict_Destroy(s->current);
+    }
+
+    pthread_mutex_destroy(&s->lock);
+    FREE(s->readers);
+    FREE(s);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int snap_Register(snap_t* s)
+{
+    VAL_PTR(s, RS_ERR);
+
+    int ret = RS_ERR;
+
+    for(int i = 0; i < s->max_readers && ret == RS_ERR; i++)
+    {
+        int unused = 0;
+        if(ATOM_CAS_INT(&s->readers[i].used, &unused, 1, ATOM_ACQ_REL))
+        {
+            ret = i;
+        }
+    }
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+int snap_Unregister(snap_t* s, int reader)
+{
+    VAL_PTR(s, RS_ERR);
+
+    if(!p_ValidReader(s, reader))
+    {
+        return RS_ERR;
+    }
+
+    ATOM_STORE_U64(&s->readers[reader].epoch, 0, ATOM_RELEASE);
+    ATOM_STORE_INT(&s->readers[reader].used, 0, ATOM_RELEASE);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+dict_t* snap_Acquire(snap_t* s, int reader)
+{
+    VAL_PTR(s, BAD_PTR);
+
+    if(!p_ValidReader(s, reader))
+    {
+        return BAD_PTR;
+    }
+
+    // Say we are in before looking, so a publisher that swaps after this waits for us.
+    ATOM_STORE_U64(&s->readers[reader].epoch, ATOM_LOAD_U64(&s->epoch, ATOM_SEQ_CST), ATOM_SEQ_CST);
+
+    return (dict_t*)ATOM_LOAD_PTR(&s->current, ATOM_SEQ_CST);
+}
+
+//--------------------------------------------------------//
+int snap_Release(snap_t* s, int reader)
+{
+    VAL_PTR(s, RS_ERR);
+
+    if(!p_ValidReader(s, reader))
+    {
+        return RS_ERR;
+    }
+
+    // Everything read from the dict happens before this.
+    ATOM_STORE_U64(&s->readers[reader].epoch, 0, ATOM_RELEASE);
+
+    return RS_PASS;
+}
+
+//--------------------------------------------------------//
+int snap_Publish(snap_t* s, dict_t* d)
+{
+    VAL_PTR(s, RS_ERR);
+    VAL_PTR(d, RS_ERR);
+
+    int ret = dict_Freeze(d);
+
+    if(ret == RS_PASS)
+    {
+        pthread_mutex_lock(&s->lock);
+
+        dict_t* old = (dict_t*)ATOM_EXCHANGE_PTR(&s->current, d, ATOM_SEQ_CST);
+        unsigned long long epoch = ATOM_ADD_U64(&s->epoch, 1, ATOM_SEQ_CST);
+
+        if(old != NULL)
+        {
+            p_WaitReaders(s, epoch);
+            dict_Destroy(old);
+        }
+
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    return ret;
+}
+
+
+//---------------- Private Implementation --------------//
+
+//--------------------------------------------------------//
+void p_WaitReaders(snap_t* s, unsigned long long epoch)
+{
+    for(int i = 0; i < s->max_readers; i++)
+    {
+        unsigned long long e = ATOM_LOAD_U64(&s->readers[i].epoch, ATOM_ACQUIRE);
+
+        while(e != 0 && e < epoch)
+        {
+            ATOM_YIELD();
+            e = ATOM_LOAD_U64(&s->readers[i].epoch, ATOM_ACQUIRE);
+        }
+    }
+}
+
+//--------------------------------------------------------//
+bool p_ValidReader(snap_t* s, int reader)
+{
+    return reader >= 0 && reader < s->max_readers && ATOM_LOAD_INT(&s->readers[reader].used, ATOM_RELAXED);
+}
@@ -0,0 +1,73 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdbool.h>
+#include "common.h"
+
+/// @brief Declaration of a radix tree of string keys, for hierarchical names like "plant/line3/motor7/temp"
+/// where you want everything under a prefix. Shared runs of characters are stored once, so finding a prefix
+/// costs the length of the prefix, not the number of keys, and walking what is under it copies nothing.
+/// Keys come out in sorted order.
+/// Values follow the same rules as dict: they are client pointers that the tree frees in radix_Set() when
+/// replaced, and in radix_Clear() and radix_Destroy(). radix_Remove() hands them back.
+
+
+//---------------- Public API ----------------------//
+
+/// Opaque radix tree object.
+typedef struct radix radix_t;
+
+/// Create an empty tree.
+/// @return The opaque pointer used in all functions | BAD_PTR.
+radix_t* radix_Create(void);
+
+/// Deletes all nodes and frees the values, frees the tree struct.
+/// @param t The radix opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int radix_Destroy(radix_t* t);
+
+/// Deletes all nodes and frees the values.
+/// @param t The radix opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int radix_Clear(radix_t* t);
+
+/// Number of keys.
+/// @param t The radix opaque pointer.
+/// @return The count | RS_ERR.
+int radix_Count(radix_t* t);
+
+/// Add or replace an entry. The key is copied.
+/// @param t The radix opaque pointer.
+/// @param key The key. May be "".
+/// @param v The value. The tree takes ownership. Replaces and frees any existing.
+/// @return RS_PASS | RS_ERR.
+int radix_Set(radix_t* t, const char* key, void* v);
+
+/// Get an entry.
+/// @param t The radix opaque pointer.
+/// @param key The key.
+/// @param v Where to put the value.
+/// @return RS_PASS | RS_FAIL if not there | RS_ERR.
+int radix_Get(radix_t* t, const char* key, void** v);
+
+/// Remove an entry.
+/// @param t The radix opaque pointer.
+/// @param key The key.
+/// @param v Where to put the value. Client takes ownership of it now!
+/// @return RS_PASS | RS_FAIL if not there | RS_ERR.
+int radix_Remove(radix_t* t, const char* key, void** v);
+
+/// Start walking all the keys that start with prefix, in sorted order. The tree must not change during the walk.
+/// @param t The radix opaque pointer.
+/// @param prefix What the keys start with. "" for all.
+/// @return RS_PASS | RS_FAIL if there are none | RS_ERR.
+int radix_IterStart(radix_t* t, const char* prefix);
+
+/// Next key of the walk. Nothing is allocated or copied per key.
+/// @param t The radix opaque pointer.
+/// @param key Where to put the key. Only valid until the next call.
+/// @param v Where to put the value.
+/// @return RS_PASS | RS_FAIL at the end | RS_ERR.
+int radix_IterNext(radix_t* t, const char** key, void** v);
+
+#endif // RADIX_H
@@ -0,0 +1,59 @@
+#ifndef SNAP_H
+#define SNAP_H
+
+#include "dict.h"
+
+/// @brief Declaration of a published dict snapshot for read-mostly data shared by threads.
+/// A writer builds a whole new dict off to the side and publishes it in one step. Readers get whichever
+/// version is current without ever blocking or taking a lock. A replaced version is destroyed once every
+/// reader that could have seen it has released it, like RCU.
+/// Published dicts are frozen (see dict_Freeze()) so readers can share them.
+
+
+//---------------- Public API ----------------------//
+
+/// Opaque snapshot object.
+typedef struct snap snap_t;
+
+/// Create a snapshot holder with nothing published yet.
+/// @param max_readers Most threads registered at once.
+/// @return The opaque pointer used in all functions | BAD_PTR.
+snap_t* snap_Create(int max_readers);
+
+/// Destroy it and the current dict. No readers may be between acquire and release.
+/// @param s The snap opaque pointer.
+/// @return RS_PASS | RS_ERR.
+int snap_Destroy(snap_t* s);
+
+/// Register the calling thread as a reader.
+/// @param s The snap opaque pointer.
+/// @return Reader id for the other reader calls | RS_ERR if max_readers are registered.
+int snap_Register(snap_t* s);
+
+/// Give back a reader id. Must not be holding a dict.
+/// @param s The snap opaque pointer.
+/// @param reader From snap_Register().
+/// @return RS_PASS | RS_ERR.
+int snap_Unregister(snap_t* s, int reader);
+
+/// Get the current dict. Never blocks. It stays valid until snap_Release(), so don't hang on to it
+/// longer than needed because that holds up reclaiming replaced versions. Doesn't nest.
+/// @param s The snap opaque pointer.
+/// @param reader From snap_Register().
+/// @return The dict | BAD_PTR if nothing published yet or bad reader.
+dict_t* snap_Acquire(snap_t* s, int reader);
+
+/// Done with the dict from snap_Acquire(). This is the quiescent point.
+/// @param s The snap opaque pointer.
+/// @param reader From snap_Register().
+/// @return RS_PASS | RS_ERR.
+int snap_Release(snap_t* s, int reader);
+
+/// Freeze a dict and make it the current one. Waits for readers still holding the previous version,
+/// then destroys it. The snap owns d now.
+/// @param s The snap opaque pointer.
+/// @param d New version.
+/// @return RS_PASS | RS_ERR.
+int snap_Publish(snap_t* s, dict_t* d);
+
+#endif // SNAP_H
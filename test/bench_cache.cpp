@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+#include "cache.h"
+}
+
+// From bench_dict.cpp.
+double bench_NowNs(void);
+
+// Cache size and key space.
+static const int CBENCH_ENTRIES = 1000;
+static const int CBENCH_KEYS = 20000;
+
+// Lookups per run.
+static const int CBENCH_OPS = 1000000;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_CACHE, "Skewed lookups through a 1000 entry cache: dict + recency array with a linear scan vs cache_t LRU and CLOCK.")
+{
+    // Skewed so a small set of keys gets most of the lookups.
+    std::vector<int> ops(CBENCH_OPS);
+    srand(3);
+    for(int i = 0; i < CBENCH_OPS; i++)
+    {
+        double r = (double)rand() / RAND_MAX;
+        ops[i] = (int)(r * r * r * CBENCH_KEYS);
+    }
+
+    key_t key;
+    void* v;
+
+    // Hand rolled: dict for lookups, array in recency order searched on every hit.
+    int hits = 0;
+    dict_t* d = dict_Create(KEY_INT);
+    std::vector<int> recent;
+    double t0 = bench_NowNs();
+    for(int i = 0; i < CBENCH_OPS; i++)
+    {
+        key.ki = ops[i];
+        if(dict_Get(d, key, &v) == RS_PASS)
+        {
+            hits++;
+            size_t at = 0;
+            while(recent[at] != ops[i])
+            {
+                at++;
+            }
+            memmove(&recent[1], &recent[0], at * sizeof(int));
+            recent[0] = ops[i];
+        }
+        else
+        {
+            if((int)recent.size() == CBENCH_ENTRIES)
+            {
+                key.ki = recent.back();
+                recent.pop_back();
+                dict_Remove(d, key, &v);
+                FREE(v);
+                key.ki = ops[i];
+            }
+            CREATE_INST(pi, int);
+            dict_Set(d, key, pi);
+            recent.insert(recent.begin(), ops[i]);
+        }
+    }
+    double t1 = bench_NowNs();
+    UT_PROPERTY("scan_op_ns", (t1 - t0) / CBENCH_OPS);
+    UT_PROPERTY("scan_hit_rate", (double)hits / CBENCH_OPS);
+    dict_Destroy(d);
+
+    cachePolicy_t policies[] = { CACHE_LRU, CACHE_CLOCK };
+    const char* names[] = { "lru", "clock" };
+    for(int p = 0; p < 2; p++)
+    {
+        cache_t* c = cache_Create(KEY_INT, CBENCH_ENTRIES, 0, policies[p]);
+        double t2 = bench_NowNs();
+        for(int i = 0; i < CBENCH_OPS; i++)
+        {
+            key.ki = ops[i];
+            if(cache_Get(c, key, &v) != RS_PASS)
+            {
+                CREATE_INST(pi, int);
+                cache_Put(c, key, pi, 1);
+            }
+        }
+        double t3 = bench_NowNs();
+
+        cache_stats_t stats;
+        cache_GetStats(c, &stats);
+        UT_EQUAL(stats.hits + stats.misses, (unsigned long long)CBENCH_OPS);
+        UT_PROPERTY(std::string(names[p]) + "_op_ns", (t3 - t2) / CBENCH_OPS);
+        UT_PROPERTY(std::string(names[p]) + "_hit_rate", (double)stats.hits / CBENCH_OPS);
+        cache_Destroy(c);
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+#include "cdict.h"
+}
+
+// Keys in the table.
+static const int CBENCH_NUM_KEYS = 1000000;
+
+// Operations per thread.
+static const int CBENCH_OPS = 2000000;
+
+// Percent of operations that are writes.
+static const int CBENCH_WRITE_PCT = 10;
+
+// Value stored.
+typedef struct
+{
+    long long count;
+    double total;
+} cbench_val_t;
+
+// Helpers.
+double cbench_NowNs(void);
+double cbench_Run(int num_threads, void (*work)(void* arg, unsigned long long seed), void* arg);
+void cbench_CdictWork(void* arg, unsigned long long seed);
+void cbench_LockedWork(void* arg, unsigned long long seed);
+
+// The baseline: a plain inline dict behind one lock.
+typedef struct
+{
+    dict_t* d;
+    std::mutex lock;
+} cbench_locked_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_CDICT_SCALE, "Throughput of 90% get / 10% set on 1M int keys, 1 to N threads, cdict vs one lock around a dict.")
+{
+    cdict_t* cd = cdict_Create(KEY_INT, sizeof(cbench_val_t), 0);
+    cbench_locked_t locked;
+    locked.d = dict_CreateInlineEx(KEY_INT, CBENCH_NUM_KEYS, DICT_OPEN, sizeof(cbench_val_t));
+
+    key_t key;
+    cbench_val_t val = { 0, 0 };
+    for(int i = 0; i < CBENCH_NUM_KEYS; i++)
+    {
+        key.ki = i;
+        cdict_Set(cd, key, &val);
+        dict_Set(locked.d, key, &val);
+    }
+
+    // Up to the cores we have, and past that a bit to see what contention does.
+    int max_threads = (int)std::thread::hardware_concurrency();
+    max_threads = max_threads > 4 ? max_threads : 4;
+
+    for(int n = 1; n <= max_threads; n *= 2)
+    {
+        double cdict_ns = cbench_Run(n, cbench_CdictWork, cd);
+        double locked_ns = cbench_Run(n, cbench_LockedWork, &locked);
+
+        UT_PROPERTY("cdict_mops_" + std::to_string(n), (double)n * CBENCH_OPS / cdict_ns * 1000);
+        UT_PROPERTY("locked_mops_" + std::to_string(n), (double)n * CBENCH_OPS / locked_ns * 1000);
+    }
+
+    UT_EQUAL(cdict_Count(cd), CBENCH_NUM_KEYS);
+    cdict_Destroy(cd);
+    dict_Destroy(locked.d);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+double cbench_Run(int num_threads, void (*work)(void* arg, unsigned long long seed), void* arg)
+{
+    std::vector<std::thread> threads;
+
+    double start = cbench_NowNs();
+    for(int t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back(work, arg, (unsigned long long)t * 7919 + 1);
+    }
+    for(size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+
+    return cbench_NowNs() - start;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void cbench_CdictWork(void* arg, unsigned long long seed)
+{
+    cdict_t* cd = (cdict_t*)arg;
+    key_t key;
+    cbench_val_t val;
+
+    for(int i = 0; i < CBENCH_OPS; i++)
+    {
+        // xorshift, cheap and per thread.
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        key.ki = (int)(seed % CBENCH_NUM_KEYS);
+
+        if((int)(seed >> 32) % 100 < CBENCH_WRITE_PCT)
+        {
+            val.count = i;
+            val.total = i * 0.5;
+            cdict_Set(cd, key, &val);
+        }
+        else
+        {
+            cdict_Get(cd, key, &val);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void cbench_LockedWork(void* arg, unsigned long long seed)
+{
+    cbench_locked_t* locked = (cbench_locked_t*)arg;
+    key_t key;
+    cbench_val_t val;
+    cbench_val_t* pval;
+
+    for(int i = 0; i < CBENCH_OPS; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        key.ki = (int)(seed % CBENCH_NUM_KEYS);
+
+        std::lock_guard<std::mutex> guard(locked->lock);
+        if((int)(seed >> 32) % 100 < CBENCH_WRITE_PCT)
+        {
+            val.count = i;
+            val.total = i * 0.5;
+            dict_Set(locked->d, key, &val);
+        }
+        else if(dict_Get(locked->d, key, (void**)&pval) == RS_PASS)
+        {
+            // Copy out under the lock, same as cdict.
+            val = *pval;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+double cbench_NowNs(void)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,736 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+}
+
+// Synthetic key set size.
+static const int BIG_NUM_KEYS = 1000000;
+
+// The dict flavors to compare.
+typedef struct
+{
+    const char* name;
+    unsigned int opts;
+} flavor_t;
+
+static const flavor_t FLAVORS[] =
+{
+    { "chained", DICT_CHAINED },
+    { "open",    DICT_OPEN },
+    { "group",   DICT_GROUP },
+    { "chained_arena", DICT_CHAINED | DICT_ARENA },
+};
+
+static const int NUM_FLAVORS = sizeof(FLAVORS) / sizeof(FLAVORS[0]);
+
+// What one run measured.
+typedef struct
+{
+    double set_ns;      // per dict_Set()
+    double hit_ns;      // per dict_Get() that finds
+    double miss_ns;     // per dict_Get() that doesn't
+    int found;          // sanity check
+} bench_result_t;
+
+// Helpers.
+std::vector<std::string> bench_ReadWords(const char* fn);
+std::vector<std::string> bench_SplitWords(const char* fn);
+std::vector<std::string> bench_MakeKeys(const char* fmt, int num);
+bench_result_t bench_Run(unsigned int opts, const std::vector<std::string>& keys, const std::vector<std::string>& misses, int rounds);
+double bench_NowNs(void);
+long long bench_HeapBytes(void);
+
+// What a CSV line holds.
+typedef struct { long long id; double reading; } sample_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_SMALL, "Dict flavors on the 184 keys that make dict_101.csv (hemingway_short.txt).")
+{
+    std::vector<std::string> keys = bench_ReadWords("hemingway_short.txt");
+    std::vector<std::string> misses = bench_MakeKeys("NOT_A_WORD_%d", (int)keys.size());
+    UT_EQUAL(keys.size(), 184);
+
+    for(int f = 0; f < NUM_FLAVORS; f++)
+    {
+        bench_result_t res = bench_Run(FLAVORS[f].opts, keys, misses, 5000);
+        std::string name = FLAVORS[f].name;
+        UT_EQUAL(res.found, (int)keys.size());
+        UT_PROPERTY(name + "_set_ns", res.set_ns);
+        UT_PROPERTY(name + "_hit_ns", res.hit_ns);
+        UT_PROPERTY(name + "_miss_ns", res.miss_ns);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_BIG, "Dict flavors on 1M synthetic keys with long common prefixes.")
+{
+    std::vector<std::string> keys = bench_MakeKeys("plant/line3/sensor%07d/temp", BIG_NUM_KEYS);
+    std::vector<std::string> misses = bench_MakeKeys("plant/line3/sensor%07d/pressure", BIG_NUM_KEYS);
+
+    for(int f = 0; f < NUM_FLAVORS; f++)
+    {
+        bench_result_t res = bench_Run(FLAVORS[f].opts, keys, misses, 1);
+        std::string name = FLAVORS[f].name;
+        UT_EQUAL(res.found, BIG_NUM_KEYS);
+        UT_PROPERTY(name + "_set_ns", res.set_ns);
+        UT_PROPERTY(name + "_hit_ns", res.hit_ns);
+        UT_PROPERTY(name + "_miss_ns", res.miss_ns);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_WORDS, "Word frequency over hemingway.txt: dict_Get() + dict_Set() vs dict_GetOrInsert().")
+{
+    std::vector<std::string> words = bench_SplitWords("hemingway.txt");
+    UT_GREATER(words.size(), 100000);
+
+    for(int f = 0; f < NUM_FLAVORS; f++)
+    {
+        std::string name = FLAVORS[f].name;
+        key_t key;
+
+        // The two call pattern. Each hit replaces the value.
+        dict_t* d = dict_CreateEx(KEY_STRING, 0, FLAVORS[f].opts);
+        double start = bench_NowNs();
+        for(size_t i = 0; i < words.size(); i++)
+        {
+            int* pcnt;
+            key.ks = words[i].c_str();
+            CREATE_INST(pnew, int);
+            *pnew = dict_Get(d, key, (void**)&pcnt) == RS_PASS ? *pcnt + 1 : 1;
+            dict_Set(d, key, pnew);
+        }
+        double get_set_ns = (bench_NowNs() - start) / words.size();
+
+        int* pthe1 = NULL;
+        key.ks = "THE";
+        dict_Get(d, key, (void**)&pthe1);
+        int the1 = *pthe1;
+        dict_Destroy(d);
+
+        // One probe, update in place.
+        d = dict_CreateEx(KEY_STRING, 0, FLAVORS[f].opts);
+        start = bench_NowNs();
+        for(size_t i = 0; i < words.size(); i++)
+        {
+            void** slot;
+            bool inserted;
+            key.ks = words[i].c_str();
+            dict_GetOrInsert(d, key, &slot, &inserted);
+            if(inserted)
+            {
+                CREATE_INST(pnew, int);
+                *slot = pnew;
+            }
+            (*(int*)*slot)++;
+        }
+        double upsert_ns = (bench_NowNs() - start) / words.size();
+
+        int* pthe2 = NULL;
+        key.ks = "THE";
+        dict_Get(d, key, (void**)&pthe2);
+        UT_EQUAL(*pthe2, the1);
+        dict_Destroy(d);
+
+        UT_PROPERTY(name + "_get_set_ns", get_set_ns);
+        UT_PROPERTY(name + "_upsert_ns", upsert_ns);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_LATENCY, "Slowest single dict_Set() while growing to 1M keys, all at once vs DICT_INCREMENTAL.")
+{
+    std::vector<std::string> keys = bench_MakeKeys("plant/line3/sensor%07d/temp", BIG_NUM_KEYS);
+    const flavor_t flavors[] = { { "chained", DICT_CHAINED }, { "incremental", DICT_INCREMENTAL } };
+
+    for(int f = 0; f < 2; f++)
+    {
+        std::string name = flavors[f].name;
+        dict_t* d = dict_CreateEx(KEY_STRING, 0, flavors[f].opts);
+        key_t key;
+        double worst = 0;
+
+        double start = bench_NowNs();
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            CREATE_INST(pi, int);
+            key.ks = keys[i].c_str();
+
+            double t0 = bench_NowNs();
+            dict_Set(d, key, pi);
+            double t1 = bench_NowNs();
+
+            worst = t1 - t0 > worst ? t1 - t0 : worst;
+        }
+        double total = bench_NowNs() - start;
+
+        UT_EQUAL(dict_Count(d), BIG_NUM_KEYS);
+        dict_Destroy(d);
+
+        UT_PROPERTY(name + "_max_set_us", worst / 1000);
+        UT_PROPERTY(name + "_total_ms", total / 1000000);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_INLINE, "1M 16 byte values as malloc'd pointers vs dict_CreateInline(), DICT_OPEN.")
+{
+    std::vector<std::string> keys = bench_MakeKeys("k%07d", BIG_NUM_KEYS);
+    const char* names[] = { "pointer", "inline" };
+
+    for(int n = 0; n < 2; n++)
+    {
+        std::string name = names[n];
+        dict_t* d = n == 0 ? dict_CreateEx(KEY_STRING, 0, DICT_OPEN) : dict_CreateInlineEx(KEY_STRING, 0, DICT_OPEN, sizeof(sample_t));
+        key_t key;
+        sample_t* ps;
+        double sum = 0;
+
+        long long before = bench_HeapBytes();
+        double t0 = bench_NowNs();
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            key.ks = keys[i].c_str();
+            sample_t s = { (long long)i, i * 0.25 };
+            if(n == 0)
+            {
+                CREATE_INST(pv, sample_t);
+                *pv = s;
+                dict_Set(d, key, pv);
+            }
+            else
+            {
+                dict_Set(d, key, &s);
+            }
+        }
+        double t1 = bench_NowNs();
+        long long after = bench_HeapBytes();
+
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            key.ks = keys[i].c_str();
+            dict_Get(d, key, (void**)&ps);
+            sum += ps->reading;
+        }
+        double t2 = bench_NowNs();
+
+        dict_Clear(d);
+        double t3 = bench_NowNs();
+        dict_Destroy(d);
+
+        UT_EQUAL(sum, 0.25 * (BIG_NUM_KEYS - 1) * BIG_NUM_KEYS / 2);
+        UT_PROPERTY(name + "_set_ns", (t1 - t0) / keys.size());
+        UT_PROPERTY(name + "_hit_ns", (t2 - t1) / keys.size());
+        UT_PROPERTY(name + "_clear_ms", (t3 - t2) / 1000000);
+        if(before >= 0)
+        {
+            UT_PROPERTY(name + "_bytes_per_entry", (double)(after - before) / keys.size());
+        }
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_GETMANY, "Random lookups in 1M keys (well past L2), dict_Get() one at a time vs dict_GetMany() 64 at a time.")
+{
+    const int BATCH = 64;
+    std::vector<std::string> keys = bench_MakeKeys("k%07d", BIG_NUM_KEYS);
+
+    // Random order so every lookup is a cache miss.
+    std::vector<key_t> order(keys.size());
+    srand(1234);
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        order[i].ks = keys[((size_t)rand() * RAND_MAX + rand()) % keys.size()].c_str();
+    }
+
+    for(int f = 0; f < NUM_FLAVORS; f++)
+    {
+        std::string name = FLAVORS[f].name;
+        dict_t* d = dict_CreateEx(KEY_STRING, 0, FLAVORS[f].opts);
+        key_t key;
+
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            CREATE_INST(pi, int);
+            key.ks = keys[i].c_str();
+            dict_Set(d, key, pi);
+        }
+
+        void* v;
+        int found = 0;
+        double t0 = bench_NowNs();
+        for(size_t i = 0; i < order.size(); i++)
+        {
+            found += dict_Get(d, order[i], &v) == RS_PASS ? 1 : 0;
+        }
+        double t1 = bench_NowNs();
+
+        void* values[BATCH];
+        int status[BATCH];
+        int found_many = 0;
+        double t2 = bench_NowNs();
+        for(size_t i = 0; i < order.size(); i += BATCH)
+        {
+            int n = order.size() - i < (size_t)BATCH ? (int)(order.size() - i) : BATCH;
+            dict_GetMany(d, &order[i], n, values, status);
+            for(int j = 0; j < n; j++)
+            {
+                found_many += status[j] == RS_PASS ? 1 : 0;
+            }
+        }
+        double t3 = bench_NowNs();
+
+        UT_EQUAL(found, BIG_NUM_KEYS);
+        UT_EQUAL(found_many, BIG_NUM_KEYS);
+        dict_Destroy(d);
+
+        UT_PROPERTY(name + "_get_ns", (t1 - t0) / order.size());
+        UT_PROPERTY(name + "_get_many_ns", (t3 - t2) / order.size());
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_FILTER, "1M keys, lookups where 90% miss, each flavor with and without DICT_FILTER.")
+{
+    std::vector<std::string> keys = bench_MakeKeys("id_%09d", BIG_NUM_KEYS);
+    std::vector<std::string> misses = bench_MakeKeys("blocked_%09d", BIG_NUM_KEYS);
+
+    // 1 in 10 is there, in random order.
+    std::vector<key_t> lookups(BIG_NUM_KEYS);
+    srand(4321);
+    for(size_t i = 0; i < lookups.size(); i++)
+    {
+        size_t r = ((size_t)rand() * RAND_MAX + rand()) % keys.size();
+        lookups[i].ks = i % 10 == 0 ? keys[r].c_str() : misses[r].c_str();
+    }
+
+    for(int f = 0; f < NUM_FLAVORS; f++)
+    {
+        for(int filtered = 0; filtered < 2; filtered++)
+        {
+            std::string name = std::string(FLAVORS[f].name) + (filtered ? "_filter" : "");
+            dict_t* d = dict_CreateInlineEx(KEY_STRING, 0, FLAVORS[f].opts | (filtered ? DICT_FILTER : 0), sizeof(int));
+            key_t key;
+
+            for(int i = 0; i < (int)keys.size(); i++)
+            {
+                key.ks = keys[i].c_str();
+                dict_Set(d, key, &i);
+            }
+
+            void* v;
+            int found = 0;
+            double t0 = bench_NowNs();
+            for(size_t i = 0; i < lookups.size(); i++)
+            {
+                found += dict_Get(d, lookups[i], &v) == RS_PASS ? 1 : 0;
+            }
+            double t1 = bench_NowNs();
+
+            dict_stats_t stats;
+            dict_GetStats(d, &stats);
+            dict_Destroy(d);
+
+            UT_EQUAL(found, BIG_NUM_KEYS / 10);
+            UT_PROPERTY(name + "_get_ns", (t1 - t0) / lookups.size());
+            if(filtered)
+            {
+                UT_PROPERTY(name + "_fp_rate", stats.filter_fp_rate);
+                UT_PROPERTY(name + "_bits_per_key", stats.filter_bytes * 8.0 / stats.count);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_MAPPED, "Startup with 2M entries: parse a CSV into an inline dict vs dict_OpenMapped() of a saved image.")
+{
+    const int NUM = 2 * BIG_NUM_KEYS;
+    std::vector<std::string> keys = bench_MakeKeys("sensor_%07d", NUM);
+
+    // The input, like dict_101.csv but bigger.
+    FILE* fp = fopen("bench_mapped.csv", "w");
+    for(int i = 0; i < NUM; i++)
+    {
+        fprintf(fp, "%s,%d,%g\n", keys[i].c_str(), i, i * 0.25);
+    }
+    fclose(fp);
+
+    // The old way.
+    double t0 = bench_NowNs();
+    dict_t* d = dict_CreateInline(KEY_STRING, sizeof(sample_t));
+    fp = fopen("bench_mapped.csv", "r");
+    char line[128];
+    key_t key;
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        char* id = strchr(line, ',');
+        *id++ = 0;
+        char* reading = strchr(id, ',');
+        *reading++ = 0;
+        sample_t s = { atoll(id), atof(reading) };
+        key.ks = line;
+        dict_Set(d, key, &s);
+    }
+    fclose(fp);
+    double t1 = bench_NowNs();
+
+    UT_EQUAL(dict_Save(d, "bench_mapped.img"), RS_PASS);
+    double t2 = bench_NowNs();
+    dict_Destroy(d);
+
+    // The new way.
+    double t3 = bench_NowNs();
+    d = dict_OpenMapped("bench_mapped.img");
+    double t4 = bench_NowNs();
+    UT_NOT_NULL(d);
+    UT_EQUAL(dict_Count(d), NUM);
+
+    // First lookups fault the pages in.
+    sample_t* ps;
+    double sum = 0;
+    for(int i = 0; i < NUM; i++)
+    {
+        key.ks = keys[i].c_str();
+        dict_Get(d, key, (void**)&ps);
+        sum += ps->reading;
+    }
+    double t5 = bench_NowNs();
+    dict_Destroy(d);
+
+    UT_EQUAL(sum, 0.25 * (NUM - 1) * NUM / 2);
+    UT_PROPERTY("parse_ms", (t1 - t0) / 1000000);
+    UT_PROPERTY("save_ms", (t2 - t1) / 1000000);
+    UT_PROPERTY("open_mapped_ms", (t4 - t3) / 1000000);
+    UT_PROPERTY("mapped_hit_ns", (t5 - t4) / NUM);
+
+    remove("bench_mapped.csv");
+    remove("bench_mapped.img");
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_MEMORY, "Heap bytes per entry, keys and table only (values are NULL), measured and from dict_GetStats().")
+{
+    // Name and the keys to measure with.
+    typedef struct { const char* name; std::vector<std::string> keys; } keyset_t;
+    keyset_t sets[] =
+    {
+        { "words", bench_ReadWords("hemingway_short.txt") },
+        { "short_1m", bench_MakeKeys("k%07d", BIG_NUM_KEYS) },
+        { "long_1m", bench_MakeKeys("plant/line3/sensor%07d/temp", BIG_NUM_KEYS) },
+    };
+
+    for(int s = 0; s < 3; s++)
+    {
+        for(int f = 0; f < NUM_FLAVORS; f++)
+        {
+            std::string name = std::string(sets[s].name) + "_" + FLAVORS[f].name;
+            const std::vector<std::string>& keys = sets[s].keys;
+
+            long long before = bench_HeapBytes();
+            dict_t* d = dict_CreateEx(KEY_STRING, 0, FLAVORS[f].opts);
+            key_t key;
+            void** slot;
+            bool inserted;
+
+            for(size_t i = 0; i < keys.size(); i++)
+            {
+                key.ks = keys[i].c_str();
+                dict_GetOrInsert(d, key, &slot, &inserted);
+            }
+            long long after = bench_HeapBytes();
+
+            // What the dict thinks it uses, and how well the keys spread.
+            dict_stats_t stats;
+            dict_GetStats(d, &stats);
+            UT_EQUAL(stats.count, (int)keys.size());
+            UT_PROPERTY(name + "_stats_bytes_per_entry", (double)stats.bytes / keys.size());
+            UT_PROPERTY(name + "_mean_probe", stats.mean_probe);
+            UT_PROPERTY(name + "_max_probe", (double)stats.max_probe);
+            dict_Destroy(d);
+
+            // Only where we can ask the allocator.
+            if(before >= 0)
+            {
+                UT_PROPERTY(name + "_bytes_per_entry", (double)(after - before) / keys.size());
+            }
+        }
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_KEYS, "1M device ids and UUIDs, hex encoded into KEY_STRING vs KEY_U64 and KEY_BYTES, DICT_OPEN.")
+{
+    std::vector<unsigned long long> ids(BIG_NUM_KEYS);
+    std::vector<unsigned char> uuids((size_t)BIG_NUM_KEYS * 16);
+    srand(5);
+    for(int i = 0; i < BIG_NUM_KEYS; i++)
+    {
+        ids[i] = ((unsigned long long)rand() << 33) ^ ((unsigned long long)rand() << 11) ^ (unsigned long long)i;
+        for(int b = 0; b < 16; b++)
+        {
+            uuids[(size_t)i * 16 + b] = (unsigned char)(b < 4 ? i >> (b * 8) : rand());
+        }
+    }
+
+    dict_t* hex_ids = dict_CreateInlineEx(KEY_STRING, BIG_NUM_KEYS, DICT_OPEN, sizeof(int));
+    dict_t* hex_uuids = dict_CreateInlineEx(KEY_STRING, BIG_NUM_KEYS, DICT_OPEN, sizeof(int));
+    dict_t* u64_ids = dict_CreateInlineEx(KEY_U64, BIG_NUM_KEYS, DICT_OPEN, sizeof(int));
+    dict_t* bytes_uuids = dict_CreateInlineEx(KEY_BYTES, BIG_NUM_KEYS, DICT_OPEN, sizeof(int));
+    key_t key;
+    char hex[33];
+    void* v;
+
+    for(int i = 0; i < BIG_NUM_KEYS; i++)
+    {
+        snprintf(hex, sizeof(hex), "%016llx", ids[i]);
+        key.ks = hex;
+        dict_Set(hex_ids, key, &i);
+        key.ku = ids[i];
+        dict_Set(u64_ids, key, &i);
+
+        for(int b = 0; b < 16; b++)
+        {
+            snprintf(hex + b * 2, 3, "%02x", uuids[(size_t)i * 16 + b]);
+        }
+        key.ks = hex;
+        dict_Set(hex_uuids, key, &i);
+        kbytes_t kb = { &uuids[(size_t)i * 16], 16 };
+        key.kb = &kb;
+        dict_Set(bytes_uuids, key, &i);
+    }
+
+    // Lookups include making the key, as the client would.
+    int found = 0;
+    double t0 = bench_NowNs();
+    for(int i = 0; i < BIG_NUM_KEYS; i++)
+    {
+        snprintf(hex, sizeof(hex), "%016llx", ids[i]);
+        key.ks = hex;
+        found += dict_Get(hex_ids, key, &v) == RS_PASS ? 1 : 0;
+    }
+    double t1 = bench_NowNs();
+    for(int i = 0; i < BIG_NUM_KEYS; i++)
+    {
+        key.ku = ids[i];
+        found += dict_Get(u64_ids, key, &v) == RS_PASS ? 1 : 0;
+    }
+    double t2 = bench_NowNs();
+    for(int i = 0; i < BIG_NUM_KEYS; i++)
+    {
+        for(int b = 0; b < 16; b++)
+        {
+            snprintf(hex + b * 2, 3, "%02x", uuids[(size_t)i * 16 + b]);
+        }
+        key.ks = hex;
+        found += dict_Get(hex_uuids, key, &v) == RS_PASS ? 1 : 0;
+    }
+    double t3 = bench_NowNs();
+    for(int i = 0; i < BIG_NUM_KEYS; i++)
+    {
+        kbytes_t kb = { &uuids[(size_t)i * 16], 16 };
+        key.kb = &kb;
+        found += dict_Get(bytes_uuids, key, &v) == RS_PASS ? 1 : 0;
+    }
+    double t4 = bench_NowNs();
+    UT_EQUAL(found, 4 * BIG_NUM_KEYS);
+
+    dict_stats_t stats[4];
+    dict_GetStats(hex_ids, &stats[0]);
+    dict_GetStats(u64_ids, &stats[1]);
+    dict_GetStats(hex_uuids, &stats[2]);
+    dict_GetStats(bytes_uuids, &stats[3]);
+
+    UT_PROPERTY("hex_id_hit_ns", (t1 - t0) / BIG_NUM_KEYS);
+    UT_PROPERTY("u64_id_hit_ns", (t2 - t1) / BIG_NUM_KEYS);
+    UT_PROPERTY("hex_uuid_hit_ns", (t3 - t2) / BIG_NUM_KEYS);
+    UT_PROPERTY("bytes_uuid_hit_ns", (t4 - t3) / BIG_NUM_KEYS);
+    UT_PROPERTY("hex_id_bytes_per_entry", (double)stats[0].bytes / BIG_NUM_KEYS);
+    UT_PROPERTY("u64_id_bytes_per_entry", (double)stats[1].bytes / BIG_NUM_KEYS);
+    UT_PROPERTY("hex_uuid_bytes_per_entry", (double)stats[2].bytes / BIG_NUM_KEYS);
+    UT_PROPERTY("bytes_uuid_bytes_per_entry", (double)stats[3].bytes / BIG_NUM_KEYS);
+
+    dict_Destroy(hex_ids);
+    dict_Destroy(u64_ids);
+    dict_Destroy(hex_uuids);
+    dict_Destroy(bytes_uuids);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+bench_result_t bench_Run(unsigned int opts, const std::vector<std::string>& keys, const std::vector<std::string>& misses, int rounds)
+{
+    bench_result_t res;
+    key_t key;
+    void* v;
+
+    // Let it grow like a client would.
+    dict_t* d = dict_CreateEx(KEY_STRING, 0, opts);
+
+    double start = bench_NowNs();
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        CREATE_INST(pi, int);
+        *pi = (int)i;
+        key.ks = keys[i].c_str();
+        dict_Set(d, key, pi);
+    }
+    res.set_ns = (bench_NowNs() - start) / keys.size();
+
+    res.found = 0;
+    start = bench_NowNs();
+    for(int r = 0; r < rounds; r++)
+    {
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            key.ks = keys[i].c_str();
+            res.found += dict_Get(d, key, &v) == RS_PASS ? 1 : 0;
+        }
+    }
+    res.hit_ns = (bench_NowNs() - start) / (keys.size() * rounds);
+    res.found /= rounds;
+
+    start = bench_NowNs();
+    for(int r = 0; r < rounds; r++)
+    {
+        for(size_t i = 0; i < misses.size(); i++)
+        {
+            key.ks = misses[i].c_str();
+            res.found -= dict_Get(d, key, &v) == RS_PASS ? 1 : 0;
+        }
+    }
+    res.miss_ns = (bench_NowNs() - start) / (misses.size() * rounds);
+
+    dict_Destroy(d);
+
+    return res;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Unique non-empty lines, in file order.
+std::vector<std::string> bench_ReadWords(const char* fn)
+{
+    std::vector<std::string> words;
+    std::set<std::string> seen;
+    char buff[64]; // I just know this.
+
+    FILE* fp = fopen(fn, "r");
+    if(fp != NULL)
+    {
+        while(fgets(buff, sizeof(buff), fp) != NULL)
+        {
+            buff[strcspn(buff, "\r\n")] = 0;
+            if(strlen(buff) > 0 && seen.insert(buff).second)
+            {
+                words.emplace_back(buff);
+            }
+        }
+        fclose(fp);
+    }
+
+    return words;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// All words in file order, upper cased. A word is a run of letters, digits and apostrophes.
+std::vector<std::string> bench_SplitWords(const char* fn)
+{
+    std::vector<std::string> words;
+    std::string word;
+
+    FILE* fp = fopen(fn, "r");
+    if(fp != NULL)
+    {
+        int c;
+        while((c = getc(fp)) != EOF)
+        {
+            if(isalnum(c) || c == '\'')
+            {
+                word += (char)toupper(c);
+            }
+            else if(word.size() > 0)
+            {
+                words.push_back(word);
+                word.clear();
+            }
+        }
+
+        if(word.size() > 0)
+        {
+            words.push_back(word);
+        }
+        fclose(fp);
+    }
+
+    return words;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+std::vector<std::string> bench_MakeKeys(const char* fmt, int num)
+{
+    std::vector<std::string> keys;
+    char buff[64];
+
+    keys.reserve(num);
+    for(int i = 0; i < num; i++)
+    {
+        snprintf(buff, sizeof(buff), fmt, i);
+        keys.emplace_back(buff);
+    }
+
+    return keys;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+double bench_NowNs(void)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+long long bench_HeapBytes(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    // Big blocks are mmapped and counted separately.
+    struct mallinfo2 mi = mallinfo2();
+    return (long long)(mi.uordblks + mi.hblkhd);
+#else
+    return -1;
+#endif
+}
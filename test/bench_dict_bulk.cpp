@@ -0,0 +1,110 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+}
+
+// What a CSV line holds.
+typedef struct { long long id; double reading; } sample_t;
+
+// Helpers.
+double bench_NowNs(void);
+int bench_ParseSample(char* line, key_t* k, void* v, void* ctx);
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_DICT_LOAD, "Build an inline dict from a 10M line CSV: fgets() + dict_Set() vs dict_LoadFile() with 1 and 4 threads.")
+{
+    const int NUM = 10000000;
+    char line[128];
+    key_t key;
+
+    // Like dict_101.csv, a header then name,number,number. Every tenth name comes again later.
+    double t0 = bench_NowNs();
+    FILE* fp = fopen("bench_load.csv", "w");
+    fprintf(fp, "name,id,reading\n");
+    for(int i = 0; i < NUM; i++)
+    {
+        fprintf(fp, "sensor_%08d,%d,%g\n", i % 10 == 9 ? i - 9 : i, i, i * 0.25);
+    }
+    fclose(fp);
+    double t1 = bench_NowNs();
+    UT_PROPERTY("write_ms", (t1 - t0) / 1000000);
+    UT_PROPERTY("cores", (double)std::thread::hardware_concurrency());
+
+    // The old way, one line at a time.
+    dict_t* d = dict_CreateInlineEx(KEY_STRING, 0, DICT_GROUP, sizeof(sample_t));
+    double t2 = bench_NowNs();
+    fp = fopen("bench_load.csv", "r");
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        sample_t s;
+        line[strcspn(line, "\n")] = 0;
+        if(bench_ParseSample(line, &key, &s, NULL) == RS_PASS)
+        {
+            dict_Set(d, key, &s);
+        }
+    }
+    fclose(fp);
+    double t3 = bench_NowNs();
+    int count = dict_Count(d);
+    dict_Destroy(d);
+    UT_EQUAL(count, NUM - NUM / 10);
+    UT_PROPERTY("set_ms", (t3 - t2) / 1000000);
+
+    // Same dict, the whole file at once.
+    int threads[] = { 1, 4 };
+    for(int t = 0; t < 2; t++)
+    {
+        d = dict_CreateInlineEx(KEY_STRING, 0, DICT_GROUP, sizeof(sample_t));
+        double t4 = bench_NowNs();
+        UT_EQUAL(dict_LoadFile(d, "bench_load.csv", bench_ParseSample, NULL, threads[t]), RS_PASS);
+        double t5 = bench_NowNs();
+        UT_EQUAL(dict_Count(d), NUM - NUM / 10);
+
+        // Spot check the repeats.
+        sample_t* ps = NULL;
+        key.ks = "sensor_00000000";
+        dict_Get(d, key, (void**)&ps);
+        UT_EQUAL(ps->id, 9);
+        dict_Destroy(d);
+
+        UT_PROPERTY("load_" + std::to_string(threads[t]) + "_ms", (t5 - t4) / 1000000);
+    }
+
+    remove("bench_load.csv");
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+int bench_ParseSample(char* line, key_t* k, void* v, void* ctx)
+{
+    (void)ctx;
+    char* id = strchr(line, ',');
+    char* reading = id != NULL ? strchr(id + 1, ',') : NULL;
+
+    // The header has no numbers.
+    if(reading == NULL || !isdigit((unsigned char)id[1]))
+    {
+        return RS_FAIL;
+    }
+
+    *id++ = 0;
+    *reading++ = 0;
+    sample_t* s = (sample_t*)v;
+    s->id = atoll(id);
+    s->reading = atof(reading);
+    k->ks = line;
+
+    return RS_PASS;
+}
@@ -0,0 +1,26 @@
+#include <cstdio>
+#include "pnut.h"
+
+extern "C"
+{
+#include "logger.h"
+}
+
+int main()
+{
+    TestManager& tm = TestManager::Instance();
+
+    // Run the requested benchmarks. Could be obtained from the command line.
+    std::vector<std::string> whichSuites;
+
+    whichSuites.emplace_back("BENCH");
+
+    // Init system before running.
+    common_Init();
+    FILE* fp = fopen("log_bench.txt", "w");
+    logger_Init(fp);
+
+    tm.RunSuites(whichSuites, 'r'); // 'r' for readable, 'x' for xml
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+#include "omap.h"
+}
+
+// From bench_dict.cpp.
+double bench_NowNs(void);
+
+// Samples, one every few ms.
+static const int OBENCH_NUM = 1000000;
+
+// Time range queries of each kind.
+static const int OBENCH_SCANS = 5;
+static const int OBENCH_RANGES = 1000;
+
+// Samples per range.
+static const int OBENCH_SPAN = 1000;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_OMAP, "1M time stamped samples, dict scan vs omap range for all samples between t0 and t1.")
+{
+    // Time stamps in random order, 4 ms apart.
+    std::vector<int> stamps(OBENCH_NUM);
+    for(int i = 0; i < OBENCH_NUM; i++)
+    {
+        stamps[i] = i * 4;
+    }
+    srand(7);
+    for(int i = OBENCH_NUM - 1; i > 0; i--)
+    {
+        int j = rand() % (i + 1);
+        int tmp = stamps[i];
+        stamps[i] = stamps[j];
+        stamps[j] = tmp;
+    }
+
+    key_t key;
+    void* v;
+    dict_t* d = dict_Create(KEY_INT);
+    omap_t* m = omap_Create(KEY_INT);
+
+    double t0 = bench_NowNs();
+    for(int i = 0; i < OBENCH_NUM; i++)
+    {
+        CREATE_INST(pi, int);
+        *pi = i;
+        key.ki = stamps[i];
+        dict_Set(d, key, pi);
+    }
+    double t1 = bench_NowNs();
+    for(int i = 0; i < OBENCH_NUM; i++)
+    {
+        CREATE_INST(pi, int);
+        *pi = i;
+        key.ki = stamps[i];
+        omap_Set(m, key, pi);
+    }
+    double t2 = bench_NowNs();
+
+    int found = 0;
+    for(int i = 0; i < OBENCH_NUM; i++)
+    {
+        key.ki = stamps[i];
+        found += dict_Get(d, key, &v) == RS_PASS ? 1 : 0;
+    }
+    double t3 = bench_NowNs();
+    for(int i = 0; i < OBENCH_NUM; i++)
+    {
+        key.ki = stamps[i];
+        found += omap_Get(m, key, &v) == RS_PASS ? 1 : 0;
+    }
+    double t4 = bench_NowNs();
+    UT_EQUAL(found, 2 * OBENCH_NUM);
+
+    // [t0, t1) from a dict has to look at everything.
+    int in_range = 0;
+    for(int q = 0; q < OBENCH_SCANS; q++)
+    {
+        int lo = (q * 7919 % (OBENCH_NUM - OBENCH_SPAN)) * 4;
+        int hi = lo + OBENCH_SPAN * 4;
+        dict_IterStart(d);
+        while(dict_IterNext(d, &key, &v) == RS_PASS)
+        {
+            in_range += key.ki >= lo && key.ki < hi ? 1 : 0;
+        }
+    }
+    double t5 = bench_NowNs();
+    for(int q = 0; q < OBENCH_RANGES; q++)
+    {
+        key_t lo = { (q * 7919 % (OBENCH_NUM - OBENCH_SPAN)) * 4 };
+        key_t hi = { lo.ki + OBENCH_SPAN * 4 };
+        omap_IterStart(m, &lo, &hi);
+        while(omap_IterNext(m, &key, &v) == RS_PASS)
+        {
+            in_range++;
+        }
+    }
+    double t6 = bench_NowNs();
+    UT_EQUAL(in_range, (OBENCH_SCANS + OBENCH_RANGES) * OBENCH_SPAN);
+
+    UT_PROPERTY("dict_set_ns", (t1 - t0) / OBENCH_NUM);
+    UT_PROPERTY("omap_set_ns", (t2 - t1) / OBENCH_NUM);
+    UT_PROPERTY("dict_hit_ns", (t3 - t2) / OBENCH_NUM);
+    UT_PROPERTY("omap_hit_ns", (t4 - t3) / OBENCH_NUM);
+    UT_PROPERTY("dict_range_ms", (t5 - t4) / OBENCH_SCANS / 1000000);
+    UT_PROPERTY("omap_range_us", (t6 - t5) / OBENCH_RANGES / 1000);
+
+    omap_Destroy(m);
+    dict_Destroy(d);
+
+    return 0;
+}
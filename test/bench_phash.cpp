@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+#include "phash.h"
+}
+
+// From bench_dict.cpp.
+std::vector<std::string> bench_SplitWords(const char* fn);
+double bench_NowNs(void);
+
+// Passes over the text.
+static const int PBENCH_ROUNDS = 20;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_PHASH, "Look up every word of hemingway.txt in a table of its distinct words, dict_Get() vs phash_Get().")
+{
+    std::vector<std::string> text = bench_SplitWords("hemingway.txt");
+    std::set<std::string> uniq(text.begin(), text.end());
+    std::vector<std::string> words(uniq.begin(), uniq.end());
+    std::vector<key_t> keys(words.size());
+    std::vector<key_t> lookups(text.size());
+
+    for(size_t i = 0; i < words.size(); i++)
+    {
+        keys[i].ks = words[i].c_str();
+    }
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        lookups[i].ks = text[i].c_str();
+    }
+
+    double t0 = bench_NowNs();
+    phash_t* ph = phash_Build(KEY_STRING, keys.data(), NULL, (int)keys.size());
+    double t1 = bench_NowNs();
+    UT_NOT_NULL(ph);
+
+    dict_t* d = dict_CreateInlineEx(KEY_STRING, (int)keys.size(), DICT_OPEN, sizeof(int));
+    for(int i = 0; i < (int)keys.size(); i++)
+    {
+        dict_Set(d, keys[i], &i);
+    }
+
+    void* v;
+    int found = 0;
+    double t2 = bench_NowNs();
+    for(int r = 0; r < PBENCH_ROUNDS; r++)
+    {
+        for(size_t i = 0; i < lookups.size(); i++)
+        {
+            found += dict_Get(d, lookups[i], &v) == RS_PASS ? 1 : 0;
+        }
+    }
+    double t3 = bench_NowNs();
+    for(int r = 0; r < PBENCH_ROUNDS; r++)
+    {
+        for(size_t i = 0; i < lookups.size(); i++)
+        {
+            found += phash_Get(ph, lookups[i], &v) == RS_PASS ? 1 : 0;
+        }
+    }
+    double t4 = bench_NowNs();
+
+    UT_EQUAL(found, 2 * PBENCH_ROUNDS * (int)lookups.size());
+    UT_PROPERTY("num_keys", (double)keys.size());
+    UT_PROPERTY("phash_build_ms", (t1 - t0) / 1000000);
+    UT_PROPERTY("dict_open_hit_ns", (t3 - t2) / PBENCH_ROUNDS / lookups.size());
+    UT_PROPERTY("phash_hit_ns", (t4 - t3) / PBENCH_ROUNDS / lookups.size());
+
+    dict_Destroy(d);
+    phash_Destroy(ph);
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "list.h"
+#include "dict.h"
+#include "radix.h"
+}
+
+// From bench_dict.cpp.
+double bench_NowNs(void);
+long long bench_HeapBytes(void);
+
+// Tree shape: lines x sensors x readings.
+static const int RBENCH_LINES = 100;
+static const int RBENCH_SENSORS = 2500;
+static const int RBENCH_READINGS = 4;
+
+// Prefix queries of each kind.
+static const int RBENCH_SCANS = 5;
+static const int RBENCH_WALKS = 1000;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(BENCH_RADIX, "Prefix queries over 1M hierarchical keys, dict_GetKeys() + strncmp() vs radix_IterStart().")
+{
+    const char* readings[] = { "temp", "rpm", "volts", "amps" };
+    std::vector<std::string> keys;
+    char buff[64];
+
+    for(int l = 0; l < RBENCH_LINES; l++)
+    {
+        for(int s = 0; s < RBENCH_SENSORS; s++)
+        {
+            for(int r = 0; r < RBENCH_READINGS; r++)
+            {
+                snprintf(buff, sizeof(buff), "plant/line%02d/sensor%04d/%s", l, s, readings[r]);
+                keys.push_back(buff);
+            }
+        }
+    }
+
+    // Same keys and values in both.
+    long long heap0 = bench_HeapBytes();
+    dict_t* d = dict_Create(KEY_STRING);
+    key_t key;
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        CREATE_INST(pi, int);
+        *pi = (int)i;
+        key.ks = keys[i].c_str();
+        dict_Set(d, key, pi);
+    }
+    long long heap1 = bench_HeapBytes();
+
+    double t0 = bench_NowNs();
+    radix_t* t = radix_Create();
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        CREATE_INST(pi, int);
+        *pi = (int)i;
+        radix_Set(t, keys[i].c_str(), pi);
+    }
+    double t1 = bench_NowNs();
+    long long heap2 = bench_HeapBytes();
+    UT_EQUAL(radix_Count(t), (int)keys.size());
+
+    // Everything under one sensor group, 10 sensors x 4 readings.
+    int scan_found = 0;
+    double t2 = bench_NowNs();
+    for(int q = 0; q < RBENCH_SCANS; q++)
+    {
+        snprintf(buff, sizeof(buff), "plant/line%02d/sensor%03d", q * 7 % RBENCH_LINES, q * 13 % (RBENCH_SENSORS / 10));
+        size_t plen = strlen(buff);
+        list_t* all = dict_GetKeys(d);
+        char* ks;
+        list_IterStart(all);
+        while(list_IterNext(all, (void**)&ks) == RS_PASS)
+        {
+            scan_found += strncmp(ks, buff, plen) == 0 ? 1 : 0;
+        }
+        list_Destroy(all);
+    }
+    double t3 = bench_NowNs();
+
+    int walk_found = 0;
+    for(int q = 0; q < RBENCH_WALKS; q++)
+    {
+        snprintf(buff, sizeof(buff), "plant/line%02d/sensor%03d", q * 7 % RBENCH_LINES, q * 13 % (RBENCH_SENSORS / 10));
+        const char* ks;
+        void* v;
+        if(radix_IterStart(t, buff) == RS_PASS)
+        {
+            while(radix_IterNext(t, &ks, &v) == RS_PASS)
+            {
+                walk_found++;
+            }
+        }
+    }
+    double t4 = bench_NowNs();
+
+    int per_query = 10 * RBENCH_READINGS;
+    UT_EQUAL(scan_found, RBENCH_SCANS * per_query);
+    UT_EQUAL(walk_found, RBENCH_WALKS * per_query);
+    UT_PROPERTY("num_keys", (double)keys.size());
+    UT_PROPERTY("radix_set_ns", (t1 - t0) / keys.size());
+    UT_PROPERTY("scan_query_ms", (t3 - t2) / RBENCH_SCANS / 1000000);
+    UT_PROPERTY("radix_query_us", (t4 - t3) / RBENCH_WALKS / 1000);
+    UT_PROPERTY("dict_bytes_per_key", (double)(heap1 - heap0) / keys.size());
+    UT_PROPERTY("radix_bytes_per_key", (double)(heap2 - heap1) / keys.size());
+
+    radix_Destroy(t);
+    dict_Destroy(d);
+
+    return 0;
+}
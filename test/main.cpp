@@ -20,6 +20,11 @@ int main()
     whichSuites.emplace_back("DICT");
     whichSuites.emplace_back("STR");
     whichSuites.emplace_back("LIST");
+    whichSuites.emplace_back("SNAP");
+    whichSuites.emplace_back("PHASH");
+    whichSuites.emplace_back("RADIX");
+    whichSuites.emplace_back("OMAP");
+    whichSuites.emplace_back("CACHE");
 
     // Init system before running tests.
     common_Init();
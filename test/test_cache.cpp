@@ -0,0 +1,209 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "cache.h"
+}
+
+// Helpers.
+static int* cache_Value(int i);
+static void cache_Evicted(key_t k, void* v, void* ctx);
+static void cache_EvictedU64(key_t k, void* v, void* ctx);
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(CACHE_LRU, "Test the LRU cache.")
+{
+    cache_t* c = cache_Create(KEY_INT, 3, 0, CACHE_LRU);
+    UT_NOT_NULL(c);
+    std::map<int, int> gone;
+    UT_EQUAL(cache_SetEvict(c, cache_Evicted, &gone), RS_PASS);
+    key_t k;
+    void* v;
+
+    for(int i = 1; i <= 3; i++)
+    {
+        k.ki = i;
+        UT_EQUAL(cache_Put(c, k, cache_Value(i * 10), 1), RS_PASS);
+    }
+    UT_EQUAL(cache_Count(c), 3);
+
+    // Use 1 so 2 is the oldest.
+    k.ki = 1;
+    UT_EQUAL(cache_Get(c, k, &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 10);
+    k.ki = 4;
+    UT_EQUAL(cache_Put(c, k, cache_Value(40), 1), RS_PASS);
+    UT_EQUAL(cache_Count(c), 3);
+    UT_EQUAL((int)gone.size(), 1);
+    UT_EQUAL(gone[2], 20);
+    k.ki = 2;
+    UT_EQUAL(cache_Get(c, k, &v), RS_FAIL);
+
+    // Replace goes to the callback too, but is not an eviction.
+    k.ki = 3;
+    UT_EQUAL(cache_Put(c, k, cache_Value(31), 1), RS_PASS);
+    UT_EQUAL(gone[3], 30);
+    UT_EQUAL(cache_Get(c, k, &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 31);
+
+    // Now 1 is the oldest.
+    k.ki = 5;
+    UT_EQUAL(cache_Put(c, k, cache_Value(50), 1), RS_PASS);
+    k.ki = 1;
+    UT_EQUAL(cache_Get(c, k, &v), RS_FAIL);
+    UT_EQUAL(gone[1], 10);
+
+    // Remove hands it back.
+    k.ki = 4;
+    UT_EQUAL(cache_Remove(c, k, &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 40);
+    FREE(v);
+    UT_EQUAL(cache_Remove(c, k, &v), RS_FAIL);
+    UT_EQUAL(cache_Count(c), 2);
+
+    cache_stats_t stats;
+    UT_EQUAL(cache_GetStats(c, &stats), RS_PASS);
+    UT_EQUAL(stats.count, 2);
+    UT_EQUAL(stats.bytes, 2);
+    UT_EQUAL(stats.hits, 2);
+    UT_EQUAL(stats.misses, 2);
+    UT_EQUAL(stats.evictions, 2);
+
+    // Everything left goes to the callback.
+    UT_EQUAL(cache_Destroy(c), RS_PASS);
+    UT_EQUAL(gone[3], 31);
+    UT_EQUAL(gone[5], 50);
+
+    // Limited by bytes, string keys, values freed by the cache.
+    c = cache_Create(KEY_STRING, 100, 1000, CACHE_LRU);
+    char buff[32];
+    for(int i = 0; i < 20; i++)
+    {
+        snprintf(buff, sizeof(buff), "page%d", i);
+        k.ks = buff;
+        UT_EQUAL(cache_Put(c, k, cache_Value(i), 300), RS_PASS);
+    }
+    UT_EQUAL(cache_Count(c), 3);
+    k.ks = "page17";
+    UT_EQUAL(cache_Get(c, k, &v), RS_PASS);
+    k.ks = "page16";
+    UT_EQUAL(cache_Get(c, k, &v), RS_FAIL);
+
+    // Too big to ever fit.
+    k.ks = "huge";
+    int* big = cache_Value(0);
+    UT_EQUAL(cache_Put(c, k, big, 1001), RS_FAIL);
+    FREE(big);
+    UT_EQUAL(cache_Put(c, k, cache_Value(0), 1000), RS_PASS);
+    UT_EQUAL(cache_Count(c), 1);
+
+    UT_EQUAL(cache_Clear(c), RS_PASS);
+    UT_EQUAL(cache_Count(c), 0);
+    UT_EQUAL(cache_Get(c, k, &v), RS_FAIL);
+    UT_EQUAL(cache_Destroy(c), RS_PASS);
+
+    UT_NULL(cache_Create(KEY_INT, 0, 0, CACHE_LRU));
+    UT_EQUAL(cache_Count(NULL), RS_ERR);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(CACHE_CLOCK, "Test the CLOCK cache.")
+{
+    cache_t* c = cache_Create(KEY_U64, 4, 0, CACHE_CLOCK);
+    std::map<int, int> gone;
+    cache_SetEvict(c, cache_EvictedU64, &gone);
+    key_t k;
+    void* v;
+
+    for(int i = 0; i < 4; i++)
+    {
+        k.ku = i;
+        cache_Put(c, k, cache_Value(i), 1);
+    }
+
+    // Used ones get a second chance.
+    k.ku = 0;
+    UT_EQUAL(cache_Get(c, k, &v), RS_PASS);
+    k.ku = 1;
+    UT_EQUAL(cache_Get(c, k, &v), RS_PASS);
+    k.ku = 4;
+    cache_Put(c, k, cache_Value(4), 1);
+    UT_EQUAL((int)gone.size(), 1);
+    UT_EQUAL(gone.count(2), 1);
+
+    // Churn. Whatever is not in the cache was handed to the callback, and each key once.
+    gone.clear();
+    std::map<int, int> in = { { 0, 0 }, { 1, 1 }, { 3, 3 }, { 4, 4 } };
+    int bad = 0;
+    srand(11);
+    for(int i = 0; i < 20000; i++)
+    {
+        int key = rand() % 16;
+        k.ku = key;
+
+        if(rand() % 2 == 0)
+        {
+            bool there = cache_Get(c, k, &v) == RS_PASS;
+            bad += there == (in.count(key) > 0) ? 0 : 1;
+            bad += !there || *(int*)v == in[key] ? 0 : 1;
+        }
+        else
+        {
+            gone.clear();
+            cache_Put(c, k, cache_Value(i), 1);
+            for(auto it = gone.begin(); it != gone.end(); ++it)
+            {
+                bad += in.count(it->first) > 0 && in[it->first] == it->second ? 0 : 1;
+                in.erase(it->first);
+            }
+            in[key] = i;
+            bad += (int)in.size() == cache_Count(c) ? 0 : 1;
+        }
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(cache_Count(c), 4);
+
+    cache_stats_t stats;
+    cache_GetStats(c, &stats);
+    UT_GREATER(stats.hits, 1000);
+    UT_GREATER(stats.misses, 1000);
+
+    cache_SetEvict(c, NULL, NULL);
+    UT_EQUAL(cache_Destroy(c), RS_PASS);
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int* cache_Value(int i)
+{
+    CREATE_INST(pi, int);
+    *pi = i;
+    return pi;
+}
+
+//---------------------------------------------------------------------------
+void cache_Evicted(key_t k, void* v, void* ctx)
+{
+    std::map<int, int>* gone = (std::map<int, int>*)ctx;
+    (*gone)[k.ki] = *(int*)v;
+    FREE(v);
+}
+
+//---------------------------------------------------------------------------
+void cache_EvictedU64(key_t k, void* v, void* ctx)
+{
+    std::map<int, int>* gone = (std::map<int, int>*)ctx;
+    (*gone)[(int)k.ku] = *(int*)v;
+    FREE(v);
+}
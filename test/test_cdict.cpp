@@ -0,0 +1,191 @@
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "cdict.h"
+}
+
+// Value for testing. b is always derived from a so a torn read shows.
+typedef struct
+{
+    long long a;
+    long long b;
+    char tag[8];
+} cval_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(CDICT_BASIC, "Test concurrent dict functions from one thread.")
+{
+    UT_NULL(cdict_Create(KEY_INT, 0, 0));
+
+    cdict_t* cd = cdict_Create(KEY_STRING, sizeof(cval_t), 4);
+    UT_NOT_NULL(cd);
+    UT_EQUAL(cdict_Count(cd), 0);
+
+    key_t key;
+    cval_t val;
+    char sk[64];
+    int bad = 0;
+
+    // Enough to grow every stripe a few times. Short and long keys.
+    for(int i = 0; i < 5000; i++)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i);
+        key.ks = sk;
+        val.a = i;
+        val.b = ~val.a;
+        bad += cdict_Set(cd, key, &val) == RS_PASS ? 0 : 1;
+    }
+    UT_EQUAL(cdict_Count(cd), 5000);
+
+    for(int i = 0; i < 5000; i++)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i);
+        key.ks = sk;
+        bad += (cdict_Get(cd, key, &val) == RS_PASS && val.a == i && val.b == ~val.a) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    // Replace.
+    key.ks = "k7";
+    val.a = 777;
+    UT_EQUAL(cdict_Set(cd, key, &val), RS_PASS);
+    UT_EQUAL(cdict_Get(cd, key, &val), RS_PASS);
+    UT_EQUAL(val.a, 777);
+    UT_EQUAL(cdict_Count(cd), 5000);
+
+    // Remove.
+    UT_EQUAL(cdict_Remove(cd, key), RS_PASS);
+    UT_EQUAL(cdict_Remove(cd, key), RS_FAIL);
+    UT_EQUAL(cdict_Get(cd, key, &val), RS_FAIL);
+    key.ks = "not_there";
+    UT_EQUAL(cdict_Get(cd, key, &val), RS_FAIL);
+    UT_EQUAL(cdict_Count(cd), 4999);
+
+    for(int i = 0; i < 5000; i += 3)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i);
+        key.ks = sk;
+        cdict_Remove(cd, key);
+    }
+
+    for(int i = 0; i < 5000; i++)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i);
+        key.ks = sk;
+        int res = cdict_Get(cd, key, &val);
+        bad += (i % 3 == 0 || i == 7 ? res == RS_FAIL : res == RS_PASS && val.a == i) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    UT_EQUAL(cdict_Destroy(cd), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(CDICT_THREADS, "Test readers and writers at the same time.")
+{
+    const int NUM_KEYS = 20000;
+    const int NUM_WRITERS = 2;
+    const int NUM_READERS = 3;
+
+    // Few stripes so there is plenty of contention.
+    cdict_t* cd = cdict_Create(KEY_INT, sizeof(cval_t), 2);
+    std::atomic<int> torn(0);
+    std::atomic<int> lost(0);
+    std::atomic<bool> stop(false);
+
+    // Even keys are always there after this. Odd ones come and go.
+    key_t key;
+    cval_t val;
+    for(int i = 0; i < NUM_KEYS; i += 2)
+    {
+        key.ki = i;
+        val.a = i;
+        val.b = ~val.a;
+        cdict_Set(cd, key, &val);
+    }
+
+    std::vector<std::thread> threads;
+
+    for(int w = 0; w < NUM_WRITERS; w++)
+    {
+        threads.emplace_back([cd, w]()
+        {
+            key_t k;
+            cval_t v;
+            for(int round = 0; round < 5; round++)
+            {
+                // Each writer has its own odd keys and rewrites the evens.
+                for(int i = w * 2 + 1; i < NUM_KEYS; i += NUM_WRITERS * 2)
+                {
+                    k.ki = i;
+                    v.a = i + round * NUM_KEYS;
+                    v.b = ~v.a;
+                    cdict_Set(cd, k, &v);
+                    k.ki = i - 1;
+                    v.a = i - 1 + round * NUM_KEYS;
+                    v.b = ~v.a;
+                    cdict_Set(cd, k, &v);
+                }
+                for(int i = w * 2 + 1; i < NUM_KEYS; i += NUM_WRITERS * 2)
+                {
+                    k.ki = i;
+                    cdict_Remove(cd, k);
+                }
+            }
+        });
+    }
+
+    for(int r = 0; r < NUM_READERS; r++)
+    {
+        threads.emplace_back([cd, &torn, &lost, &stop]()
+        {
+            key_t k;
+            cval_t v;
+            do
+            {
+                for(int i = 0; i < NUM_KEYS; i++)
+                {
+                    k.ki = i;
+                    int res = cdict_Get(cd, k, &v);
+                    if(res == RS_PASS && (v.b != ~v.a || v.a % NUM_KEYS != i))
+                    {
+                        torn++;
+                    }
+                    if(i % 2 == 0 && res != RS_PASS)
+                    {
+                        lost++;
+                    }
+                }
+            } while(!stop);
+        });
+    }
+
+    for(int w = 0; w < NUM_WRITERS; w++)
+    {
+        threads[w].join();
+    }
+    stop = true;
+    for(size_t t = NUM_WRITERS; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+
+    UT_EQUAL(torn.load(), 0);
+    UT_EQUAL(lost.load(), 0);
+    UT_EQUAL(cdict_Count(cd), NUM_KEYS / 2);
+
+    UT_EQUAL(cdict_Destroy(cd), RS_PASS);
+
+    return 0;
+}
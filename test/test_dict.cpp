@@ -1,5 +1,8 @@
+#include <climits>
 #include <cstdio>
 #include <cstring>
+#include <string>
+#include <vector>
 
 
 #include "pnut.h"
@@ -20,15 +23,16 @@ typedef struct
 } test_struct_t;
 
 // Helpers.
-dict_t* create_str_dict(void);
-dict_t* create_int_dict(void);
+unsigned long long stats_BadHash(const void* data, size_t len, unsigned long long seed);
+dict_t* create_str_dict(unsigned int opts);
+dict_t* create_int_dict(unsigned int opts);
 
 
 /////////////////////////////////////////////////////////////////////////////
 UT_SUITE(DICT_STR, "Test all dict functions using string key.")
 {
     // Make a dict with string key. create_str_dict() tests dict_create() and dict_Set().
-    dict_t* mydict = create_str_dict();
+    dict_t* mydict = create_str_dict(DICT_CHAINED);
     UT_NOT_NULL(mydict);
     UT_EQUAL(dict_Count(mydict), 184);
 
@@ -83,7 +87,7 @@ UT_SUITE(DICT_STR, "Test all dict functions using string key.")
 UT_SUITE(DICT_INT, "Test some dict functions using int key.")
 {
     // Make a dict with int key. create_int_dict() tests dict_create() and dict_Set().
-    dict_t* mydict = create_int_dict();
+    dict_t* mydict = create_int_dict(DICT_CHAINED);
     UT_NOT_NULL(mydict);
     UT_EQUAL(dict_Count(mydict), 290);
 
@@ -119,11 +123,1641 @@ UT_SUITE(DICT_INT, "Test some dict functions using int key.")
     return 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_GROW, "Test the dict resizing itself.")
+{
+    const int NUM_KEYS = 5000;
+
+    // Start way too small.
+    dict_t* mydict = dict_CreateWithCapacity(KEY_INT, 4);
+    UT_NOT_NULL(mydict);
+
+    key_t key;
+    int bad = 0;
+
+    for(int k = 0; k < NUM_KEYS; k++)
+    {
+        CREATE_INST(st, test_struct_t);
+        st->anumber = k * 3;
+        key.ki = k - NUM_KEYS / 2; // some negatives too
+        bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+    }
+
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+
+    // Everything should have survived the moves.
+    for(int k = 0; k < NUM_KEYS; k++)
+    {
+        test_struct_t* ts = NULL;
+        key.ki = k - NUM_KEYS / 2;
+        if(dict_Get(mydict, key, (void**)&ts) != RS_PASS || ts->anumber != k * 3)
+        {
+            bad++;
+        }
+    }
+    UT_EQUAL(bad, 0);
+
+    // Shrinks back down and is still usable.
+    UT_EQUAL(dict_Clear(mydict), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), 0);
+    CREATE_INST(st, test_struct_t);
+    st->anumber = 77;
+    key.ki = 12;
+    UT_EQUAL(dict_Set(mydict, key, st), RS_PASS);
+    test_struct_t* ts = NULL;
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_EQUAL(ts->anumber, 77);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Bad capacity.
+    UT_NULL(dict_CreateWithCapacity(KEY_STRING, -1));
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_OPEN, "Test the open addressing flavor.")
+{
+    // String key.
+    dict_t* mydict = create_str_dict(DICT_OPEN);
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Count(mydict), 184);
+
+    test_struct_t* ts = NULL;
+    key_t key;
+
+    key.ks = "SOMETHING";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_NOT_NULL(ts);
+    UT_EQUAL(ts->anumber, 138);
+    UT_STR_EQUAL(ts->astring, "Ajay_138");
+
+    key.ks = "AAAAAA";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+
+    // Replace one.
+    CREATE_INST(tsrep, test_struct_t);
+    tsrep->anumber = 9999;
+    key.ks = "SOMETHING";
+    UT_EQUAL(dict_Set(mydict, key, tsrep), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), 184);
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_EQUAL(ts->anumber, 9999);
+
+    list_t* keys = dict_GetKeys(mydict);
+    UT_NOT_NULL(keys);
+    UT_EQUAL(list_Count(keys), 184);
+    UT_EQUAL(list_Destroy(keys), RS_PASS);
+
+    UT_EQUAL(dict_Clear(mydict), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), 0);
+    key.ks = "SOMETHING";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Int key.
+    mydict = create_int_dict(DICT_OPEN);
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Count(mydict), 290);
+
+    key.ki = 155;
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_NOT_NULL(ts);
+    UT_EQUAL(ts->anumber, 1155);
+    UT_STR_EQUAL(ts->astring, "Boo_1155");
+
+    key.ki = 444;
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+
+    // All there?
+    int bad = 0;
+    for(int k = 0; k < 290; k++)
+    {
+        key.ki = k;
+        if(dict_Get(mydict, key, (void**)&ts) != RS_PASS || ts->anumber != 1000 + k)
+        {
+            bad++;
+        }
+    }
+    UT_EQUAL(bad, 0);
+
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_GROUP, "Test the group probing flavor.")
+{
+    dict_t* mydict = create_str_dict(DICT_GROUP);
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Count(mydict), 184);
+
+    test_struct_t* ts = NULL;
+    key_t key;
+
+    key.ks = "SOMETHING";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_NOT_NULL(ts);
+    UT_EQUAL(ts->anumber, 138);
+
+    key.ks = "AAAAAA";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Lots of keys starting from the smallest table, which exercises the wrapped groups.
+    const int NUM_KEYS = 20000;
+    char buff[32];
+    int bad = 0;
+
+    mydict = dict_CreateEx(KEY_STRING, 0, DICT_GROUP);
+    UT_NOT_NULL(mydict);
+
+    for(int k = 0; k < NUM_KEYS; k++)
+    {
+        CREATE_INST(st, test_struct_t);
+        st->anumber = k;
+        snprintf(buff, sizeof(buff), "plant/line3/motor%d", k);
+        key.ks = buff;
+        bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+    }
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+
+    for(int k = 0; k < NUM_KEYS; k++)
+    {
+        snprintf(buff, sizeof(buff), "plant/line3/motor%d", k);
+        key.ks = buff;
+        bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == k) ? 0 : 1;
+
+        snprintf(buff, sizeof(buff), "plant/line4/motor%d", k);
+        bad += dict_Get(mydict, key, (void**)&ts) == RS_FAIL ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    UT_EQUAL(dict_Clear(mydict), RS_PASS);
+    key.ks = "plant/line3/motor1";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_HASH, "Test the hash functions.")
+{
+    // Known xxHash64 values.
+    UT_EQUAL(dict_HashFast("", 0, 0), 0xEF46DB3751D8E999ULL);
+    UT_EQUAL(dict_HashFast("abc", 3, 0), 0x44BC2CF5AD770999ULL);
+
+    // Seed matters.
+    const char* name = "plant/line3/motor7/temp";
+    UT_EQUAL(dict_HashSip(name, strlen(name), 1234), dict_HashSip(name, strlen(name), 1234));
+    UT_NOT_EQUAL(dict_HashSip(name, strlen(name), 1234), dict_HashSip(name, strlen(name), 1235));
+
+    // Only while empty.
+    dict_t* mydict = create_int_dict(DICT_CHAINED);
+    UT_EQUAL(dict_SetHash(mydict, dict_HashSip, 99), RS_ERR);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Use it.
+    mydict = dict_CreateEx(KEY_INT, 0, DICT_GROUP);
+    UT_EQUAL(dict_SetHash(mydict, NULL, 99), RS_ERR);
+    UT_EQUAL(dict_SetHash(mydict, dict_HashSip, 0x5EED5EED5EED5EEDULL), RS_PASS);
+
+    key_t key;
+    int bad = 0;
+    for(int k = -500; k < 500; k++)
+    {
+        CREATE_INST(st, test_struct_t);
+        st->anumber = k;
+        key.ki = k;
+        bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+    }
+
+    for(int k = -500; k < 500; k++)
+    {
+        test_struct_t* ts = NULL;
+        key.ki = k;
+        bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == k) ? 0 : 1;
+    }
+
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), 1000);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_ITER, "Test iterating and removing while iterating.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP };
+
+    for(int f = 0; f < 3; f++)
+    {
+        dict_t* mydict = create_str_dict(flavors[f]);
+        UT_NOT_NULL(mydict);
+
+        key_t key;
+        key_t kget;
+        test_struct_t* ts = NULL;
+        test_struct_t* tsget = NULL;
+
+        // Visit all once.
+        int num = 0;
+        int bad = 0;
+        UT_EQUAL(dict_IterStart(mydict), RS_PASS);
+        while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+        {
+            num++;
+            kget.ks = key.ks;
+            bad += (dict_Get(mydict, kget, (void**)&tsget) == RS_PASS && tsget == ts) ? 0 : 1;
+        }
+        UT_EQUAL(num, 184);
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(dict_IterNext(mydict, &key, (void**)&ts), RS_FAIL);
+
+        // Nothing to remove now.
+        UT_EQUAL(dict_IterRemove(mydict, (void**)&ts), RS_ERR);
+
+        // Take out the odd ones.
+        num = 0;
+        UT_EQUAL(dict_IterStart(mydict), RS_PASS);
+        while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+        {
+            num++;
+            if(ts->anumber % 2 == 1)
+            {
+                test_struct_t* tsrem = NULL;
+                bad += dict_IterRemove(mydict, (void**)&tsrem) == RS_PASS ? 0 : 1;
+                bad += tsrem == ts ? 0 : 1;
+                // I own this now so clean up.
+                FREE(tsrem);
+            }
+        }
+        UT_EQUAL(num, 184);
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(dict_Count(mydict), 92);
+
+        // What's left should all be even and findable.
+        num = 0;
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+        {
+            num++;
+            kget.ks = key.ks;
+            bad += ts->anumber % 2 == 0 ? 0 : 1;
+            bad += (dict_Get(mydict, kget, (void**)&tsget) == RS_PASS && tsget == ts) ? 0 : 1;
+        }
+        UT_EQUAL(num, 92);
+        UT_EQUAL(bad, 0);
+
+        // SOMETHING was 138 so stays, CAPITAL was odd so goes.
+        kget.ks = "SOMETHING";
+        UT_EQUAL(dict_Get(mydict, kget, (void**)&tsget), RS_PASS);
+        kget.ks = "CAPITAL";
+        UT_EQUAL(dict_Get(mydict, kget, (void**)&tsget), RS_FAIL);
+
+        // Empty it completely.
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+        {
+            dict_IterRemove(mydict, (void**)&ts);
+            FREE(ts);
+        }
+        UT_EQUAL(dict_Count(mydict), 0);
+        UT_EQUAL(dict_IterStart(mydict), RS_FAIL);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // Int keys come back as themselves.
+    dict_t* mydict = create_int_dict(DICT_CHAINED);
+    list_t* keys = dict_GetKeys(mydict);
+    int* pk;
+    int sum = 0;
+    list_IterStart(keys);
+    while(list_IterNext(keys, (void**)&pk) == RS_PASS)
+    {
+        sum += *pk;
+    }
+    UT_EQUAL(sum, 289 * 290 / 2);
+    UT_EQUAL(list_Destroy(keys), RS_PASS);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_REMOVE, "Test removing entries and lots of churn.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP };
+
+    for(int f = 0; f < 3; f++)
+    {
+        dict_t* mydict = create_str_dict(flavors[f]);
+        UT_NOT_NULL(mydict);
+
+        key_t key;
+        test_struct_t* ts = NULL;
+
+        // Good.
+        key.ks = "SOMETHING";
+        UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_PASS);
+        UT_NOT_NULL(ts);
+        UT_EQUAL(ts->anumber, 138);
+        // I own this now so clean up.
+        FREE(ts);
+        UT_EQUAL(dict_Count(mydict), 183);
+        UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+
+        // Not there (any more).
+        UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_FAIL);
+        key.ks = "AAAAAA";
+        UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_FAIL);
+        UT_EQUAL(dict_Count(mydict), 183);
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+        // Churn through ids like sessions do, checking against a shadow copy.
+        const int NUM_IDS = 2000;
+        int shadow[NUM_IDS];
+        int bad = 0;
+
+        mydict = dict_CreateEx(KEY_INT, 0, flavors[f]);
+        srand(4321);
+
+        for(int i = 0; i < NUM_IDS; i++)
+        {
+            shadow[i] = -1;
+        }
+
+        for(int n = 0; n < 50000; n++)
+        {
+            int id = rand() % NUM_IDS;
+            key.ki = id;
+
+            if(shadow[id] >= 0)
+            {
+                bad += (dict_Remove(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == shadow[id]) ? 0 : 1;
+                FREE(ts);
+                shadow[id] = -1;
+            }
+            else
+            {
+                CREATE_INST(st, test_struct_t);
+                st->anumber = n;
+                bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+                shadow[id] = n;
+            }
+        }
+
+        // Everything should agree.
+        int num = 0;
+        for(int i = 0; i < NUM_IDS; i++)
+        {
+            key.ki = i;
+            int res = dict_Get(mydict, key, (void**)&ts);
+            if(shadow[i] >= 0)
+            {
+                num++;
+                bad += (res == RS_PASS && ts->anumber == shadow[i]) ? 0 : 1;
+            }
+            else
+            {
+                bad += res == RS_FAIL ? 0 : 1;
+            }
+        }
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(dict_Count(mydict), num);
+
+        // Take almost all out so it shrinks, then check the rest.
+        for(int i = 0; i < NUM_IDS - 10; i++)
+        {
+            key.ki = i;
+            if(dict_Remove(mydict, key, (void**)&ts) == RS_PASS)
+            {
+                FREE(ts);
+                shadow[i] = -1;
+            }
+        }
+
+        for(int i = NUM_IDS - 10; i < NUM_IDS; i++)
+        {
+            key.ki = i;
+            int res = dict_Get(mydict, key, (void**)&ts);
+            bad += (shadow[i] >= 0 ? res == RS_PASS && ts->anumber == shadow[i] : res == RS_FAIL) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_UPSERT, "Test dict_GetOrInsert().")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP };
+    const char* words[] = { "THE", "OLD", "MAN", "AND", "THE", "SEA", "THE", "END", "OLD" };
+
+    for(int f = 0; f < 3; f++)
+    {
+        dict_t* mydict = dict_CreateEx(KEY_STRING, 0, flavors[f]);
+        key_t key;
+        void** slot;
+        bool inserted;
+        int num_new = 0;
+
+        // Count them.
+        for(int w = 0; w < 9; w++)
+        {
+            key.ks = words[w];
+            UT_EQUAL(dict_GetOrInsert(mydict, key, &slot, &inserted), RS_PASS);
+            UT_NOT_NULL(slot);
+
+            if(inserted)
+            {
+                num_new++;
+                UT_NULL(*slot);
+                CREATE_INST(pcnt, int);
+                *slot = pcnt;
+            }
+
+            (*(int*)*slot)++;
+        }
+
+        UT_EQUAL(num_new, 6);
+        UT_EQUAL(dict_Count(mydict), 6);
+
+        int* pcnt = NULL;
+        key.ks = "THE";
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pcnt), RS_PASS);
+        UT_EQUAL(*pcnt, 3);
+        key.ks = "OLD";
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pcnt), RS_PASS);
+        UT_EQUAL(*pcnt, 2);
+        key.ks = "SEA";
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pcnt), RS_PASS);
+        UT_EQUAL(*pcnt, 1);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_INCREMENTAL, "Test resizing a few bins at a time.")
+{
+    // Only for chains.
+    UT_NULL(dict_CreateEx(KEY_INT, 0, DICT_INCREMENTAL | DICT_OPEN));
+    UT_NULL(dict_CreateEx(KEY_INT, 0, DICT_INCREMENTAL | DICT_GROUP));
+
+    const int NUM_KEYS = 20000;
+    dict_t* mydict = dict_CreateEx(KEY_INT, 0, DICT_INCREMENTAL);
+    UT_NOT_NULL(mydict);
+
+    key_t key;
+    test_struct_t* ts;
+    int bad = 0;
+
+    // Everything added so far should always be findable, wherever it is right now.
+    for(int k = 0; k < NUM_KEYS; k++)
+    {
+        CREATE_INST(st, test_struct_t);
+        st->anumber = k;
+        key.ki = k;
+        bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+
+        for(int j = k; j >= 0; j -= 997)
+        {
+            key.ki = j;
+            bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == j) ? 0 : 1;
+        }
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+
+    // Replace and remove while moving.
+    for(int k = 0; k < NUM_KEYS; k += 2)
+    {
+        key.ki = k;
+        bad += dict_Remove(mydict, key, (void**)&ts) == RS_PASS ? 0 : 1;
+        FREE(ts);
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS / 2);
+
+    // Iteration sees each one once.
+    int num = 0;
+    int sum = 0;
+    dict_IterStart(mydict);
+    while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+    {
+        num++;
+        sum += key.ki % 2;
+    }
+    UT_EQUAL(num, NUM_KEYS / 2);
+    UT_EQUAL(sum, NUM_KEYS / 2);
+
+    // Shrink a lot.
+    for(int k = 1; k < NUM_KEYS - 100; k += 2)
+    {
+        key.ki = k;
+        bad += dict_Remove(mydict, key, (void**)&ts) == RS_PASS ? 0 : 1;
+        FREE(ts);
+    }
+
+    for(int k = 0; k < NUM_KEYS; k++)
+    {
+        key.ki = k;
+        bool there = k % 2 == 1 && k >= NUM_KEYS - 100;
+        bad += dict_Get(mydict, key, (void**)&ts) == (there ? RS_PASS : RS_FAIL) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), 50);
+
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_KEY_LEN, "Test string keys either side of the inline size.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_ARENA };
+
+    for(int f = 0; f < 4; f++)
+    {
+        dict_t* mydict = dict_CreateEx(KEY_STRING, 0, flavors[f]);
+        key_t key;
+        test_struct_t* ts = NULL;
+        int bad = 0;
+
+        // Lengths 0 to 39, twice so there are shared prefixes.
+        std::string keys[80];
+        for(int i = 0; i < 80; i++)
+        {
+            keys[i] = std::string(i % 40, 'a' + i / 40);
+            key.ks = keys[i].c_str();
+            CREATE_INST(st, test_struct_t);
+            st->anumber = i;
+            bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+        }
+        UT_EQUAL(dict_Count(mydict), 79); // two empty ones
+
+        // Keys come back intact.
+        int num = 0;
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+        {
+            num++;
+            bad += keys[ts->anumber] == key.ks ? 0 : 1;
+        }
+        UT_EQUAL(num, 79);
+
+        // Take out every other one and check the rest are still right.
+        for(int i = 1; i < 80; i += 2)
+        {
+            key.ks = keys[i].c_str();
+            bad += dict_Remove(mydict, key, (void**)&ts) == RS_PASS ? 0 : 1;
+            FREE(ts);
+        }
+
+        for(int i = 0; i < 80; i++)
+        {
+            key.ks = keys[i].c_str();
+            int res = dict_Get(mydict, key, (void**)&ts);
+            bad += (i % 2 == 1 ? res == RS_FAIL : res == RS_PASS && keys[ts->anumber] == keys[i]) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        // Copies of long and short keys.
+        list_t* kl = dict_GetKeys(mydict);
+        UT_EQUAL(list_Count(kl), 39);
+        UT_EQUAL(list_Destroy(kl), RS_PASS);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_BYTES, "Test binary keys either side of the inline size.")
+{
+    // Passed by pointer so every key_t stays this size.
+    UT_EQUAL(sizeof(key_t), sizeof(unsigned long long));
+
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_ARENA, DICT_INCREMENTAL | DICT_FILTER };
+
+    for(int f = 0; f < 5; f++)
+    {
+        dict_t* mydict = dict_CreateEx(KEY_BYTES, 0, flavors[f]);
+        key_t key;
+        int* pi = NULL;
+        int bad = 0;
+
+        // Lengths 0 to 31 of mostly zeros so only the length tells some apart.
+        std::string keys[64];
+        for(int i = 0; i < 64; i++)
+        {
+            keys[i] = std::string(i % 32, '\0');
+            if(i >= 32 && keys[i].size() > 0)
+            {
+                keys[i][keys[i].size() - 1] = (char)0xFF;
+            }
+            kbytes_t kb = { keys[i].data(), keys[i].size() };
+            key.kb = &kb;
+            CREATE_INST(pv, int);
+            *pv = i;
+            bad += dict_Set(mydict, key, pv) == RS_PASS ? 0 : 1;
+        }
+        UT_EQUAL(dict_Count(mydict), 63); // two empty ones
+
+        // Keys come back intact.
+        int num = 0;
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&pi) == RS_PASS)
+        {
+            num++;
+            bad += keys[*pi] == std::string((const char*)key.kb->data, key.kb->len) ? 0 : 1;
+        }
+        UT_EQUAL(num, 63);
+
+        for(int i = 1; i < 64; i += 2)
+        {
+            kbytes_t kb = { keys[i].data(), keys[i].size() };
+            key.kb = &kb;
+            bad += dict_Remove(mydict, key, (void**)&pi) == RS_PASS ? 0 : 1;
+            FREE(pi);
+        }
+
+        for(int i = 0; i < 64; i++)
+        {
+            kbytes_t kb = { keys[i].data(), keys[i].size() };
+            key.kb = &kb;
+            int res = dict_Get(mydict, key, (void**)&pi);
+            bad += (i % 2 == 1 ? res == RS_FAIL : res == RS_PASS && keys[*pi] == keys[i]) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        // Copies with the bytes after.
+        list_t* kl = dict_GetKeys(mydict);
+        UT_EQUAL(list_Count(kl), 31);
+        kbytes_t* pb;
+        list_IterStart(kl);
+        while(list_IterNext(kl, (void**)&pb) == RS_PASS)
+        {
+            bad += pb->data == pb + 1 && pb->len < 32 ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(list_Destroy(kl), RS_PASS);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // Long ones in client memory.
+    std::vector<unsigned long long> buf(dict_StaticSize(10, 200) / 8 + 1);
+    dict_t* sdict = dict_InitStatic(buf.data(), buf.size() * 8, KEY_BYTES, 10);
+    UT_NOT_NULL(sdict);
+    unsigned char uuid[16] = { 0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3, 0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00 };
+    int val = 5;
+    key_t key;
+    kbytes_t kb = { uuid, sizeof(uuid) };
+    key.kb = &kb;
+    UT_EQUAL(dict_Set(sdict, key, &val), RS_PASS);
+    int* pi = NULL;
+    UT_EQUAL(dict_Get(sdict, key, (void**)&pi), RS_PASS);
+    UT_EQUAL(*pi, 5);
+    uuid[15] = 1;
+    UT_EQUAL(dict_Get(sdict, key, (void**)&pi), RS_FAIL);
+
+    // Lengths that don't fit an unsigned int are refused, not cut short. The bytes aren't read.
+    if(sizeof(size_t) > sizeof(unsigned int))
+    {
+        kb.len = (size_t)UINT_MAX + 1 + sizeof(uuid);
+        bool inserted = false;
+        void** slot = NULL;
+        UT_EQUAL(dict_Set(sdict, key, &val), RS_ERR);
+        UT_EQUAL(dict_Get(sdict, key, (void**)&pi), RS_ERR);
+        UT_EQUAL(dict_GetOrInsert(sdict, key, &slot, &inserted), RS_ERR);
+        UT_EQUAL(dict_Remove(sdict, key, (void**)&pi), RS_ERR);
+        int status = RS_PASS;
+        UT_EQUAL(dict_GetMany(sdict, &key, 1, (void**)&pi, &status), RS_ERR);
+        UT_EQUAL(dict_Count(sdict), 1);
+    }
+
+    key.kb = NULL;
+    UT_EQUAL(dict_Set(sdict, key, &val), RS_ERR);
+    UT_EQUAL(dict_Get(sdict, key, (void**)&pi), RS_ERR);
+    UT_EQUAL(dict_Destroy(sdict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_U64, "Test 64 bit keys.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL | DICT_FILTER };
+
+    for(int f = 0; f < 4; f++)
+    {
+        dict_t* mydict = dict_CreateInlineEx(KEY_U64, 0, flavors[f], sizeof(int));
+        key_t key;
+        int* pi = NULL;
+        int bad = 0;
+
+        // Device ids that only differ in the high half.
+        for(int i = 0; i < 5000; i++)
+        {
+            key.ku = ((unsigned long long)i << 40) | 0xABCDull;
+            bad += dict_Set(mydict, key, &i) == RS_PASS ? 0 : 1;
+        }
+        UT_EQUAL(dict_Count(mydict), 5000);
+
+        for(int i = 0; i < 5000; i++)
+        {
+            key.ku = ((unsigned long long)i << 40) | 0xABCDull;
+            bad += dict_Get(mydict, key, (void**)&pi) == RS_PASS && *pi == i ? 0 : 1;
+            key.ku = (unsigned long long)i;
+            bad += dict_Get(mydict, key, (void**)&pi) == RS_FAIL ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        unsigned long long sum = 0;
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&pi) == RS_PASS)
+        {
+            sum += key.ku >> 40;
+        }
+        UT_EQUAL(sum, 4999ull * 5000 / 2);
+
+        // Not for files.
+        UT_EQUAL(dict_Save(mydict, "u64.dict"), RS_ERR);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_ARENA, "Test keeping string keys in shared blocks.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP };
+
+    for(int f = 0; f < 3; f++)
+    {
+        dict_t* mydict = create_str_dict(flavors[f] | DICT_ARENA);
+        UT_NOT_NULL(mydict);
+        UT_EQUAL(dict_Count(mydict), 184);
+
+        key_t key;
+        test_struct_t* ts = NULL;
+
+        key.ks = "SOMETHING";
+        UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+        UT_EQUAL(ts->anumber, 138);
+
+        // Removing leaves the key bytes where they are.
+        UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_PASS);
+        FREE(ts);
+        UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+
+        // Lots of keys so it takes several chunks, and a few that don't fit in one.
+        int bad = 0;
+        char buff[100];
+        std::string big(100000, 'x');
+
+        for(int i = 0; i < 20000; i++)
+        {
+            snprintf(buff, sizeof(buff), "plant/line3/sensor%07d/temp", i);
+            key.ks = buff;
+            CREATE_INST(st, test_struct_t);
+            st->anumber = i;
+            bad += dict_Set(mydict, key, st) == RS_PASS ? 0 : 1;
+
+            if(i % 5000 == 0)
+            {
+                big[i / 5000] = 'y';
+                key.ks = big.c_str();
+                CREATE_INST(stb, test_struct_t);
+                stb->anumber = -i;
+                bad += dict_Set(mydict, key, stb) == RS_PASS ? 0 : 1;
+            }
+        }
+
+        for(int i = 0; i < 20000; i++)
+        {
+            snprintf(buff, sizeof(buff), "plant/line3/sensor%07d/temp", i);
+            key.ks = buff;
+            bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == i) ? 0 : 1;
+        }
+
+        key.ks = big.c_str();
+        bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == -15000) ? 0 : 1;
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(dict_Count(mydict), 183 + 20000 + 4);
+
+        // Starts over after clear.
+        UT_EQUAL(dict_Clear(mydict), RS_PASS);
+        UT_EQUAL(dict_Count(mydict), 0);
+        key.ks = "CAPITAL";
+        CREATE_INST(st, test_struct_t);
+        st->anumber = 5;
+        UT_EQUAL(dict_Set(mydict, key, st), RS_PASS);
+        UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+        UT_EQUAL(ts->anumber, 5);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // Doesn't matter for ints.
+    dict_t* mydict = create_int_dict(DICT_ARENA);
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_INLINE, "Test dicts that hold the values themselves.")
+{
+    // Has to be a real size.
+    UT_NULL(dict_CreateInline(KEY_INT, 0));
+
+    typedef struct { int count; double sum; char tag[8]; } stats_t;
+
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL };
+    const int NUM_KEYS = 5000;
+
+    for(int f = 0; f < 4; f++)
+    {
+        dict_t* mydict = dict_CreateInlineEx(KEY_INT, 10, flavors[f], sizeof(stats_t));
+        UT_NOT_NULL(mydict);
+
+        key_t key;
+        stats_t st;
+        stats_t* pst = NULL;
+        int bad = 0;
+
+        // Copied in, so the same local can be reused.
+        for(int k = 0; k < NUM_KEYS; k++)
+        {
+            key.ki = k;
+            st.count = k;
+            st.sum = k * 0.5;
+            snprintf(st.tag, sizeof(st.tag), "t%d", k % 1000);
+            bad += dict_Set(mydict, key, &st) == RS_PASS ? 0 : 1;
+        }
+        UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+
+        for(int k = 0; k < NUM_KEYS; k++)
+        {
+            key.ki = k;
+            bad += (dict_Get(mydict, key, (void**)&pst) == RS_PASS && pst->count == k && pst->sum == k * 0.5) ? 0 : 1;
+            bad += (size_t)pst % 8 == 0 ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        // Replace one.
+        key.ki = 7;
+        st.count = 777;
+        UT_EQUAL(dict_Set(mydict, key, &st), RS_PASS);
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pst), RS_PASS);
+        UT_EQUAL(pst->count, 777);
+        UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+
+        // Update in place and add new ones zeroed.
+        void** slot;
+        bool inserted;
+        for(int k = NUM_KEYS - 10; k < NUM_KEYS + 10; k++)
+        {
+            key.ki = k;
+            bad += dict_GetOrInsert(mydict, key, &slot, &inserted) == RS_PASS ? 0 : 1;
+            pst = (stats_t*)slot;
+            bad += inserted == (k >= NUM_KEYS) ? 0 : 1;
+            bad += (inserted ? pst->count == 0 && pst->tag[0] == 0 : pst->count == k) ? 0 : 1;
+            pst->count += 1000000;
+        }
+        key.ki = NUM_KEYS + 3;
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pst), RS_PASS);
+        UT_EQUAL(pst->count, 1000000);
+
+        // Values go with the entry.
+        for(int k = 0; k < NUM_KEYS; k += 2)
+        {
+            key.ki = k;
+            pst = &st;
+            bad += (dict_Remove(mydict, key, (void**)&pst) == RS_PASS && pst == NULL) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(dict_Count(mydict), NUM_KEYS / 2 + 10);
+
+        // What's left survived the moves.
+        int num = 0;
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&pst) == RS_PASS)
+        {
+            num++;
+            int expect = key.ki == 7 ? 777 : key.ki < NUM_KEYS ? key.ki : 0;
+            bad += pst->count % 1000000 == expect ? 0 : 1;
+            bad += key.ki >= NUM_KEYS || key.ki == 7 || pst->sum == key.ki * 0.5 ? 0 : 1;
+            if(key.ki % 10 == 1)
+            {
+                bad += (dict_IterRemove(mydict, (void**)&pst) == RS_PASS && pst == NULL) ? 0 : 1;
+            }
+        }
+        UT_EQUAL(num, NUM_KEYS / 2 + 10);
+        UT_EQUAL(bad, 0);
+
+        UT_EQUAL(dict_Clear(mydict), RS_PASS);
+        UT_EQUAL(dict_Count(mydict), 0);
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // String keys and an odd size.
+    dict_t* mydict = dict_CreateInline(KEY_STRING, 3);
+    key_t key;
+    char* pc = NULL;
+    key.ks = "a key that is too long to be inline";
+    UT_EQUAL(dict_Set(mydict, key, (void*)"xyz"), RS_PASS);
+    key.ks = "short";
+    UT_EQUAL(dict_Set(mydict, key, (void*)"abc"), RS_PASS);
+    UT_EQUAL(dict_Get(mydict, key, (void**)&pc), RS_PASS);
+    UT_EQUAL(strncmp(pc, "abc", 3), 0);
+    key.ks = "a key that is too long to be inline";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&pc), RS_PASS);
+    UT_EQUAL(strncmp(pc, "xyz", 3), 0);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_STATIC, "Test dicts in client memory.")
+{
+    const int MAX_ENTRIES = 100;
+    const size_t KEY_BYTES = 10 * 40;
+    static unsigned long long buf[4096];
+    static test_struct_t values[MAX_ENTRIES + 1];
+
+    // Sizing.
+    UT_EQUAL(dict_StaticSize(0, 100), 0);
+    size_t bytes = dict_StaticSize(MAX_ENTRIES, KEY_BYTES);
+    UT_TRUE(bytes > dict_StaticSize(MAX_ENTRIES, 0));
+    UT_TRUE(bytes <= sizeof(buf));
+    UT_NULL(dict_InitStatic(buf, dict_StaticSize(MAX_ENTRIES, 0) - 1, KEY_STRING, MAX_ENTRIES));
+    UT_NULL(dict_InitStatic((char*)buf + 1, bytes, KEY_STRING, MAX_ENTRIES));
+    UT_NULL(dict_InitStatic(buf, bytes, KEY_STRING, 0));
+
+    dict_t* mydict = dict_InitStatic(buf, bytes, KEY_STRING, MAX_ENTRIES);
+    UT_TRUE((void*)mydict == (void*)buf);
+
+    key_t key;
+    test_struct_t* ts;
+    char sk[64];
+    int bad = 0;
+
+    // Fill it up with short keys.
+    for(int i = 0; i < MAX_ENTRIES; i++)
+    {
+        snprintf(sk, sizeof(sk), "key%d", i);
+        key.ks = sk;
+        values[i].anumber = i;
+        bad += dict_Set(mydict, key, &values[i]) == RS_PASS ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), MAX_ENTRIES);
+
+    // No more.
+    key.ks = "one_too_many";
+    UT_EQUAL(dict_Set(mydict, key, &values[MAX_ENTRIES]), RS_FAIL);
+    void** slot;
+    bool inserted;
+    UT_EQUAL(dict_GetOrInsert(mydict, key, &slot, &inserted), RS_FAIL);
+    UT_FALSE(inserted);
+
+    // Replacing is fine.
+    key.ks = "key42";
+    UT_EQUAL(dict_Set(mydict, key, &values[MAX_ENTRIES]), RS_PASS);
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_TRUE(ts == &values[MAX_ENTRIES]);
+
+    for(int i = 0; i < MAX_ENTRIES; i++)
+    {
+        snprintf(sk, sizeof(sk), "key%d", i);
+        key.ks = sk;
+        bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && (i == 42 || ts == &values[i])) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    // Make space with remove. Client still owns the value.
+    key.ks = "key7";
+    UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_PASS);
+    UT_TRUE(ts == &values[7]);
+    UT_EQUAL(dict_Count(mydict), MAX_ENTRIES - 1);
+
+    // Long keys use the key space, 40 bytes each here.
+    UT_EQUAL(dict_Clear(mydict), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), 0);
+
+    int num = 0;
+    for(int i = 0; i < MAX_ENTRIES; i++)
+    {
+        snprintf(sk, sizeof(sk), "a_long_key_that_takes_forty_bytes_%04d", i);
+        key.ks = sk;
+        if(dict_Set(mydict, key, &values[i]) == RS_PASS)
+        {
+            num++;
+        }
+    }
+    UT_EQUAL(num, 10);
+
+    // Still good for short ones.
+    key.ks = "short";
+    UT_EQUAL(dict_Set(mydict, key, &values[0]), RS_PASS);
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    key.ks = "a_long_key_that_takes_forty_bytes_0009";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_TRUE(ts == &values[9]);
+
+    // Clear gives the key space back.
+    UT_EQUAL(dict_Clear(mydict), RS_PASS);
+    key.ks = "a_long_key_that_takes_forty_bytes_0050";
+    UT_EQUAL(dict_Set(mydict, key, &values[50]), RS_PASS);
+
+    // Nothing to free.
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Int keys.
+    mydict = dict_InitStatic(buf, dict_StaticSize(MAX_ENTRIES, 0), KEY_INT, MAX_ENTRIES);
+    UT_NOT_NULL(mydict);
+    for(int i = 0; i < MAX_ENTRIES + 5; i++)
+    {
+        key.ki = i * 7919;
+        bad += dict_Set(mydict, key, &values[i % MAX_ENTRIES]) == (i < MAX_ENTRIES ? RS_PASS : RS_FAIL) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Count(mydict), MAX_ENTRIES);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_GET_MANY, "Test looking up a batch of keys.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL };
+    const int NUM_KEYS = 3000;
+    const int NUM_GET = 301; // not a multiple of anything
+    key_t keys[NUM_GET];
+    void* values[NUM_GET];
+    int status[NUM_GET];
+
+    for(int f = 0; f < 4; f++)
+    {
+        // Even ones only.
+        dict_t* mydict = dict_CreateEx(KEY_INT, 0, flavors[f]);
+        key_t key;
+        for(int k = 0; k < NUM_KEYS; k++)
+        {
+            key.ki = k * 2;
+            CREATE_INST(st, test_struct_t);
+            st->anumber = k * 2;
+            dict_Set(mydict, key, st);
+        }
+
+        for(int i = 0; i < NUM_GET; i++)
+        {
+            keys[i].ki = (i * 37) % (NUM_KEYS * 2);
+        }
+
+        UT_EQUAL(dict_GetMany(mydict, keys, NUM_GET, values, status), RS_PASS);
+
+        // Same as one at a time.
+        int bad = 0;
+        int found = 0;
+        for(int i = 0; i < NUM_GET; i++)
+        {
+            void* v = NULL;
+            int res = dict_Get(mydict, keys[i], &v);
+            bad += status[i] == res ? 0 : 1;
+            bad += (res == RS_PASS ? values[i] == v && ((test_struct_t*)v)->anumber == keys[i].ki : values[i] == NULL) ? 0 : 1;
+            found += res == RS_PASS ? 1 : 0;
+        }
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(found, (NUM_GET + 1) / 2);
+
+        UT_EQUAL(dict_GetMany(mydict, keys, 0, values, status), RS_PASS);
+        UT_EQUAL(dict_GetMany(mydict, NULL, NUM_GET, values, status), RS_ERR);
+        UT_EQUAL(dict_GetMany(mydict, keys, NUM_GET, values, NULL), RS_ERR);
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // String keys.
+    dict_t* mydict = create_str_dict(DICT_GROUP);
+    const char* words[] = { "SOMETHING", "NOT_A_WORD", "CAPITAL" };
+    for(int i = 0; i < 3; i++)
+    {
+        keys[i].ks = words[i];
+    }
+    UT_EQUAL(dict_GetMany(mydict, keys, 3, values, status), RS_PASS);
+    UT_EQUAL(status[0], RS_PASS);
+    UT_EQUAL(((test_struct_t*)values[0])->anumber, 138);
+    UT_EQUAL(status[1], RS_FAIL);
+    UT_EQUAL(status[2], RS_PASS);
+    UT_EQUAL(((test_struct_t*)values[2])->anumber, 107);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_FILTER, "Test the bloom filter in front of the table.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL };
+    const int NUM_KEYS = 20000;
+
+    for(int f = 0; f < 4; f++)
+    {
+        // Same as without, just quicker for misses.
+        dict_t* mydict = dict_CreateInlineEx(KEY_INT, 0, flavors[f] | DICT_FILTER, sizeof(int));
+        dict_t* plain = dict_CreateInlineEx(KEY_INT, 0, flavors[f], sizeof(int));
+        key_t key;
+        int* pv;
+        int bad = 0;
+
+        // Grow, churn and shrink so it gets rebuilt a few ways.
+        for(int k = 0; k < NUM_KEYS; k++)
+        {
+            key.ki = k * 3;
+            dict_Set(mydict, key, &k);
+            dict_Set(plain, key, &k);
+        }
+        for(int k = 0; k < NUM_KEYS; k += 2)
+        {
+            key.ki = k * 3;
+            dict_Remove(mydict, key, (void**)&pv);
+            dict_Remove(plain, key, (void**)&pv);
+        }
+        for(int k = 0; k < NUM_KEYS; k += 4)
+        {
+            key.ki = k * 3;
+            dict_Set(mydict, key, &k);
+            dict_Set(plain, key, &k);
+        }
+        for(int k = NUM_KEYS / 2; k < NUM_KEYS; k++)
+        {
+            key.ki = k * 3;
+            dict_Remove(mydict, key, (void**)&pv);
+            dict_Remove(plain, key, (void**)&pv);
+        }
+
+        UT_EQUAL(dict_Count(mydict), dict_Count(plain));
+
+        for(int k = -100; k < NUM_KEYS * 3; k++)
+        {
+            key.ki = k;
+            bad += dict_Get(mydict, key, (void**)&pv) == dict_Get(plain, key, (void**)&pv) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        key_t keys[100];
+        void* values[100];
+        int status[100];
+        for(int i = 0; i < 100; i++)
+        {
+            keys[i].ki = i * 7;
+        }
+        UT_EQUAL(dict_GetMany(mydict, keys, 100, values, status), RS_PASS);
+        for(int i = 0; i < 100; i++)
+        {
+            bad += status[i] == dict_Get(plain, keys[i], (void**)&pv) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        // Should let few misses through.
+        dict_stats_t stats;
+        UT_EQUAL(dict_GetStats(mydict, &stats), RS_PASS);
+        UT_EQUAL(stats.count, dict_Count(mydict));
+        UT_TRUE(stats.filter_bytes > 0);
+        UT_TRUE(stats.filter_fp_rate > 0 && stats.filter_fp_rate < 0.02);
+
+        UT_EQUAL(dict_GetStats(plain, &stats), RS_PASS);
+        UT_EQUAL(stats.filter_bytes, 0);
+        UT_EQUAL(stats.filter_fp_rate, 0);
+
+        // Frozen gets a fresh one.
+        UT_EQUAL(dict_Freeze(mydict), RS_PASS);
+        key.ki = 3;
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pv), RS_PASS);
+        UT_EQUAL(*pv, 1);
+
+        dict_Destroy(mydict);
+        mydict = dict_CreateEx(KEY_STRING, 0, flavors[f] | DICT_FILTER);
+        for(int k = 0; k < 1000; k++)
+        {
+            std::string sk = "key_" + std::to_string(k);
+            key.ks = sk.c_str();
+            CREATE_INST(st, test_struct_t);
+            st->anumber = k;
+            dict_Set(mydict, key, st);
+        }
+
+        UT_EQUAL(dict_Clear(mydict), RS_PASS);
+        UT_EQUAL(dict_GetStats(mydict, &stats), RS_PASS);
+        UT_EQUAL(stats.count, 0);
+        UT_EQUAL(stats.filter_fp_rate, 0);
+        key.ks = "key_5";
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pv), RS_FAIL);
+
+        dict_Destroy(mydict);
+        dict_Destroy(plain);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_STATS, "Test dict_GetStats().")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL };
+    dict_stats_t stats;
+    key_t key;
+
+    UT_EQUAL(dict_GetStats(NULL, &stats), RS_ERR);
+
+    for(int f = 0; f < 4; f++)
+    {
+        dict_t* mydict = dict_CreateInlineEx(KEY_INT, 0, flavors[f], sizeof(int));
+        UT_EQUAL(dict_GetStats(mydict, NULL), RS_ERR);
+        UT_EQUAL(dict_GetStats(mydict, &stats), RS_PASS);
+        UT_EQUAL(stats.count, 0);
+        UT_EQUAL(stats.max_probe, 0);
+        UT_EQUAL(stats.mean_probe, 0);
+        UT_EQUAL(stats.resizes, 0);
+        size_t empty_bytes = stats.bytes;
+
+        for(int k = 0; k < 10000; k++)
+        {
+            key.ki = k;
+            dict_Set(mydict, key, &k);
+        }
+
+        // Self consistent.
+        UT_EQUAL(dict_GetStats(mydict, &stats), RS_PASS);
+        UT_EQUAL(stats.count, 10000);
+        UT_CLOSE(stats.load, 10000.0 / stats.num_bins, 0.000001);
+        UT_TRUE(stats.resizes > 5);
+        UT_TRUE(stats.bytes > empty_bytes + 10000 * sizeof(int));
+
+        unsigned int total = 0;
+        double probes = 0;
+        for(int i = 0; i < DICT_STATS_HIST; i++)
+        {
+            total += stats.probe_hist[i];
+            probes += (double)stats.probe_hist[i] * (i + 1);
+        }
+        UT_EQUAL(total, 10000);
+        UT_TRUE(stats.max_probe >= 1);
+
+        // The last one counts anything longer as if it were that long.
+        if(stats.max_probe < DICT_STATS_HIST)
+        {
+            UT_CLOSE(stats.mean_probe, probes / 10000, 0.000001);
+        }
+        else
+        {
+            UT_TRUE(stats.mean_probe > probes / 10000);
+        }
+        UT_TRUE(stats.mean_probe >= 1 && stats.mean_probe < 2);
+        dict_Destroy(mydict);
+
+        // A hash that puts everything in one place shows up.
+        mydict = dict_CreateInlineEx(KEY_INT, 100, flavors[f], sizeof(int));
+        UT_EQUAL(dict_SetHash(mydict, stats_BadHash, 0), RS_PASS);
+        for(int k = 0; k < 100; k++)
+        {
+            key.ki = k;
+            dict_Set(mydict, key, &k);
+        }
+        UT_EQUAL(dict_GetStats(mydict, &stats), RS_PASS);
+        UT_EQUAL(stats.max_probe, 100);
+        UT_CLOSE(stats.mean_probe, 50.5, 0.000001);
+        UT_EQUAL(stats.probe_hist[0], 1);
+        UT_EQUAL(stats.probe_hist[DICT_STATS_HIST - 1], 100 - DICT_STATS_HIST + 1);
+        UT_EQUAL(stats.resizes, 0);
+        dict_Destroy(mydict);
+    }
+
+    // Long string keys cost their length, in the arena or not.
+    for(int arena = 0; arena < 2; arena++)
+    {
+        dict_t* mydict = dict_CreateEx(KEY_STRING, 1000, arena ? DICT_ARENA : DICT_CHAINED);
+        size_t bytes[2];
+        for(int round = 0; round < 2; round++)
+        {
+            for(int k = 0; k < 1000; k++)
+            {
+                std::string sk = (round ? "a_rather_long_key_" : "k") + std::to_string(k);
+                key.ks = sk.c_str();
+                CREATE_INST(st, test_struct_t);
+                dict_Set(mydict, key, st);
+            }
+            UT_EQUAL(dict_GetStats(mydict, &stats), RS_PASS);
+            bytes[round] = stats.bytes;
+        }
+        UT_TRUE(bytes[1] - bytes[0] >= 1000 * (sizeof(void*) + 21));
+        dict_Destroy(mydict);
+    }
+
+    // Static is the whole buffer.
+    size_t size = dict_StaticSize(100, 1000);
+    std::vector<unsigned long long> buf(size / 8 + 1);
+    dict_t* sdict = dict_InitStatic(buf.data(), size, KEY_INT, 100);
+    UT_EQUAL(dict_GetStats(sdict, &stats), RS_PASS);
+    UT_EQUAL(stats.bytes, size);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_FREEZE, "Test read-only dicts.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL };
+
+    for(int f = 0; f < 4; f++)
+    {
+        // Grow it a lot then take most out so freezing has something to shrink.
+        dict_t* mydict = dict_CreateEx(KEY_INT, 0, flavors[f]);
+        key_t key;
+        test_struct_t* ts;
+        int bad = 0;
+
+        for(int k = 0; k < 5000; k++)
+        {
+            key.ki = k;
+            CREATE_INST(st, test_struct_t);
+            st->anumber = k;
+            dict_Set(mydict, key, st);
+        }
+        for(int k = 100; k < 4000; k++)
+        {
+            key.ki = k;
+            dict_Remove(mydict, key, (void**)&ts);
+            FREE(ts);
+        }
+
+        UT_EQUAL(dict_Freeze(mydict), RS_PASS);
+        UT_EQUAL(dict_Freeze(mydict), RS_PASS);
+        UT_EQUAL(dict_Count(mydict), 1100);
+
+        // Reads still work.
+        for(int k = 0; k < 5000; k++)
+        {
+            key.ki = k;
+            int res = dict_Get(mydict, key, (void**)&ts);
+            bad += (k >= 100 && k < 4000 ? res == RS_FAIL : res == RS_PASS && ts->anumber == k) ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        int num = 0;
+        dict_IterStart(mydict);
+        while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+        {
+            num++;
+        }
+        UT_EQUAL(num, 1100);
+
+        // Writes don't.
+        key.ki = 1;
+        void** slot;
+        bool inserted;
+        CREATE_INST(st, test_struct_t);
+        UT_EQUAL(dict_Set(mydict, key, st), RS_ERR);
+        FREE(st);
+        UT_EQUAL(dict_GetOrInsert(mydict, key, &slot, &inserted), RS_ERR);
+        UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_ERR);
+        dict_IterStart(mydict);
+        dict_IterNext(mydict, &key, (void**)&ts);
+        UT_EQUAL(dict_IterRemove(mydict, (void**)&ts), RS_ERR);
+        UT_EQUAL(dict_SetHash(mydict, dict_HashSip, 1), RS_ERR);
+        UT_EQUAL(dict_Clear(mydict), RS_ERR);
+        UT_EQUAL(dict_Count(mydict), 1100);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+        // Big to start with so the freeze shrinks it. Nothing may be left to move afterwards,
+        // so reading it doesn't change anything.
+        dict_stats_t before;
+        dict_stats_t after;
+        mydict = dict_CreateEx(KEY_INT, 10000, flavors[f]);
+        for(int k = 0; k < 100; k++)
+        {
+            key.ki = k;
+            CREATE_INST(st, test_struct_t);
+            st->anumber = k;
+            dict_Set(mydict, key, st);
+        }
+        UT_EQUAL(dict_Freeze(mydict), RS_PASS);
+
+        UT_EQUAL(dict_GetStats(mydict, &before), RS_PASS);
+        list_t* keys = dict_GetKeys(mydict);
+        UT_NOT_NULL(keys);
+        UT_EQUAL(list_Count(keys), 100);
+        UT_EQUAL(list_Destroy(keys), RS_PASS);
+        UT_EQUAL(dict_GetStats(mydict, &after), RS_PASS);
+        UT_EQUAL(after.bytes, before.bytes);
+        UT_EQUAL(after.num_bins, before.num_bins);
+
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_MAPPED, "Test saving a dict and using the file in place.")
+{
+    key_t key;
+    test_struct_t* ts;
+    test_struct_t val;
+    char sk[64];
+    int bad = 0;
+
+    // String keys, short and long, with a keyed hash.
+    dict_t* mydict = dict_CreateInlineEx(KEY_STRING, 0, DICT_GROUP, sizeof(test_struct_t));
+    UT_EQUAL(dict_SetHash(mydict, dict_HashSip, 12345), RS_PASS);
+
+    for(int i = 0; i < 3000; i++)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i);
+        key.ks = sk;
+        val.anumber = i;
+        snprintf(val.astring, sizeof(val.astring), "v%d", i);
+        dict_Set(mydict, key, &val);
+    }
+
+    UT_EQUAL(dict_Save(mydict, "dict_str.img"), RS_PASS);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    mydict = dict_OpenMapped("dict_str.img");
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Count(mydict), 3000);
+
+    for(int i = 0; i < 3000; i++)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i);
+        key.ks = sk;
+        snprintf(val.astring, sizeof(val.astring), "v%d", i);
+        bad += (dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == i && strcmp(ts->astring, val.astring) == 0) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    key.ks = "not_there";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+    key.ks = "";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_FAIL);
+
+    // Walk it.
+    int num = 0;
+    UT_EQUAL(dict_IterStart(mydict), RS_PASS);
+    while(dict_IterNext(mydict, &key, (void**)&ts) == RS_PASS)
+    {
+        snprintf(sk, sizeof(sk), ts->anumber % 2 ? "k%d" : "a_much_longer_key_number_%d", ts->anumber);
+        bad += strcmp(key.ks, sk) == 0 ? 0 : 1;
+        num++;
+    }
+    UT_EQUAL(num, 3000);
+    UT_EQUAL(bad, 0);
+
+    list_t* keys = dict_GetKeys(mydict);
+    UT_EQUAL(list_Count(keys), 3000);
+    UT_EQUAL(list_Destroy(keys), RS_PASS);
+
+    // Batches.
+    key_t batch[40];
+    void* values[40];
+    int status[40];
+    std::string names[40];
+    for(int j = 0; j < 40; j++)
+    {
+        names[j] = j % 2 ? "k" + std::to_string(j * 37) : "nope" + std::to_string(j);
+        batch[j].ks = names[j].c_str();
+    }
+    UT_EQUAL(dict_GetMany(mydict, batch, 40, values, status), RS_PASS);
+    for(int j = 0; j < 40; j++)
+    {
+        bad += (j % 2 ? status[j] == RS_PASS && ((test_struct_t*)values[j])->anumber == j * 37 : status[j] == RS_FAIL) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    // Read-only.
+    key.ks = "k1";
+    void** slot;
+    bool inserted;
+    UT_EQUAL(dict_Set(mydict, key, &val), RS_ERR);
+    UT_EQUAL(dict_GetOrInsert(mydict, key, &slot, &inserted), RS_ERR);
+    UT_EQUAL(dict_Remove(mydict, key, (void**)&ts), RS_ERR);
+    UT_EQUAL(dict_Clear(mydict), RS_ERR);
+    UT_EQUAL(dict_Freeze(mydict), RS_PASS);
+
+    // A mapped one can be saved again.
+    UT_EQUAL(dict_Save(mydict, "dict_str2.img"), RS_PASS);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    mydict = dict_OpenMapped("dict_str2.img");
+    UT_NOT_NULL(mydict);
+    key.ks = "a_much_longer_key_number_2998";
+    UT_EQUAL(dict_Get(mydict, key, (void**)&ts), RS_PASS);
+    UT_EQUAL(ts->anumber, 2998);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Int keys, including negative, and empty.
+    mydict = dict_CreateInline(KEY_INT, sizeof(int));
+    for(int i = -500; i < 500; i++)
+    {
+        key.ki = i * 3;
+        int v = i;
+        dict_Set(mydict, key, &v);
+    }
+    UT_EQUAL(dict_Save(mydict, "dict_int.img"), RS_PASS);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    mydict = dict_OpenMapped("dict_int.img");
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Count(mydict), 1000);
+    for(int i = -1500; i < 1500; i++)
+    {
+        key.ki = i;
+        int* pv;
+        int res = dict_Get(mydict, key, (void**)&pv);
+        bad += (i % 3 == 0 ? res == RS_PASS && *pv == i / 3 : res == RS_FAIL) ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    mydict = dict_CreateInline(KEY_INT, sizeof(int));
+    UT_EQUAL(dict_Save(mydict, "dict_empty.img"), RS_PASS);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    mydict = dict_OpenMapped("dict_empty.img");
+    UT_NOT_NULL(mydict);
+    UT_EQUAL(dict_Count(mydict), 0);
+    UT_EQUAL(dict_IterStart(mydict), RS_FAIL);
+    key.ki = 0;
+    int* pv;
+    UT_EQUAL(dict_Get(mydict, key, (void**)&pv), RS_FAIL);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Can't save client pointers.
+    mydict = create_int_dict(DICT_OPEN);
+    UT_EQUAL(dict_Save(mydict, "dict_bad.img"), RS_ERR);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Not images.
+    UT_NULL(dict_OpenMapped("no_such_file.img"));
+    UT_NULL(dict_OpenMapped("hemingway_short.txt"));
+
+    // Cut short.
+    FILE* fp = fopen("dict_int.img", "rb");
+    FILE* fpt = fopen("dict_trunc.img", "wb");
+    char buf[200];
+    fwrite(buf, 1, fread(buf, 1, sizeof(buf), fp), fpt);
+    fclose(fp);
+    fclose(fpt);
+    UT_NULL(dict_OpenMapped("dict_trunc.img"));
+
+    // Section offsets that would wrap around when the section length is added. num_bins is at 32 in the header,
+    // hashes_off, slots_off and values_off at 48, 56 and 64.
+    char image[4096];
+    fp = fopen("dict_empty.img", "rb");
+    size_t len = fread(image, 1, sizeof(image), fp);
+    fclose(fp);
+    unsigned int num_bins;
+    memcpy(&num_bins, image + 32, sizeof(num_bins));
+    for(int field = 0; field < 3; field++)
+    {
+        char patched[sizeof(image)];
+        memcpy(patched, image, len);
+        unsigned long long off = 0 - (unsigned long long)num_bins * 8;
+        memcpy(patched + 48 + field * 8, &off, sizeof(off));
+        fpt = fopen("dict_wrap.img", "wb");
+        fwrite(patched, 1, len, fpt);
+        fclose(fpt);
+        UT_NULL(dict_OpenMapped("dict_wrap.img"));
+    }
+
+    return 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 UT_SUITE(DICT_DUMP, "Test the dump file creation.")
 {
     // string flavor
-    dict_t* mydict = create_str_dict();
+    dict_t* mydict = create_str_dict(DICT_CHAINED);
     UT_NOT_NULL(mydict);
 
     // Dump it.
@@ -134,7 +1768,7 @@ UT_SUITE(DICT_DUMP, "Test the dump file creation.")
     dict_Destroy(mydict);
 
     // int flavor
-    mydict = create_int_dict();
+    mydict = create_int_dict(DICT_CHAINED);
     UT_NOT_NULL(mydict);
 
     // Dump it.
@@ -158,6 +1792,10 @@ UT_SUITE(DICT_ERRORS, "Test some failure situations.")
     UT_EQUAL(dict_Set(baddict, key, value), RS_ERR);
     UT_EQUAL(dict_Dump(baddict, NULL), RS_ERR);
     UT_EQUAL(dict_Get(baddict, key, &value), RS_ERR);
+    UT_EQUAL(dict_Remove(baddict, key, &value), RS_ERR);
+    void** slot;
+    bool inserted;
+    UT_EQUAL(dict_GetOrInsert(baddict, key, &slot, &inserted), RS_ERR);
     UT_NULL(dict_GetKeys(baddict));
     UT_EQUAL(dict_Clear(baddict), RS_ERR);
     UT_EQUAL(dict_Destroy(baddict), RS_ERR);
@@ -166,10 +1804,10 @@ UT_SUITE(DICT_ERRORS, "Test some failure situations.")
 }
 
 /////////////////////////////////////////////////////////////////////////////
-dict_t* create_str_dict(void)
+dict_t* create_str_dict(unsigned int opts)
 {
-    // Make a dict with string key.
-    dict_t* d = dict_Create(KEY_STRING);
+    // Make a dict with string key. Others start small so they have to grow.
+    dict_t* d = opts == DICT_CHAINED ? dict_Create(KEY_STRING) : dict_CreateEx(KEY_STRING, 10, opts);
 
     // Add some values.
     FILE* fp = fopen("hemingway_short.txt", "r");
@@ -228,10 +1866,10 @@ dict_t* create_str_dict(void)
 }
 
 /////////////////////////////////////////////////////////////////////////////
-dict_t* create_int_dict(void)
+dict_t* create_int_dict(unsigned int opts)
 {
-    // Make a dict with int key.
-    dict_t* d = dict_Create(KEY_INT);
+    // Make a dict with int key. Others start small so they have to grow.
+    dict_t* d = opts == DICT_CHAINED ? dict_Create(KEY_INT) : dict_CreateEx(KEY_INT, 10, opts);
 
     // Add some values.
     for(int k = 0; k < 290; k++)
@@ -250,3 +1888,12 @@ dict_t* create_int_dict(void)
 
     return d;
 }
+
+/////////////////////////////////////////////////////////////////////////////
+unsigned long long stats_BadHash(const void* data, size_t len, unsigned long long seed)
+{
+    (void)data;
+    (void)len;
+    (void)seed;
+    return 42;
+}
@@ -0,0 +1,297 @@
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+}
+
+// A value for testing.
+typedef struct
+{
+    int anumber;
+} bulk_struct_t;
+
+// Helpers.
+int load_ParseLine(char* line, key_t* k, void* v, void* ctx);
+int load_ParseBytes(char* line, key_t* k, void* v, void* ctx);
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(DICT_SET_MANY, "Test building a dict from many entries at once.")
+{
+    unsigned int flavors[] = { DICT_CHAINED, DICT_OPEN, DICT_GROUP, DICT_INCREMENTAL, DICT_OPEN | DICT_ARENA, DICT_FILTER };
+    const int NUM_KEYS = 5000;
+    const int NUM_DIFF = 4000; // so some repeat
+    std::vector<std::string> names;
+    std::vector<key_t> keys(NUM_KEYS);
+    char sk[64];
+
+    for(int i = 0; i < NUM_KEYS; i++)
+    {
+        snprintf(sk, sizeof(sk), i % 2 ? "k%d" : "a_much_longer_key_number_%d", i % NUM_DIFF);
+        names.push_back(sk);
+    }
+    for(int i = 0; i < NUM_KEYS; i++)
+    {
+        keys[i].ks = names[i].c_str();
+    }
+
+    for(int f = 0; f < 6; f++)
+    {
+        for(int threads = 1; threads <= 7; threads += 3)
+        {
+            // Some there already.
+            std::map<std::string, int> expect;
+            dict_t* mydict = dict_CreateEx(KEY_STRING, 0, flavors[f]);
+            key_t key;
+            for(int i = 0; i < 100; i++)
+            {
+                snprintf(sk, sizeof(sk), "k%d", i * 7);
+                key.ks = sk;
+                CREATE_INST(st, bulk_struct_t);
+                st->anumber = -i;
+                dict_Set(mydict, key, st);
+                expect[sk] = -i;
+            }
+
+            std::vector<void*> values(NUM_KEYS);
+            for(int i = 0; i < NUM_KEYS; i++)
+            {
+                CREATE_INST(st, bulk_struct_t);
+                st->anumber = i;
+                values[i] = st;
+                expect[names[i]] = i;
+            }
+
+            UT_EQUAL(dict_SetMany(mydict, keys.data(), NUM_KEYS, values.data(), threads), RS_PASS);
+            UT_EQUAL(dict_Count(mydict), (int)expect.size());
+
+            // Later ones won, and the rest can still be added to.
+            int bad = 0;
+            for(auto it = expect.begin(); it != expect.end(); ++it)
+            {
+                bulk_struct_t* ts = NULL;
+                key.ks = it->first.c_str();
+                bad += dict_Get(mydict, key, (void**)&ts) == RS_PASS && ts->anumber == it->second ? 0 : 1;
+            }
+            UT_EQUAL(bad, 0);
+
+            key.ks = "one_more";
+            CREATE_INST(st, bulk_struct_t);
+            UT_EQUAL(dict_Set(mydict, key, st), RS_PASS);
+            UT_EQUAL(dict_Count(mydict), (int)expect.size() + 1);
+            UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+        }
+    }
+
+    // Inline values, int keys.
+    dict_t* mydict = dict_CreateInlineEx(KEY_INT, 0, DICT_GROUP, sizeof(int));
+    std::vector<key_t> ikeys(NUM_KEYS);
+    std::vector<int> ivalues(NUM_KEYS);
+    std::vector<void*> pvalues(NUM_KEYS);
+    for(int i = 0; i < NUM_KEYS; i++)
+    {
+        ikeys[i].ki = i * 3;
+        ivalues[i] = i;
+        pvalues[i] = &ivalues[i];
+    }
+    UT_EQUAL(dict_SetMany(mydict, ikeys.data(), NUM_KEYS, pvalues.data(), 4), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+    int bad = 0;
+    for(int i = 0; i < NUM_KEYS; i++)
+    {
+        int* pi = NULL;
+        bad += dict_Get(mydict, ikeys[i], (void**)&pi) == RS_PASS && *pi == i ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    // Far more threads than entries, then than DICT_MAX_THREADS.
+    UT_EQUAL(dict_SetMany(mydict, ikeys.data(), 10, pvalues.data(), INT_MAX), RS_PASS);
+    UT_EQUAL(dict_SetMany(mydict, ikeys.data(), NUM_KEYS, pvalues.data(), INT_MAX), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+
+    // A NULL value fails the lot.
+    pvalues[10] = NULL;
+    ikeys[0].ki = -1;
+    UT_EQUAL(dict_SetMany(mydict, ikeys.data(), NUM_KEYS, pvalues.data(), 2), RS_ERR);
+    UT_EQUAL(dict_Count(mydict), NUM_KEYS);
+    UT_EQUAL(dict_SetMany(mydict, ikeys.data(), 0, pvalues.data(), 2), RS_PASS);
+    UT_EQUAL(dict_SetMany(mydict, ikeys.data(), 10, pvalues.data(), 0), RS_ERR);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // So does a bytes key too long for an entry.
+    if(sizeof(size_t) > sizeof(unsigned int))
+    {
+        mydict = dict_Create(KEY_BYTES);
+        kbytes_t kb = { "x", (size_t)UINT_MAX + 2 };
+        key_t key;
+        key.kb = &kb;
+        UT_EQUAL(dict_SetMany(mydict, &key, 1, pvalues.data(), 1), RS_ERR);
+        UT_EQUAL(dict_Count(mydict), 0);
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // From a file with a header, windows line ends, a blank line, repeats and no end of line at the end.
+    FILE* fp = fopen("dict_load.csv", "w");
+    fprintf(fp, "name,number\n");
+    for(int i = 0; i < NUM_KEYS; i++)
+    {
+        fprintf(fp, "sensor_%d,%d%s", i % NUM_DIFF, i, i % 5 ? "\n" : "\r\n");
+    }
+    fprintf(fp, "\nsensor_0,-1");
+    fclose(fp);
+
+    for(int inl = 0; inl < 2; inl++)
+    {
+        mydict = inl ? dict_CreateInline(KEY_STRING, sizeof(int)) : dict_Create(KEY_STRING);
+        bool inline_values = inl == 1;
+        UT_EQUAL(dict_LoadFile(mydict, "dict_load.csv", load_ParseLine, &inline_values, 3), RS_PASS);
+        UT_EQUAL(dict_Count(mydict), NUM_DIFF);
+
+        bad = 0;
+        key_t key;
+        for(int i = 0; i < NUM_DIFF; i++)
+        {
+            int* pi = NULL;
+            snprintf(sk, sizeof(sk), "sensor_%d", i);
+            key.ks = sk;
+            int want = i == 0 ? -1 : i + (i < NUM_KEYS - NUM_DIFF ? NUM_DIFF : 0);
+            bad += dict_Get(mydict, key, (void**)&pi) == RS_PASS && *pi == want ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // More threads than lines.
+    mydict = dict_CreateInline(KEY_STRING, sizeof(int));
+    bool inline_values = true;
+    UT_EQUAL(dict_LoadFile(mydict, "dict_load.csv", load_ParseLine, &inline_values, INT_MAX), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), NUM_DIFF);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // Many reads per worker, lines across the reads, and one line longer than a read.
+    const int NUM_LINES = 200000;
+    std::string huge(3 << 20, 'h');
+    fp = fopen("dict_load.csv", "w");
+    for(int i = 0; i < NUM_LINES; i++)
+    {
+        fprintf(fp, "sensor_%d,%d\n", i, i);
+        if(i == NUM_LINES / 2)
+        {
+            fprintf(fp, "%s,-5\n", huge.c_str());
+        }
+    }
+    fclose(fp);
+
+    for(int threads = 1; threads <= 3; threads += 2)
+    {
+        mydict = dict_CreateInlineEx(KEY_STRING, 0, DICT_GROUP, sizeof(int));
+        bool inline_values = true;
+        UT_EQUAL(dict_LoadFile(mydict, "dict_load.csv", load_ParseLine, &inline_values, threads), RS_PASS);
+        UT_EQUAL(dict_Count(mydict), NUM_LINES + 1);
+
+        bad = 0;
+        key_t key;
+        for(int i = 0; i < NUM_LINES; i += 7)
+        {
+            int* pi = NULL;
+            snprintf(sk, sizeof(sk), "sensor_%d", i);
+            key.ks = sk;
+            bad += dict_Get(mydict, key, (void**)&pi) == RS_PASS && *pi == i ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+
+        int* pi = NULL;
+        key.ks = huge.c_str();
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pi), RS_PASS);
+        UT_EQUAL(*pi, -5);
+        UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    }
+
+    // Bytes keys, which the parser gets a kbytes_t for.
+    mydict = dict_CreateInline(KEY_BYTES, sizeof(int));
+    UT_EQUAL(dict_LoadFile(mydict, "dict_load.csv", load_ParseBytes, NULL, 2), RS_PASS);
+    UT_EQUAL(dict_Count(mydict), NUM_LINES + 1);
+    {
+        int* pi = NULL;
+        kbytes_t kb = { "sensor_1234", 11 };
+        key_t key;
+        key.kb = &kb;
+        UT_EQUAL(dict_Get(mydict, key, (void**)&pi), RS_PASS);
+        UT_EQUAL(*pi, 1234);
+    }
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+
+    // A line the parser doesn't like. Values already parsed are freed.
+    fp = fopen("dict_load.csv", "a");
+    fprintf(fp, "not a pair\n");
+    fclose(fp);
+    mydict = dict_Create(KEY_STRING);
+    inline_values = false;
+    UT_EQUAL(dict_LoadFile(mydict, "dict_load.csv", load_ParseLine, &inline_values, 2), RS_ERR);
+    UT_EQUAL(dict_Count(mydict), 0);
+    UT_EQUAL(dict_LoadFile(mydict, "no_such_file.csv", load_ParseLine, &inline_values, 2), RS_ERR);
+    UT_EQUAL(dict_Destroy(mydict), RS_PASS);
+    remove("dict_load.csv");
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+int load_ParseLine(char* line, key_t* k, void* v, void* ctx)
+{
+    // name,number
+    char* comma = strchr(line, ',');
+    if(line[0] == 0 || strncmp(line, "name,", 5) == 0)
+    {
+        return RS_FAIL;
+    }
+    if(comma == NULL)
+    {
+        return RS_ERR;
+    }
+
+    *comma = 0;
+    k->ks = line;
+
+    if(*(bool*)ctx)
+    {
+        *(int*)v = atoi(comma + 1);
+    }
+    else
+    {
+        CREATE_INST(pi, int);
+        *pi = atoi(comma + 1);
+        *(void**)v = pi;
+    }
+
+    return RS_PASS;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+int load_ParseBytes(char* line, key_t* k, void* v, void* ctx)
+{
+    // name,number with the name as bytes, so no need to terminate it.
+    (void)ctx;
+    char* comma = strchr(line, ',');
+    if(comma == NULL)
+    {
+        return RS_ERR;
+    }
+
+    kbytes_t* kb = (kbytes_t*)k->kb;
+    kb->data = line;
+    kb->len = (size_t)(comma - line);
+    *(int*)v = atoi(comma + 1);
+
+    return RS_PASS;
+}
@@ -0,0 +1,205 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "omap.h"
+}
+
+// Helpers.
+static int* omap_Value(int i);
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(OMAP_INT, "Test omap with int keys against std::map.")
+{
+    omap_t* m = omap_Create(KEY_INT);
+    UT_NOT_NULL(m);
+    std::map<int, int> ref;
+    key_t k;
+    void* v;
+    int bad = 0;
+
+    // Enough to make a few levels, then remove most of it to make them go again.
+    srand(99);
+    for(int round = 0; round < 2; round++)
+    {
+        for(int i = 0; i < 50000; i++)
+        {
+            k.ki = rand() % 20000 - 10000;
+
+            if(rand() % (round == 0 ? 4 : 2) == 0)
+            {
+                bool was = ref.erase(k.ki) > 0;
+                int res = omap_Remove(m, k, &v);
+                bad += res == (was ? RS_PASS : RS_FAIL) ? 0 : 1;
+                if(res == RS_PASS)
+                {
+                    bad += *(int*)v == k.ki * 3 ? 0 : 1;
+                    FREE(v);
+                }
+            }
+            else
+            {
+                ref[k.ki] = k.ki * 3;
+                omap_Set(m, k, omap_Value(k.ki * 3));
+            }
+        }
+
+        UT_EQUAL(bad, 0);
+        UT_EQUAL(omap_Count(m), (int)ref.size());
+
+        // Everything, in order.
+        auto it = ref.begin();
+        UT_EQUAL(omap_IterStart(m, NULL, NULL), RS_PASS);
+        while(omap_IterNext(m, &k, &v) == RS_PASS)
+        {
+            bad += it != ref.end() && it->first == k.ki && it->second == *(int*)v ? 0 : 1;
+            ++it;
+        }
+        bad += it == ref.end() ? 0 : 1;
+        UT_EQUAL(bad, 0);
+
+        for(int i = -10001; i < 10001; i++)
+        {
+            k.ki = i;
+            bool there = ref.count(i) > 0;
+            bad += omap_Get(m, k, &v) == (there ? RS_PASS : RS_FAIL) ? 0 : 1;
+            bad += !there || *(int*)v == i * 3 ? 0 : 1;
+        }
+        UT_EQUAL(bad, 0);
+    }
+
+    // Ranges, including bounds that are not keys.
+    int ranges[][2] = { { -500, 500 }, { -10001, -9990 }, { 9990, 20000 }, { 7, 8 }, { 100, 100 }, { 30000, 40000 } };
+    for(int r = 0; r < 6; r++)
+    {
+        key_t lo = { ranges[r][0] };
+        key_t hi = { ranges[r][1] };
+        auto it = ref.lower_bound(lo.ki);
+        auto end = ref.lower_bound(hi.ki);
+        int res = omap_IterStart(m, &lo, &hi);
+        bad += res == (it != end ? RS_PASS : RS_FAIL) ? 0 : 1;
+        while(omap_IterNext(m, &k, &v) == RS_PASS)
+        {
+            bad += it != end && it->first == k.ki ? 0 : 1;
+            ++it;
+        }
+        bad += it == end ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    // Open at one end.
+    key_t lo = { 9000 };
+    int n = 0;
+    omap_IterStart(m, &lo, NULL);
+    while(omap_IterNext(m, &k, &v) == RS_PASS)
+    {
+        n++;
+    }
+    UT_EQUAL(n, (int)std::distance(ref.lower_bound(9000), ref.end()));
+
+    UT_EQUAL(omap_Clear(m), RS_PASS);
+    UT_EQUAL(omap_Count(m), 0);
+    UT_EQUAL(omap_IterStart(m, NULL, NULL), RS_FAIL);
+    UT_EQUAL(omap_IterNext(m, &k, &v), RS_FAIL);
+    UT_EQUAL(omap_Destroy(m), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(OMAP_STRING, "Test omap with string keys.")
+{
+    omap_t* m = omap_Create(KEY_STRING);
+    key_t k;
+    void* v;
+    char buff[32];
+    int bad = 0;
+
+    // Backwards so every insert goes at the front.
+    for(int i = 999; i >= 0; i--)
+    {
+        snprintf(buff, sizeof(buff), "sensor%03d", i);
+        k.ks = buff;
+        bad += omap_Set(m, k, omap_Value(i)) == RS_PASS ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(omap_Count(m), 1000);
+
+    // Replace frees the old one.
+    k.ks = "sensor500";
+    UT_EQUAL(omap_Set(m, k, omap_Value(-500)), RS_PASS);
+    UT_EQUAL(omap_Count(m), 1000);
+    UT_EQUAL(omap_Get(m, k, &v), RS_PASS);
+    UT_EQUAL(*(int*)v, -500);
+
+    // Prefix as a range.
+    key_t lo;
+    key_t hi;
+    lo.ks = "sensor12";
+    hi.ks = "sensor13";
+    std::string got;
+    UT_EQUAL(omap_IterStart(m, &lo, &hi), RS_PASS);
+    while(omap_IterNext(m, &k, &v) == RS_PASS)
+    {
+        got += std::string(k.ks) + ",";
+    }
+    UT_STR_EQUAL(got.c_str(), "sensor120,sensor121,sensor122,sensor123,sensor124,sensor125,sensor126,sensor127,sensor128,sensor129,");
+
+    // Removed keys may still be separators inside.
+    for(int i = 0; i < 1000; i += 2)
+    {
+        snprintf(buff, sizeof(buff), "sensor%03d", i);
+        k.ks = buff;
+        bad += omap_Remove(m, k, &v) == RS_PASS ? 0 : 1;
+        FREE(v);
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(omap_Count(m), 500);
+    k.ks = "sensor500";
+    UT_EQUAL(omap_Get(m, k, &v), RS_FAIL);
+    UT_EQUAL(omap_Remove(m, k, &v), RS_FAIL);
+    k.ks = "sensor501";
+    UT_EQUAL(omap_Get(m, k, &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 501);
+
+    got.clear();
+    UT_EQUAL(omap_IterStart(m, &lo, &hi), RS_PASS);
+    while(omap_IterNext(m, &k, &v) == RS_PASS)
+    {
+        got += std::string(k.ks) + ",";
+    }
+    UT_STR_EQUAL(got.c_str(), "sensor121,sensor123,sensor125,sensor127,sensor129,");
+
+    lo.ks = "z";
+    UT_EQUAL(omap_IterStart(m, &lo, NULL), RS_FAIL);
+
+    k.ks = NULL;
+    UT_EQUAL(omap_Set(m, k, &v), RS_ERR);
+    k.ks = "x";
+    UT_EQUAL(omap_Set(m, k, NULL), RS_ERR);
+    UT_EQUAL(omap_Count(NULL), RS_ERR);
+
+    // KEY_U64 and KEY_BYTES are only for dict.
+    UT_NULL(omap_Create(KEY_U64));
+    UT_NULL(omap_Create(KEY_BYTES));
+
+    UT_EQUAL(omap_Destroy(m), RS_PASS);
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int* omap_Value(int i)
+{
+    CREATE_INST(pi, int);
+    *pi = i;
+    return pi;
+}
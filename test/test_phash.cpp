@@ -0,0 +1,152 @@
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "phash.h"
+
+// Made by phash_gen from files/phash_cmds.txt.
+extern const phash_t test_cmds;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(PHASH_GEN, "Test a table generated at build time.")
+{
+    const char* cmds[] = { "help", "quit", "open", "close", "save", "find", "replace", "goto", "undo", "redo",
+                           "say\"hi", "back\\slash", "no_value" };
+    key_t key;
+    void* v;
+
+    UT_EQUAL(phash_Count(&test_cmds), 13);
+
+    // Index is the line, values are what the file says.
+    for(int i = 0; i < 13; i++)
+    {
+        key.ks = cmds[i];
+        UT_EQUAL(phash_Index(&test_cmds, key), i);
+    }
+
+    key.ks = "replace";
+    UT_EQUAL(phash_Get(&test_cmds, key, &v), RS_PASS);
+    UT_STR_EQUAL((const char*)v, "Replace text");
+    key.ks = "say\"hi";
+    UT_EQUAL(phash_Get(&test_cmds, key, &v), RS_PASS);
+    UT_STR_EQUAL((const char*)v, "Quote in the key");
+    key.ks = "no_value";
+    UT_EQUAL(phash_Get(&test_cmds, key, &v), RS_PASS);
+    UT_NULL(v);
+
+    key.ks = "hel";
+    UT_EQUAL(phash_Get(&test_cmds, key, &v), RS_FAIL);
+    UT_EQUAL(phash_Index(&test_cmds, key), RS_FAIL);
+    key.ks = "";
+    UT_EQUAL(phash_Index(&test_cmds, key), RS_FAIL);
+
+    // Not ours to free.
+    UT_EQUAL(phash_Destroy((phash_t*)&test_cmds), RS_ERR);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(PHASH_BUILD, "Test tables built at run time.")
+{
+    // Every distinct word in a book.
+    std::set<std::string> uniq;
+    std::string word;
+    FILE* fp = fopen("hemingway.txt", "r");
+    UT_NOT_NULL(fp);
+    for(int c = fgetc(fp); c != EOF; c = fgetc(fp))
+    {
+        if(isalpha(c))
+        {
+            word += (char)c;
+        }
+        else if(!word.empty())
+        {
+            uniq.insert(word);
+            word.clear();
+        }
+    }
+    fclose(fp);
+
+    std::vector<std::string> words(uniq.begin(), uniq.end());
+    std::vector<key_t> keys(words.size());
+    std::vector<void*> values(words.size());
+    for(size_t i = 0; i < words.size(); i++)
+    {
+        keys[i].ks = words[i].c_str();
+        values[i] = &words[i];
+    }
+
+    phash_t* ph = phash_Build(KEY_STRING, keys.data(), values.data(), (int)keys.size());
+    UT_NOT_NULL(ph);
+    UT_EQUAL(phash_Count(ph), (int)words.size());
+
+    int bad = 0;
+    key_t key;
+    void* v;
+    for(size_t i = 0; i < words.size(); i++)
+    {
+        bad += phash_Index(ph, keys[i]) == (int)i ? 0 : 1;
+        bad += phash_Get(ph, keys[i], &v) == RS_PASS && v == &words[i] ? 0 : 1;
+
+        // Not there.
+        std::string miss = words[i] + "_x";
+        key.ks = miss.c_str();
+        bad += phash_Get(ph, key, &v) == RS_FAIL ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+
+    // Generated source has every key.
+    fp = fopen("phash_words.c", "w");
+    UT_EQUAL(phash_Write(ph, "words", NULL, fp), RS_PASS);
+    fclose(fp);
+    UT_EQUAL(phash_Destroy(ph), RS_PASS);
+
+    // Int keys, no values.
+    std::vector<key_t> ikeys(1000);
+    for(int i = 0; i < 1000; i++)
+    {
+        ikeys[i].ki = i * i - 5000;
+    }
+    ph = phash_Build(KEY_INT, ikeys.data(), NULL, 1000);
+    UT_NOT_NULL(ph);
+    for(int i = -6000; i < 1000000; i += 7)
+    {
+        key.ki = i;
+        int idx = phash_Index(ph, key);
+        bad += (idx == RS_FAIL || ikeys[idx].ki == i) ? 0 : 1;
+    }
+    for(int i = 0; i < 1000; i++)
+    {
+        bad += phash_Index(ph, ikeys[i]) == i ? 0 : 1;
+        bad += phash_Get(ph, ikeys[i], &v) == RS_PASS && v == NULL ? 0 : 1;
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(phash_Destroy(ph), RS_PASS);
+
+    // One key.
+    key.ki = 42;
+    ph = phash_Build(KEY_INT, &key, NULL, 1);
+    UT_NOT_NULL(ph);
+    UT_EQUAL(phash_Index(ph, key), 0);
+    key.ki = 43;
+    UT_EQUAL(phash_Index(ph, key), RS_FAIL);
+    UT_EQUAL(phash_Destroy(ph), RS_PASS);
+
+    // Can't be done.
+    UT_NULL(phash_Build(KEY_INT, ikeys.data(), NULL, 0));
+    ikeys[500].ki = ikeys[3].ki;
+    UT_NULL(phash_Build(KEY_INT, ikeys.data(), NULL, 1000));
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "radix.h"
+}
+
+// Helpers.
+static int* radix_Value(int i);
+static std::string radix_Walk(radix_t* t, const char* prefix);
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(RADIX_BASIC, "Test radix set, get, remove.")
+{
+    radix_t* t = radix_Create();
+    UT_NOT_NULL(t);
+    void* v;
+
+    // Keys that split and share labels.
+    const char* keys[] = { "romane", "romanus", "romulus", "rubens", "ruber", "rubicon", "rubicundus", "rom", "r", "" };
+    for(int i = 0; i < 10; i++)
+    {
+        UT_EQUAL(radix_Set(t, keys[i], radix_Value(i)), RS_PASS);
+    }
+    UT_EQUAL(radix_Count(t), 10);
+
+    for(int i = 0; i < 10; i++)
+    {
+        UT_EQUAL(radix_Get(t, keys[i], &v), RS_PASS);
+        UT_EQUAL(*(int*)v, i);
+    }
+
+    // In between and beyond.
+    UT_EQUAL(radix_Get(t, "ro", &v), RS_FAIL);
+    UT_EQUAL(radix_Get(t, "roman", &v), RS_FAIL);
+    UT_EQUAL(radix_Get(t, "romanes", &v), RS_FAIL);
+    UT_EQUAL(radix_Get(t, "rx", &v), RS_FAIL);
+    UT_EQUAL(radix_Get(t, "x", &v), RS_FAIL);
+
+    // Replace frees the old one.
+    UT_EQUAL(radix_Set(t, "ruber", radix_Value(100)), RS_PASS);
+    UT_EQUAL(radix_Count(t), 10);
+    UT_EQUAL(radix_Get(t, "ruber", &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 100);
+
+    // Remove gives the value back. Take out keys that cause merges.
+    UT_EQUAL(radix_Remove(t, "rom", &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 7);
+    FREE(v);
+    UT_EQUAL(radix_Remove(t, "romulus", &v), RS_PASS);
+    FREE(v);
+    UT_EQUAL(radix_Remove(t, "romulus", &v), RS_FAIL);
+    UT_EQUAL(radix_Remove(t, "rub", &v), RS_FAIL);
+    UT_EQUAL(radix_Count(t), 8);
+    UT_EQUAL(radix_Get(t, "romanus", &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 1);
+    UT_EQUAL(radix_Get(t, "rubicundus", &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 6);
+
+    UT_EQUAL(radix_Remove(t, "", &v), RS_PASS);
+    FREE(v);
+    UT_EQUAL(radix_Get(t, "", &v), RS_FAIL);
+    UT_EQUAL(radix_Count(t), 7);
+
+    // Put one back where a merge happened.
+    UT_EQUAL(radix_Set(t, "roma", radix_Value(7)), RS_PASS);
+    UT_EQUAL(radix_Get(t, "roma", &v), RS_PASS);
+    UT_EQUAL(radix_Get(t, "romane", &v), RS_PASS);
+    UT_EQUAL(*(int*)v, 0);
+
+    UT_EQUAL(radix_Set(t, NULL, &v), RS_ERR);
+    UT_EQUAL(radix_Set(t, "a", NULL), RS_ERR);
+    UT_EQUAL(radix_Count(NULL), RS_ERR);
+
+    UT_EQUAL(radix_Clear(t), RS_PASS);
+    UT_EQUAL(radix_Count(t), 0);
+    UT_EQUAL(radix_Get(t, "romane", &v), RS_FAIL);
+    UT_EQUAL(radix_IterStart(t, ""), RS_FAIL);
+
+    UT_EQUAL(radix_Destroy(t), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(RADIX_PREFIX, "Test radix prefix walks.")
+{
+    radix_t* t = radix_Create();
+    const char* keys[] = { "plant/line1/motor1/temp", "plant/line1/motor1/rpm", "plant/line1/motor2/temp",
+                           "plant/line2/motor1/temp", "plant/line10/pump/flow", "plant", "office/hvac" };
+    for(int i = 0; i < 7; i++)
+    {
+        radix_Set(t, keys[i], radix_Value(i));
+    }
+
+    // Sorted, whole keys.
+    UT_STR_EQUAL(radix_Walk(t, "plant/line1/").c_str(), "plant/line1/motor1/rpm,plant/line1/motor1/temp,plant/line1/motor2/temp,");
+    UT_STR_EQUAL(radix_Walk(t, "plant/line1").c_str(),
+                 "plant/line1/motor1/rpm,plant/line1/motor1/temp,plant/line1/motor2/temp,plant/line10/pump/flow,");
+    // Ends part way into a label.
+    UT_STR_EQUAL(radix_Walk(t, "plant/line1/mo").c_str(), "plant/line1/motor1/rpm,plant/line1/motor1/temp,plant/line1/motor2/temp,");
+    UT_STR_EQUAL(radix_Walk(t, "o").c_str(), "office/hvac,");
+    UT_STR_EQUAL(radix_Walk(t, "plant").c_str(),
+                 "plant,plant/line1/motor1/rpm,plant/line1/motor1/temp,plant/line1/motor2/temp,plant/line10/pump/flow,plant/line2/motor1/temp,");
+    UT_STR_EQUAL(radix_Walk(t, "office/hvac").c_str(), "office/hvac,");
+    UT_STR_EQUAL(radix_Walk(t, "plant/line3").c_str(), "");
+    UT_STR_EQUAL(radix_Walk(t, "office/hvacs").c_str(), "");
+    UT_STR_EQUAL(radix_Walk(t, "plant/lime").c_str(), "");
+
+    UT_EQUAL(radix_IterStart(t, "plant/line3"), RS_FAIL);
+    const char* key;
+    void* v;
+    UT_EQUAL(radix_IterNext(t, &key, &v), RS_FAIL);
+
+    radix_Destroy(t);
+
+    // Against a std::map with random keys and removes.
+    t = radix_Create();
+    std::map<std::string, int> ref;
+    int bad = 0;
+    srand(1234);
+    for(int i = 0; i < 20000; i++)
+    {
+        std::string k;
+        int len = rand() % 8;
+        for(int j = 0; j < len; j++)
+        {
+            k += (char)('a' + rand() % 4);
+        }
+
+        void* old;
+        if(rand() % 3 == 0)
+        {
+            bool was = ref.erase(k) > 0;
+            int res = radix_Remove(t, k.c_str(), &old);
+            bad += res == (was ? RS_PASS : RS_FAIL) ? 0 : 1;
+            if(res == RS_PASS)
+            {
+                FREE(old);
+            }
+        }
+        else
+        {
+            ref[k] = i;
+            radix_Set(t, k.c_str(), radix_Value(i));
+        }
+    }
+    UT_EQUAL(bad, 0);
+    UT_EQUAL(radix_Count(t), (int)ref.size());
+
+    const char* prefixes[] = { "", "a", "ab", "abc", "dd", "cab", "abcdabcd" };
+    for(int p = 0; p < 7; p++)
+    {
+        std::string want;
+        for(auto it = ref.lower_bound(prefixes[p]); it != ref.end() && it->first.compare(0, strlen(prefixes[p]), prefixes[p]) == 0; ++it)
+        {
+            want += it->first + "=" + std::to_string(it->second) + ",";
+        }
+
+        std::string got;
+        if(radix_IterStart(t, prefixes[p]) == RS_PASS)
+        {
+            while(radix_IterNext(t, &key, &v) == RS_PASS)
+            {
+                got += std::string(key) + "=" + std::to_string(*(int*)v) + ",";
+            }
+        }
+        UT_STR_EQUAL(got.c_str(), want.c_str());
+    }
+
+    radix_Destroy(t);
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int* radix_Value(int i)
+{
+    CREATE_INST(pi, int);
+    *pi = i;
+    return pi;
+}
+
+//---------------------------------------------------------------------------
+std::string radix_Walk(radix_t* t, const char* prefix)
+{
+    std::string s;
+    const char* key;
+    void* v;
+
+    if(radix_IterStart(t, prefix) == RS_PASS)
+    {
+        while(radix_IterNext(t, &key, &v) == RS_PASS)
+        {
+            s += std::string(key) + ",";
+        }
+    }
+
+    return s;
+}
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "pnut.h"
+
+extern "C"
+{
+#include "common.h"
+#include "dict.h"
+#include "snap.h"
+}
+
+// Helpers.
+dict_t* snap_MakeVersion(int version, int num_keys);
+
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(SNAP_BASIC, "Test snapshot publish and acquire from one thread.")
+{
+    UT_NULL(snap_Create(0));
+
+    snap_t* s = snap_Create(2);
+    UT_NOT_NULL(s);
+
+    // Only two readers.
+    int r0 = snap_Register(s);
+    int r1 = snap_Register(s);
+    UT_EQUAL(r0, 0);
+    UT_EQUAL(r1, 1);
+    UT_EQUAL(snap_Register(s), RS_ERR);
+    UT_EQUAL(snap_Unregister(s, r1), RS_PASS);
+    UT_EQUAL(snap_Unregister(s, r1), RS_ERR);
+    UT_NULL(snap_Acquire(s, r1));
+    UT_NULL(snap_Acquire(s, 5));
+
+    // Nothing yet.
+    UT_NULL(snap_Acquire(s, r0));
+    UT_EQUAL(snap_Release(s, r0), RS_PASS);
+
+    UT_EQUAL(snap_Publish(s, snap_MakeVersion(1, 100)), RS_PASS);
+
+    dict_t* d = snap_Acquire(s, r0);
+    UT_NOT_NULL(d);
+    UT_EQUAL(dict_Count(d), 100);
+
+    // Readers can't change it.
+    key_t key;
+    int* pv;
+    key.ki = 5;
+    UT_EQUAL(dict_Get(d, key, (void**)&pv), RS_PASS);
+    UT_EQUAL(*pv, 1);
+    int v = 99;
+    UT_EQUAL(dict_Set(d, key, &v), RS_ERR);
+    UT_EQUAL(dict_Remove(d, key, (void**)&pv), RS_ERR);
+    UT_EQUAL(dict_Clear(d), RS_ERR);
+    UT_EQUAL(snap_Release(s, r0), RS_PASS);
+
+    // Replace. The old one is gone once nobody holds it.
+    UT_EQUAL(snap_Publish(s, snap_MakeVersion(2, 50)), RS_PASS);
+    d = snap_Acquire(s, r0);
+    UT_EQUAL(dict_Count(d), 50);
+    UT_EQUAL(dict_Get(d, key, (void**)&pv), RS_PASS);
+    UT_EQUAL(*pv, 2);
+    UT_EQUAL(snap_Release(s, r0), RS_PASS);
+
+    UT_EQUAL(snap_Unregister(s, r0), RS_PASS);
+    UT_EQUAL(snap_Destroy(s), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+UT_SUITE(SNAP_THREADS, "Test readers while new versions get published.")
+{
+    const int NUM_READERS = 4;
+    const int NUM_VERSIONS = 30;
+    const int NUM_KEYS = 2000;
+
+    snap_t* s = snap_Create(NUM_READERS);
+    UT_EQUAL(snap_Publish(s, snap_MakeVersion(0, NUM_KEYS)), RS_PASS);
+
+    std::atomic<int> bad(0);
+    std::atomic<int> reads(0);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+
+    for(int r = 0; r < NUM_READERS; r++)
+    {
+        threads.emplace_back([s, &bad, &reads, &stop]()
+        {
+            int id = snap_Register(s);
+            int last = 0;
+            key_t key;
+            int* pv;
+
+            while(!stop)
+            {
+                // Every key of a version has that version, and versions never go backwards.
+                dict_t* d = snap_Acquire(s, id);
+                key.ki = 0;
+                dict_Get(d, key, (void**)&pv);
+                int version = *pv;
+                bad += version >= last ? 0 : 1;
+                last = version;
+
+                for(int i = 0; i < NUM_KEYS; i += 7)
+                {
+                    key.ki = i;
+                    bad += (dict_Get(d, key, (void**)&pv) == RS_PASS && *pv == version) ? 0 : 1;
+                }
+                snap_Release(s, id);
+                reads++;
+            }
+
+            snap_Unregister(s, id);
+        });
+    }
+
+    for(int v = 1; v <= NUM_VERSIONS; v++)
+    {
+        UT_EQUAL(snap_Publish(s, snap_MakeVersion(v, NUM_KEYS)), RS_PASS);
+        std::this_thread::yield();
+    }
+
+    stop = true;
+    for(size_t t = 0; t < threads.size(); t++)
+    {
+        threads[t].join();
+    }
+
+    UT_EQUAL(bad.load(), 0);
+    UT_TRUE(reads.load() > 0);
+    UT_EQUAL(snap_Destroy(s), RS_PASS);
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+dict_t* snap_MakeVersion(int version, int num_keys)
+{
+    // Built like a real one would be, growing as it goes.
+    dict_t* d = dict_CreateInlineEx(KEY_INT, 0, DICT_GROUP, sizeof(int));
+    key_t key;
+
+    for(int i = 0; i < num_keys; i++)
+    {
+        key.ki = i;
+        dict_Set(d, key, &version);
+    }
+
+    return d;
+}
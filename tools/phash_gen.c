@@ -0,0 +1,212 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "list.h"
+#include "dict.h"
+#include "phash.h"
+
+
+/// @brief Build step that turns a key list into C source for a const phash_t.
+/// Usage: phash_gen [-i] [-h header]... keys_file out_file name
+///   -i          Keys are ints, otherwise strings.
+///   -h header   Include this in the output, for things the values refer to. Repeatable.
+/// The key file has one key per line. Anything after the first tab is a C constant expression for
+/// the value of that key. Blank lines and lines starting with # are skipped.
+
+
+//---------------- Private Declarations ------------------//
+
+/// Longest line in the key file.
+#define GEN_LINE_LEN 1024
+
+/// Copy a string.
+/// @param s The string.
+/// @return The copy.
+static char* p_Dup(const char* s);
+
+
+//--------------------------------------------------------//
+int main(int argc, char* argv[])
+{
+    keyType_t kt = KEY_STRING;
+    const char* headers[16];
+    int num_headers = 0;
+    int arg = 1;
+
+    for(; arg < argc && argv[arg][0] == '-'; arg++)
+    {
+        if(strcmp(argv[arg], "-i") == 0)
+        {
+            kt = KEY_INT;
+        }
+        else if(strcmp(argv[arg], "-h") == 0 && arg + 1 < argc && num_headers < 16)
+        {
+            headers[num_headers++] = argv[++arg];
+        }
+        else
+        {
+            arg = argc;
+        }
+    }
+
+    if(argc - arg != 3)
+    {
+        fprintf(stderr, "Usage: phash_gen [-i] [-h header]... keys_file out_file name\n");
+        return 1;
+    }
+
+    FILE* fp = fopen(argv[arg], "r");
+    if(fp == NULL)
+    {
+        fprintf(stderr, "phash_gen: can't open %s\n", argv[arg]);
+        return 1;
+    }
+
+    // Read the keys and values.
+    list_t* keys = list_Create();
+    list_t* exprs = list_Create();
+    dict_t* seen = dict_CreateInline(kt, sizeof(int));
+    bool any_value = false;
+    char line[GEN_LINE_LEN];
+    int line_num = 0;
+    int ret = 0;
+
+    while(fgets(line, sizeof(line), fp) != NULL && ret == 0)
+    {
+        line_num++;
+        line[strcspn(line, "\r\n")] = 0;
+
+        if(line[0] == 0 || line[0] == '#')
+        {
+            continue;
+        }
+
+        char* tab = strchr(line, '\t');
+        if(tab != NULL)
+        {
+            *tab = 0;
+            any_value = true;
+        }
+
+        char* end = line;
+        if(kt == KEY_INT)
+        {
+            strtol(line, &end, 0);
+        }
+
+        if(kt == KEY_INT && (end == line || *end != 0))
+        {
+            fprintf(stderr, "phash_gen: %s:%d: bad int key %s\n", argv[arg], line_num, line);
+            ret = 1;
+        }
+        else
+        {
+            // Remember where each key was first seen so a duplicate can point at both.
+            key_t k;
+            if(kt == KEY_INT)
+            {
+                k.ki = (int)strtol(line, NULL, 0);
+            }
+            else
+            {
+                k.ks = line;
+            }
+
+            void** slot;
+            bool inserted;
+            dict_GetOrInsert(seen, k, &slot, &inserted);
+
+            if(!inserted)
+            {
+                fprintf(stderr, "phash_gen: %s:%d: duplicate key %s, first on line %d\n", argv[arg], line_num, line, *(int*)slot);
+                ret = 1;
+            }
+            else
+            {
+                *(int*)slot = line_num;
+                list_Append(keys, p_Dup(line));
+                list_Append(exprs, tab != NULL ? p_Dup(tab + 1) : p_Dup(""));
+            }
+        }
+    }
+
+    fclose(fp);
+    dict_Destroy(seen);
+
+    // Into arrays for phash_Build().
+    int n = list_Count(keys);
+    CREATE_ARR(karr, key_t, n > 0 ? n : 1);
+    CREATE_ARR(earr, const char*, n > 0 ? n : 1);
+    char* ks;
+    char* expr;
+
+    list_IterStart(keys);
+    list_IterStart(exprs);
+    for(int i = 0; list_IterNext(keys, (void**)&ks) == RS_PASS && list_IterNext(exprs, (void**)&expr) == RS_PASS; i++)
+    {
+        if(kt == KEY_INT)
+        {
+            karr[i].ki = (int)strtol(ks, NULL, 0);
+        }
+        else
+        {
+            karr[i].ks = ks;
+        }
+        earr[i] = expr[0] != 0 ? expr : NULL;
+    }
+
+    if(ret == 0 && n == 0)
+    {
+        fprintf(stderr, "phash_gen: %s has no keys\n", argv[arg]);
+        ret = 1;
+    }
+
+    // The keys are known to be distinct by now, so a failure means no seed gave every key a slot of its own.
+    phash_t* ph = ret == 0 ? phash_Build(kt, karr, NULL, n) : BAD_PTR;
+
+    if(ret == 0 && ph == BAD_PTR)
+    {
+        fprintf(stderr, "phash_gen: could not place the keys of %s\n", argv[arg]);
+        ret = 1;
+    }
+
+    if(ret == 0)
+    {
+        FILE* out = fopen(argv[arg + 1], "w");
+
+        if(out == NULL)
+        {
+            fprintf(stderr, "phash_gen: can't create %s\n", argv[arg + 1]);
+            ret = 1;
+        }
+        else
+        {
+            for(int h = 0; h < num_headers; h++)
+            {
+                fprintf(out, "#include \"%s\"\n", headers[h]);
+            }
+
+            ret = phash_Write(ph, argv[arg + 2], any_value ? earr : NULL, out) == RS_PASS ? 0 : 1;
+            ret = fclose(out) == 0 ? ret : 1;
+        }
+
+        phash_Destroy(ph);
+    }
+
+    FREE(karr);
+    FREE(earr);
+    list_Destroy(keys);
+    list_Destroy(exprs);
+
+    return ret;
+}
+
+//--------------------------------------------------------//
+char* p_Dup(const char* s)
+{
+    CREATE_STR(d, strlen(s));
+    strcpy(d, s);
+    return d;
+}